@@ -0,0 +1,414 @@
+// Timestamp provider benchmark
+//
+// Drives the providers in rq/timestamp_provider.h directly (the same classes the
+// RQ providers hold by value) to qualify a machine before using a TSC-backed
+// clock for range queries. For each provider and thread count it reports:
+//  - throughput (calls per second, all threads);
+//  - a per-call latency histogram in cycles (log2 buckets);
+//  - cross-thread monotonicity violations: every -check calls a thread reads the
+//    value last published by any thread (returned by a call that has already
+//    completed), makes a call, and counts a violation if its value is smaller;
+//  - cache line transfers, approximated by L1D read misses per call (the loop
+//    only touches thread-private data and the provider, so nearly every miss is
+//    a shared line of the provider being pulled from another core). Needs
+//    perf_event_open; reported as n/a if it is not allowed.
+// The topology (packages, cores, hyperthreads) is read from sysfs.
+
+#include <linux/perf_event.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "timestamp_provider.h"
+
+#define HISTOGRAM_BUCKETS 64
+
+enum op_t { OP_READ, OP_ADVANCE, OP_SNAPSHOT };
+enum pin_t { PIN_COMPACT, PIN_SCATTER, PIN_NONE };
+
+struct cpu_t {
+    int cpu;
+    int package;
+    int core;
+};
+
+struct config_t {
+    std::vector<std::string> providers;
+    std::vector<int> threadCounts;
+    int millis;
+    op_t op;
+    pin_t pin;
+    int check;
+    bool histogram;
+};
+
+union thread_result_t {
+    struct {
+        long long calls;
+        long long violations;
+        long long maxViolation;
+        long long l1dMisses;    // -1 if not available
+        long long histogram[HISTOGRAM_BUCKETS];
+    } data;
+    volatile char bytes[PREFETCH_SIZE_BYTES * 4];
+} __attribute__((aligned(BYTES_IN_CACHE_LINE)));
+
+config_t cfg;
+std::vector<cpu_t> order;          // cpus in the order threads are pinned to them
+
+volatile char padding0[PREFETCH_SIZE_BYTES];
+std::atomic<int> running;
+std::atomic<bool> start;
+std::atomic<bool> stop;
+volatile char padding1[PREFETCH_SIZE_BYTES];
+std::atomic<timestamp_t> published;   // a value returned by some completed call
+volatile char padding2[PREFETCH_SIZE_BYTES];
+
+static int readSysfsInt(const int cpu, const char *file, const int fallback) {
+    char path[256];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/%s", cpu, file);
+    std::ifstream in(path);
+    int value;
+    if (in >> value) return value;
+    return fallback;
+}
+
+// compact: fill one package at a time, first one hyperthread per core, then the
+//          siblings (the "atomic_v2" order of timestamp.cpp)
+// scatter: round-robin over packages, one hyperthread per core first
+static void computeOrder(const pin_t pin) {
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    sched_getaffinity(0, sizeof(allowed), &allowed);
+    std::vector<cpu_t> cpus;
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (!CPU_ISSET(cpu, &allowed)) continue;
+        cpu_t c;
+        c.cpu = cpu;
+        c.package = readSysfsInt(cpu, "physical_package_id", 0);
+        c.core = readSysfsInt(cpu, "core_id", cpu);
+        cpus.push_back(c);
+    }
+    // rank of each cpu among the hyperthreads of its core
+    std::vector<int> rank(cpus.size(), 0);
+    for (size_t i = 0; i < cpus.size(); ++i) {
+        for (size_t j = 0; j < i; ++j) {
+            if (cpus[j].package == cpus[i].package && cpus[j].core == cpus[i].core) ++rank[i];
+        }
+    }
+    std::vector<size_t> idx(cpus.size());
+    for (size_t i = 0; i < idx.size(); ++i) idx[i] = i;
+    std::stable_sort(idx.begin(), idx.end(), [&](size_t a, size_t b) {
+        if (pin == PIN_SCATTER) {
+            if (rank[a] != rank[b]) return rank[a] < rank[b];
+            return false;
+        }
+        if (cpus[a].package != cpus[b].package) return cpus[a].package < cpus[b].package;
+        return rank[a] < rank[b];
+    });
+    if (pin == PIN_SCATTER) {
+        // interleave packages within each hyperthread rank
+        std::vector<size_t> interleaved;
+        size_t begin = 0;
+        while (begin < idx.size()) {
+            size_t end = begin;
+            while (end < idx.size() && rank[idx[end]] == rank[idx[begin]]) ++end;
+            std::vector<std::vector<size_t> > byPackage;
+            std::vector<int> packages;
+            for (size_t i = begin; i < end; ++i) {
+                const int p = cpus[idx[i]].package;
+                size_t k = std::find(packages.begin(), packages.end(), p) - packages.begin();
+                if (k == packages.size()) { packages.push_back(p); byPackage.push_back(std::vector<size_t>()); }
+                byPackage[k].push_back(idx[i]);
+            }
+            for (size_t round = 0; interleaved.size() < end; ++round) {
+                for (size_t k = 0; k < byPackage.size(); ++k) {
+                    if (round < byPackage[k].size()) interleaved.push_back(byPackage[k][round]);
+                }
+            }
+            begin = end;
+        }
+        idx = interleaved;
+    }
+    order.clear();
+    for (size_t i = 0; i < idx.size(); ++i) order.push_back(cpus[idx[i]]);
+}
+
+static int openL1dMissCounter() {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_L1D
+            | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+            | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static inline int bucketOf(const uint64_t cycles) {
+    return cycles ? 64 - __builtin_clzll(cycles) : 0;
+}
+
+template <typename Provider>
+static inline timestamp_t call(Provider *provider, const int tid) {
+    switch (cfg.op) {
+        case OP_READ: return provider->Read();
+        case OP_SNAPSHOT: return provider->Snapshot();
+        default: return provider->Advance(tid);
+    }
+}
+
+template <typename Provider>
+static void worker(Provider *provider, const int tid, thread_result_t *result) {
+    if (cfg.pin != PIN_NONE) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(order[tid % order.size()].cpu, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+    memset(result, 0, sizeof(*result));
+    const int fd = openL1dMissCounter();
+
+    running.fetch_add(1);
+    while (!start.load()) {}
+    if (fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+
+    long long calls = 0;
+    uint64_t prev = __rdtsc();
+    while (true) {
+        for (int i = 0; i < cfg.check; ++i) {
+            call(provider, tid);
+            const uint64_t now = __rdtsc();
+            ++result->data.histogram[bucketOf(now - prev)];
+            prev = now;
+        }
+        calls += cfg.check;
+
+        // monotonicity check against a value returned by a completed call
+        const timestamp_t seen = published.load(std::memory_order_acquire);
+        const timestamp_t ts = call(provider, tid);
+        if (ts < seen) {
+            ++result->data.violations;
+            result->data.maxViolation = std::max(result->data.maxViolation, (long long) (seen - ts));
+        }
+        published.store(ts, std::memory_order_release);
+        ++calls;
+        prev = __rdtsc();
+        if (stop.load(std::memory_order_relaxed)) break;
+    }
+
+    if (fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        long long misses = 0;
+        result->data.l1dMisses = (read(fd, &misses, sizeof(misses)) == sizeof(misses)) ? misses : -1;
+        close(fd);
+    } else {
+        result->data.l1dMisses = -1;
+    }
+    result->data.calls = calls;
+}
+
+static long long percentile(const long long *histogram, const long long total, const double p) {
+    long long seen = 0;
+    for (int b = 0; b < HISTOGRAM_BUCKETS; ++b) {
+        seen += histogram[b];
+        if (seen >= p * total) return b ? (1LL << b) - 1 : 0;   // upper end of the bucket
+    }
+    return -1;
+}
+
+template <typename Provider>
+static void trial(const std::string &name, const int threads) {
+    Provider *provider = new Provider();
+    thread_result_t *results = new thread_result_t[threads];
+    running = 0;
+    start = false;
+    stop = false;
+    published = 0;
+
+    std::vector<std::thread> workers;
+    for (int tid = 0; tid < threads; ++tid) {
+        workers.push_back(std::thread(worker<Provider>, provider, tid, &results[tid]));
+    }
+    while (running.load() < threads) {}
+    const uint64_t begin = tsc_monotonic_raw_ns();
+    start = true;
+    usleep(cfg.millis * 1000);
+    stop = true;
+    for (size_t i = 0; i < workers.size(); ++i) workers[i].join();
+    const uint64_t elapsed = tsc_monotonic_raw_ns() - begin;
+
+    long long calls = 0, violations = 0, maxViolation = 0, misses = 0;
+    bool missesAvailable = true;
+    long long histogram[HISTOGRAM_BUCKETS] = {0};
+    for (int tid = 0; tid < threads; ++tid) {
+        calls += results[tid].data.calls;
+        violations += results[tid].data.violations;
+        maxViolation = std::max(maxViolation, results[tid].data.maxViolation);
+        if (results[tid].data.l1dMisses < 0) missesAvailable = false;
+        else misses += results[tid].data.l1dMisses;
+        for (int b = 0; b < HISTOGRAM_BUCKETS; ++b) histogram[b] += results[tid].data.histogram[b];
+    }
+    long long timed = 0;
+    for (int b = 0; b < HISTOGRAM_BUCKETS; ++b) timed += histogram[b];
+
+    std::cout<<"provider="<<name
+             <<" threads="<<threads
+             <<" calls="<<calls
+             <<" mcalls_per_sec="<<(calls * 1000.0 / elapsed)
+             <<" violations="<<violations
+             <<" max_violation="<<maxViolation
+             <<" l1d_misses_per_call=";
+    if (missesAvailable && calls) std::cout<<((double) misses / calls);
+    else std::cout<<"n/a";
+    std::cout<<" p50_cycles="<<percentile(histogram, timed, 0.5)
+             <<" p99_cycles="<<percentile(histogram, timed, 0.99)
+             <<" p999_cycles="<<percentile(histogram, timed, 0.999)
+             <<" max_cycles="<<percentile(histogram, timed, 1.0)
+             <<std::endl;
+    if (cfg.histogram) {
+        for (int b = 0; b < HISTOGRAM_BUCKETS; ++b) {
+            if (!histogram[b]) continue;
+            std::cout<<"    ["<<(b ? (1LL << (b-1)) : 0)<<", "<<(1LL << b)<<") cycles: "<<histogram[b]<<std::endl;
+        }
+    }
+    delete[] results;
+    delete provider;
+}
+
+template <typename Provider>
+static void run(const std::string &name, const bool hardware) {
+    if (hardware && !tsc_calibration().invariant) {
+        std::cout<<"provider="<<name<<" skipped: the TSC is not invariant on this machine"<<std::endl;
+        return;
+    }
+    for (size_t i = 0; i < cfg.threadCounts.size(); ++i) {
+        trial<Provider>(name, cfg.threadCounts[i]);
+    }
+}
+
+static bool runProvider(const std::string &name) {
+    if (name == "backoff") run<BackoffTimestamp>(name, false);
+    else if (name == "bundling") run<BundlingTimestamp>(name, false);
+    else if (name == "leased") run<LeasedTimestamp>(name, false);
+    else if (name == "ebr") run<EbrTimestamp>(name, false);
+    else if (name == "rdtsc") run<RdtscTimestamp>(name, true);
+    else if (name == "rdtscp") run<RdtscpTimestamp>(name, true);
+    else if (name == "rdtscp_skew") run<SkewBoundedRdtscpTimestamp>(name, true);
+    else return false;
+    return true;
+}
+
+static const char *allProviders[] = {"backoff", "bundling", "leased", "ebr", "rdtsc", "rdtscp", "rdtscp_skew"};
+
+static std::vector<std::string> split(const std::string &s) {
+    std::vector<std::string> parts;
+    size_t begin = 0;
+    while (begin <= s.size()) {
+        size_t end = s.find(',', begin);
+        if (end == std::string::npos) end = s.size();
+        if (end > begin) parts.push_back(s.substr(begin, end - begin));
+        begin = end + 1;
+    }
+    return parts;
+}
+
+void usage() {
+    std::cout
+        << "Command-Line Options:" << std::endl
+        << "  -m <list>   : comma separated providers, or \"all\" (default)" << std::endl
+        << "                backoff, bundling, leased, ebr, rdtsc, rdtscp, rdtscp_skew" << std::endl
+        << "  -t <list>   : comma separated thread counts (default: 1, powers of two, #cpus)" << std::endl
+        << "  -d <int>    : milliseconds per trial (default 1000)" << std::endl
+        << "  -o <string> : operation: advance (default), read or snapshot" << std::endl
+        << "  -p <string> : pinning: compact (default), scatter or none" << std::endl
+        << "  -c <int>    : calls between two monotonicity checks (default 64)" << std::endl
+        << "  -g          : print the full latency histogram" << std::endl
+        << "  -h          : display this message and exit" << std::endl;
+    exit(0);
+}
+
+int main(int argc, char *argv[]) {
+    cfg.millis = 1000;
+    cfg.op = OP_ADVANCE;
+    cfg.pin = PIN_COMPACT;
+    cfg.check = 64;
+    cfg.histogram = false;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "m:t:d:o:p:c:gh")) != -1) {
+        switch (opt) {
+            case 'm': if (strcmp(optarg, "all")) cfg.providers = split(optarg); break;
+            case 't': {
+                std::vector<std::string> counts = split(optarg);
+                for (size_t i = 0; i < counts.size(); ++i) cfg.threadCounts.push_back(atoi(counts[i].c_str()));
+                break;
+            }
+            case 'd': cfg.millis = atoi(optarg); break;
+            case 'o':
+                if (!strcmp(optarg, "advance")) cfg.op = OP_ADVANCE;
+                else if (!strcmp(optarg, "read")) cfg.op = OP_READ;
+                else if (!strcmp(optarg, "snapshot")) cfg.op = OP_SNAPSHOT;
+                else usage();
+                break;
+            case 'p':
+                if (!strcmp(optarg, "compact")) cfg.pin = PIN_COMPACT;
+                else if (!strcmp(optarg, "scatter")) cfg.pin = PIN_SCATTER;
+                else if (!strcmp(optarg, "none")) cfg.pin = PIN_NONE;
+                else usage();
+                break;
+            case 'c': cfg.check = std::max(1, atoi(optarg)); break;
+            case 'g': cfg.histogram = true; break;
+            default: usage(); break;
+        }
+    }
+
+    computeOrder(cfg.pin == PIN_NONE ? PIN_COMPACT : cfg.pin);
+    const int ncpus = order.size();
+    if (cfg.providers.empty()) {
+        for (size_t i = 0; i < sizeof(allProviders) / sizeof(allProviders[0]); ++i) cfg.providers.push_back(allProviders[i]);
+    }
+    if (cfg.threadCounts.empty()) {
+        cfg.threadCounts.push_back(1);
+        for (int t = 2; t < ncpus; t *= 2) cfg.threadCounts.push_back(t);
+        if (ncpus > 1) cfg.threadCounts.push_back(ncpus);
+    }
+    for (size_t i = 0; i < cfg.threadCounts.size(); ++i) {
+        if (cfg.threadCounts[i] < 1 || cfg.threadCounts[i] > MAX_TID_POW2) {
+            std::cerr<<"ERROR: thread counts must be in [1, "<<MAX_TID_POW2<<"]"<<std::endl;
+            exit(1);
+        }
+    }
+
+    std::cout<<"CPUS="<<ncpus<<std::endl;
+    std::cout<<"PIN_ORDER=";
+    for (int i = 0; i < ncpus; ++i) std::cout<<(i ? "," : "")<<order[i].cpu;
+    std::cout<<std::endl;
+    std::cout<<"TSC_HZ="<<tsc_calibration().hz<<std::endl;
+    std::cout<<"TSC_INVARIANT="<<tsc_calibration().invariant<<std::endl;
+
+    for (size_t i = 0; i < cfg.providers.size(); ++i) {
+        if (!runProvider(cfg.providers[i])) {
+            std::cerr<<"ERROR: unknown provider "<<cfg.providers[i]<<std::endl;
+            exit(1);
+        }
+    }
+    return 0;
+}
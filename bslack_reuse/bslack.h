@@ -62,6 +62,7 @@
     #endif
 #endif
 #include "rq_provider.h"
+#include "rq_aggregate.h"
 
 namespace bslack_ns {
 
@@ -773,6 +774,8 @@ public:
         }
 
     public:
+        typedef Compare key_compare; // see rq_range_mask() in rq_aggregate.h
+
         const void * insert(const int tid, const K& key, void * const val) {
             return doInsert(tid, key, val, true);
         }
@@ -783,6 +786,7 @@ public:
         const pair<void*,bool> find(const int tid, const K& key);
         bool contains(const int tid, const K& key);
         int rangeQuery(const int tid, const K& low, const K& hi, K * const resultKeys, void ** const resultValues);
+        int rangeQueryAggregate(const int tid, const K& lo, const K& hi, RQAggregate<K>& aggregate);
         bool validate(const long long keysum, const bool checkkeysum) {
             if (checkkeysum) {
                 long long treekeysum = getSumOfKeys();
@@ -184,6 +184,39 @@ int bslack_ns::bslack<DEGREE,K,Compare,RecManager>::rangeQuery(const int tid, co
 }
 
 
+// like rangeQuery, but folds the keys into aggregate instead of returning them.
+// requires an rq provider with aggregate support (see rq_aggregate.h).
+template<int DEGREE, typename K, class Compare, class RecManager>
+int bslack_ns::bslack<DEGREE,K,Compare,RecManager>::rangeQueryAggregate(const int tid, const K& lo, const K& hi, RQAggregate<K>& aggregate) {
+    block<Node<DEGREE,K>> stack (NULL);
+    const long long countBefore = aggregate.count;
+    recordmgr->leaveQuiescentState(tid, true);
+    rqProvider->traversal_start(tid);
+
+    // depth first traversal (of interesting subtrees)
+    stack.push(entry);
+    while (!stack.isEmpty()) {
+        Node<DEGREE,K> * node = stack.pop();
+        assert(node);
+
+        if (node->isLeaf()) {
+            rqProvider->traversal_try_add(tid, node, aggregate, lo, hi);
+        } else {
+            // explore the sub-trees that could contain a key in [lo, hi] (see rangeQuery)
+            int nkeys = node->getKeyCount();
+            int r = nkeys;
+            while (r > 0 && cmp(hi, (const K&) node->keys[r-1])) --r;
+            int l = 0;
+            while (l < nkeys && !cmp(lo, (const K&) node->keys[l])) ++l;
+            for (int i=r;i>=l; --i) stack.push(rqProvider->read_addr(tid, &node->ptrs[i]));
+        }
+    }
+
+    rqProvider->traversal_end(tid, aggregate, lo, hi);
+    recordmgr->enterQuiescentState(tid);
+    return (int) (aggregate.count - countBefore);
+}
+
 template <int DEGREE, typename K, class Compare, class RecManager>
 void* bslack_ns::bslack<DEGREE,K,Compare,RecManager>::doInsert(const int tid, const K& key, void * const value, const bool replace) {
     wrapper_info<DEGREE,K> _info;
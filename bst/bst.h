@@ -24,6 +24,7 @@
 #include "random.h"
 #include "scxrecord.h"
 #include "node.h"
+#include "multiget.h"
 
 #ifndef MAX_NODES_INSERTED_OR_DELETED_ATOMICALLY
     // define BEFORE including rq_provider.h
@@ -275,6 +276,8 @@ public:
         const V insertIfAbsent(const int tid, const K& key, const V& val);
         const pair<V,bool> erase(const int tid, const K& key);
         const pair<V,bool> find(const int tid, const K& key);
+        /** looks up keys[0..n-1] with interleaved traversals (see multiget.h); values[i] is NO_VALUE if keys[i] is absent. returns the number of keys found. **/
+        int multiGet(const int tid, const K * const keys, const int n, V * const values);
         int rangeQuery(const int tid, const K& lo, const K& hi, K * const resultKeys, V * const resultValues);
         bool contains(const int tid, const K& key);
         int size(void); /** warning: size is a LINEAR time operation, and does not return consistent results with concurrency **/
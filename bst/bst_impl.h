@@ -145,6 +145,40 @@ const pair<V,bool> bst_ns::bst<K,V,Compare,RecManager>::find(const int tid, cons
     return pair<V,bool>(NO_VALUE, false);
 }
 
+template<class K, class V, class Compare, class RecManager>
+int bst_ns::bst<K,V,Compare,RecManager>::multiGet(const int tid, const K * const keys, const int n, V * const values) {
+    int idx[MULTIGET_GROUP_SIZE];
+    Node<K,V> *l[MULTIGET_GROUP_SIZE];
+    int found = 0;
+    auto start = [&](const int s, const int i) {
+        idx[s] = i;
+        Node<K,V> *p = rqProvider->read_addr(tid, &root->left);
+        l[s] = rqProvider->read_addr(tid, &p->left); // NULL if there are no keys in data structure
+        MULTIGET_PREFETCH(l[s]);
+    };
+    auto step = [&](const int s) {
+        const K& key = keys[idx[s]];
+        Node<K,V> *curr = l[s];
+        Node<K,V> *left = (curr == NULL) ? NULL : rqProvider->read_addr(tid, &curr->left);
+        if (left == NULL) {
+            if (curr != NULL && key == curr->key) {
+                values[idx[s]] = curr->value;
+                ++found;
+            } else {
+                values[idx[s]] = NO_VALUE;
+            }
+            return false;
+        }
+        l[s] = cmp(key, curr->key) ? left : rqProvider->read_addr(tid, &curr->right);
+        MULTIGET_PREFETCH(l[s]);
+        return true;
+    };
+    recmgr->leaveQuiescentState(tid, true);
+    multiget_run(n, start, step);
+    recmgr->enterQuiescentState(tid);
+    return found;
+}
+
 //template<class K, class V, class Compare, class RecManager>
 //const V bst_ns::bst<K,V,Compare,RecManager>::insert(const int tid, const K& key, const V& val) {
 //    bool onlyIfAbsent = false;
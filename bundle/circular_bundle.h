@@ -1,339 +1,425 @@
+// This file implements a bundle as a circular buffer of bundle entries instead
+// of a linked list. Preparing an entry writes the next slot of the buffer, so
+// updates do not allocate and range queries scan contiguous memory.
+//
+// Entries are addressed by a monotonically increasing index, and the entry with
+// index i lives in slot (i & mask). The entries with indices in [tail_, head_]
+// are valid; head_ is the newest and may be pending. Reclaiming entries only
+// advances tail_, and the slots behind it are reused by later updates. When the
+// buffer is full, the update that needs a slot doubles it. The replaced buffer
+// is retired through the entry manager (DEBRA), so a reader that is not
+// quiescent in it and still holds the old buffer finds every entry up to the
+// head_ it read.
+
 #ifndef BUNDLE_CIRCULAR_BUNDLE_H
 #define BUNDLE_CIRCULAR_BUNDLE_H
 
 #include <pthread.h>
+#include <stdint.h>
 #include <sys/types.h>
+
 #include <atomic>
 #include <mutex>
+#include <new>
 
+#include "common_bundle.h"
 #include "plaf.h"
+#include "record_manager.h"
 #include "rq_debugging.h"
 
 #define CPU_RELAX asm volatile("pause\n" ::: "memory")
-#define BUNDLE_INIT_CAPACITY 5
+#define likely(x) __builtin_expect((x), 1)
+#define unlikely(x) __builtin_expect((x), 0)
+
+#define DEBUG_PRINT_INIT() unsigned long i = 0
+#define DEBUG_PRINT(str)                         \
+  if ((i + 1) % 10000 == 0) {                    \
+    std::cout << str << std::endl << std::flush; \
+  }                                              \
+  ++i;
+
+// Number of entries in a new bundle. Must be a power of two.
+#ifndef BUNDLE_INIT_CAPACITY
+#define BUNDLE_INIT_CAPACITY 4
+#endif
+#if (BUNDLE_INIT_CAPACITY & (BUNDLE_INIT_CAPACITY - 1)) != 0
+#error BUNDLE_INIT_CAPACITY must be a power of two
+#endif
 
 // Valid bundle states:
 // ----------------------
-// NORMAL_STATE -- No operations being performed on bundle.
-// PENDING_STATE -- An update is pending.
-// RECLAIM_STATE -- Bundle entries are being reclaimed.
-// RQ_STATE -- A range query is reading the bundle.
-// PENDING_STATE | RESIZE_STATE -- A pending update is resizing the bundle.
-// PENDING_STATE | RECLAIM_STATE -- An update and cleanup are concurrent.
-// PENDING_STATE | RQ_STATE -- An update and range query are concurrent.
-// PENDING_STATE | RECLAIM_STATE | RQ_STATE -- An update, cleanup and rangequery
-// are concurrent. RECLAIM_STATE | RQ_STATE -- Cleanup and a range query are
-// concurrent.
-
+// NORMAL_STATE -- No update or cleanup is modifying the bundle.
+// PENDING_STATE -- An update has prepared an entry and not yet finalized it.
+// PENDING_STATE | RESIZE_STATE -- A pending update is growing the buffer.
+// RECLAIM_STATE -- Bundle entries are being reclaimed. May be combined with
+// either of the above.
+//
+// PENDING_STATE is only needed if updates to a bundle are not serialized by a
+// lock on its node (BUNDLE_LOCKFREE). Otherwise the pending timestamp of the
+// newest entry is enough. Range queries never change the state.
 #define NORMAL_STATE 0
 #define PENDING_STATE 1
 #define RESIZE_STATE 2
 #define RECLAIM_STATE 4
-#define RQ_STATE (~7)
-
-#define DEBUG_PRINT(str)                         \
-  if ((i + 1) % 10000 == 0) {                    \
-    std::cout << str << std::endl << std::flush; \
-  }                                              \
-  ++i;
 
 enum op { NOP, INSERT, REMOVE };
-// Stores pointers to nodes and associated timestamps.
 
 template <typename NodeType>
-class BundleEntry : public BundleEntryBase<NodeType> {};
+class BundleEntry {
+ public:
+  std::atomic<timestamp_t> ts_;
+  NodeType *volatile ptr_;
+};
+
+// A power-of-two array of entries, allocated together with this header. The
+// entry manager frees retired buffers with delete.
+template <typename NodeType>
+class BundleBuffer {
+ public:
+  const long long mask_;
+
+  static BundleBuffer *create(const long long capacity) {
+    void *mem = ::operator new(sizeof(BundleBuffer) +
+                               capacity * sizeof(BundleEntry<NodeType>));
+    BundleBuffer *buffer = new (mem) BundleBuffer(capacity - 1);
+    for (long long i = 0; i < capacity; ++i) {
+      BundleEntry<NodeType> *entry = new (&buffer->entries()[i])
+          BundleEntry<NodeType>();
+      entry->ts_.store(BUNDLE_NULL_TIMESTAMP, std::memory_order_relaxed);
+      entry->ptr_ = nullptr;
+    }
+    return buffer;
+  }
+
+  // The buffer is larger than sizeof(BundleBuffer), so it must not be freed
+  // with a sized delete.
+  static void operator delete(void *mem) { ::operator delete(mem); }
+
+  inline BundleEntry<NodeType> *entries() {
+    return reinterpret_cast<BundleEntry<NodeType> *>(this + 1);
+  }
+
+ private:
+  explicit BundleBuffer(const long long mask) : mask_(mask) {}
+};
+
+// The address of a buffer with log2 of its capacity packed into the top byte,
+// so that a reader locates an entry without loading the buffer's header first.
+#define BUNDLE_BUFFER_SHIFT 56
+
+template <typename NodeType>
+class BundleBufferRef {
+ public:
+  uintptr_t word_;
+
+  explicit BundleBufferRef(const uintptr_t word) : word_(word) {}
+
+  static uintptr_t pack(BundleBuffer<NodeType> *const buffer) {
+    return (uintptr_t)buffer |
+           ((uintptr_t)__builtin_ctzll(buffer->mask_ + 1)
+            << BUNDLE_BUFFER_SHIFT);
+  }
+
+  inline BundleBuffer<NodeType> *buffer() const {
+    return (BundleBuffer<NodeType> *)(word_ &
+                                      ((1ULL << BUNDLE_BUFFER_SHIFT) - 1));
+  }
+
+  inline long long mask() const {
+    return (1LL << (word_ >> BUNDLE_BUFFER_SHIFT)) - 1;
+  }
+
+  inline BundleEntry<NodeType> &at(const long long index) const {
+    return buffer()->entries()[index & mask()];
+  }
+};
+
+// Circular bundles never allocate entries, but a bundle that grows retires its
+// old buffer. Buffers are created by BundleBuffer::create(), so this manager
+// only reclaims them. With pool_none, a buffer is freed as soon as DEBRA
+// reclaims it.
+template <typename NodeType>
+using BundleEntryManager =
+    record_manager<reclaimer_debra<>, allocator_new<>, pool_none<>,
+                   BundleBuffer<NodeType>>;
 
 template <typename NodeType>
-class Bundle : public Bundle<NodeType> {
+class CircularBundle {
  private:
-  // The lower three bits are reserved for marking an ongoing update, resize or
-  // reclaimer. The remaining bits are devoted to keeping track of the number of
-  // concurrent range queries.
+  std::atomic<uintptr_t> buffer_;  // See BundleBufferRef.
+  std::atomic<long long> head_;  // Index of the newest entry, or -1.
+  std::atomic<long long> tail_;  // Index of the oldest valid entry.
   std::atomic<unsigned int> state_;
-  int volatile base_;      // Index of oldest entry.
-  int volatile curr_;      // Index of newest entry.
-  int volatile capacity_;  // Maximum number of entries.
-  // Entry array and metadata.
-  BundleEntry<NodeType> *volatile entries_;  // Bundle entry array
-
-#ifdef BUNDLE_DEBUG
-  int its_;
-  int last_base_;
-  int updates_;
-#endif
 
-  inline void start_rq() {
-    unsigned int expected_state, upper, lower, new_state;
-    while (true) {
-      expected_state = state_ & ~RESIZE_STATE;
-      upper = expected_state >> 3;             // Get the upper bits of state.
-      lower = expected_state & 7;              // Get lower bits.
-      new_state = ((upper + 1) << 3) | lower;  // Increment number of rqs.
-      if (state_.compare_exchange_weak(expected_state, new_state)) {
-        assert(state_ & RQ_STATE && state_ & ~RESIZE_STATE);
-        break;
-      }
+  // Doubles the buffer. Only called by the pending update, so no entry is
+  // added concurrently. A concurrent cleanup may advance tail_ while the
+  // entries are copied, which only means that some reclaimed entries are
+  // copied too.
+  BundleBufferRef<NodeType> grow(
+      const int tid, const BundleBufferRef<NodeType> old_buffer,
+      const long long head, BundleEntryManager<NodeType> *const entry_mgr) {
+    state_.fetch_or(RESIZE_STATE);
+    const long long capacity = (old_buffer.mask() + 1) * 2;
+    BundleBufferRef<NodeType> new_buffer(BundleBufferRef<NodeType>::pack(
+        BundleBuffer<NodeType>::create(capacity)));
+    for (long long i = tail_.load(std::memory_order_acquire); i <= head; ++i) {
+      BundleEntry<NodeType> &entry = old_buffer.at(i);
+      new_buffer.at(i).ptr_ = entry.ptr_;
+      new_buffer.at(i).ts_.store(entry.ts_.load(std::memory_order_relaxed),
+                                  std::memory_order_relaxed);
     }
+    // Readers that see a head_ written after this store also see the new
+    // buffer. Readers that still use the old buffer only read up to the old
+    // head_, and those entries are never overwritten in the old buffer.
+    buffer_.store(new_buffer.word_, std::memory_order_release);
+    entry_mgr->retire(tid, old_buffer.buffer());
+    state_.fetch_and(~RESIZE_STATE);
+    return new_buffer;
   }
 
-  inline void end_rq() {
-    unsigned int expected_state, upper, lower, new_state;
-    while (true) {
-      expected_state = state_ & ~RESIZE_STATE;
-      assert(state_ & RQ_STATE);
-      upper = expected_state >> 3;             // Get the upper bits of state.
-      lower = expected_state & 7;              // Get lower bits.
-      new_state = ((upper - 1) << 3) | lower;  // Increment number of rqs.
-      if (state_.compare_exchange_weak(expected_state, new_state)) {
-        break;
-      }
+ public:
+  CircularBundle() : buffer_(0), head_(-1), tail_(0), state_(0) {}
+
+  ~CircularBundle() { delete BundleBufferRef<NodeType>(buffer_).buffer(); }
+
+  // A node recycled by the record manager's pool keeps the buffer of its
+  // previous life, since the pool runs neither the destructor nor the
+  // constructor. No reader holds such a node any more, so the buffer is
+  // reused, at whatever size it had grown to.
+  void init(const int tid, BundleEntryManager<NodeType> *const entry_mgr) {
+    state_.store(NORMAL_STATE, std::memory_order_relaxed);
+    head_.store(-1, std::memory_order_relaxed);
+    tail_.store(0, std::memory_order_relaxed);
+    BundleBuffer<NodeType> *buffer =
+        BundleBufferRef<NodeType>(buffer_.load(std::memory_order_relaxed))
+            .buffer();
+    if (buffer == nullptr) {
+      buffer = BundleBuffer<NodeType>::create(BUNDLE_INIT_CAPACITY);
     }
+    buffer_.store(BundleBufferRef<NodeType>::pack(buffer),
+                  std::memory_order_release);
   }
 
-  // Doubles the capacity of the bundle. Only called when a new entry is added,
-  // meaning no updates will be lost although some cleanup may be missed.
-  void grow() {
-    unsigned int expected;
+  // Adds a pending entry at the head of the bundle.
+  inline void prepare(const int tid, NodeType *const ptr,
+                      BundleEntryManager<NodeType> *const entry_mgr) {
+#ifdef BUNDLE_LOCKFREE
     while (true) {
-      while (state_ & (RECLAIM_STATE | RQ_STATE))
-        ;  // Wait for a concurrent reclaimer or rq.
-      // Move state from pending to pending and resizing to block reclaimers and
-      // range queries.
-      expected = PENDING_STATE;
-      if (state_.compare_exchange_weak(expected, expected | RESIZE_STATE)) {
+      unsigned int expected = state_.load();
+      if (!(expected & PENDING_STATE) &&
+          state_.compare_exchange_weak(expected, expected | PENDING_STATE)) {
         break;
       }
-    }
-    assert(state_ & (PENDING_STATE | RESIZE_STATE));
-
-    BundleEntry<NodeType> *new_entries =
-        new BundleEntry<NodeType>[capacity_ * 2];
-    int i = base_;
-    int end = curr_;
-    if (i > end) {
-      // Buffer wraps so take into account.
-      end = capacity_ + end;
-    }
-    for (; i <= end; ++i) {
-      // Copy entries to new array.
-      new_entries[i] = entries_[i % capacity_];
-      if (i >= capacity_) {
-        new_entries[i % capacity_] = entries_[i % capacity_];
+      while (state_.load(std::memory_order_relaxed) & PENDING_STATE) {
+        CPU_RELAX;
       }
     }
-
-    // Finish the resize.
-    capacity_ = capacity_ * 2;
-    curr_ = end;
-    SOFTWARE_BARRIER;
-    BundleEntry<NodeType> *old_entries = entries_;  // Swap entry arrays.
-    entries_ = new_entries;
-    delete[] old_entries;
-
-    state_.fetch_and(~RESIZE_STATE);
+#endif
+    // Since no other update can add an entry, the head can be read relaxed.
+    BundleBufferRef<NodeType> buffer(buffer_.load(std::memory_order_relaxed));
+    const long long head = head_.load(std::memory_order_relaxed);
+    if (unlikely(head + 1 - tail_.load(std::memory_order_acquire) >
+                 buffer.mask())) {
+      buffer = grow(tid, buffer, head, entry_mgr);
+    }
+    // The slot held an entry older than tail_, which no reader needs.
+    BundleEntry<NodeType> &entry = buffer.at(head + 1);
+    entry.ts_.store(BUNDLE_PENDING_TIMESTAMP, std::memory_order_relaxed);
+    entry.ptr_ = ptr;
+    head_.store(head + 1, std::memory_order_release);
   }
 
-  void shrink() {
-    // TODO: If the capacity is much larger than the number of valid entries, we
-    // may want to reduce the size.
+  // Removes the pending entry.
+  inline void abort(const int tid,
+                    BundleEntryManager<NodeType> *const entry_mgr) {
+    const long long head = head_.load(std::memory_order_relaxed);
+    assert(BundleBufferRef<NodeType>(buffer_).at(head).ts_ ==
+           BUNDLE_PENDING_TIMESTAMP);
+    head_.store(head - 1, std::memory_order_release);
+#ifdef BUNDLE_LOCKFREE
+    state_.fetch_and(~PENDING_STATE);
+#endif
   }
 
- public:
-  ~Bundle() { delete[] entries_; }
-
-  void init() {
-    state_ = NORMAL_STATE;
-    base_ = 0;
-    curr_ = -1;
-    capacity_ = BUNDLE_INIT_CAPACITY;
-    entries_ = new BundleEntry<NodeType>[BUNDLE_INIT_CAPACITY];
+  // Labels the pending entry to make it visible to range queries.
+  inline void finalize(timestamp_t ts) {
+    assert(ts != BUNDLE_PENDING_TIMESTAMP);
+    BundleEntry<NodeType> &entry =
+        BundleBufferRef<NodeType>(buffer_.load(std::memory_order_relaxed))
+            .at(head_.load(std::memory_order_relaxed));
+    assert(entry.ts_ == BUNDLE_PENDING_TIMESTAMP);
+    entry.ts_.store(ts, std::memory_order_release);
+#ifdef BUNDLE_LOCKFREE
+    state_.fetch_and(~PENDING_STATE);
+#endif
   }
 
-  // Returns a reference to the node that satisfies the snapshot at the given
-  // timestamp. If all
-  inline NodeType *getPtrByTimestamp(timestamp_t ts) override {
-    // NOTE: Range queries may continuously block updaters from resizing, but
-    // this is expected to be common.
-    start_rq();
-
-    int i = curr_;
-    int end = base_;  // NOTE: We don't have to worry about the base changing
-                      // because we will always find our entry before the base,
-                      // or the base will not be changed.
-
-    // Locate first entry that satisfies snapshot, starting from newest.
-    NodeType *ptr = nullptr;
-    if (i != -1) {
-      // If an entry exists in this bundle.
-      if (end > i) {
-        // Buffer wraps so take into account.
-        i = capacity_ + i;
-      }
-      for (; i >= end; --i) {
-        if (entries_[i % capacity_].ts_ <= ts) {
-          ptr = entries_[i % capacity_].ptr_;
-          break;
-        }
-      }
+  inline bool getPtr(int tid, NodeType **next) {
+    const long long head = head_.load(std::memory_order_acquire);
+    assert(head >= 0);  // An inserted node should always have an entry.
+    BundleEntry<NodeType> &entry =
+        BundleBufferRef<NodeType>(buffer_.load(std::memory_order_acquire))
+            .at(head);
+    if (entry.ts_.load(std::memory_order_acquire) !=
+        BUNDLE_PENDING_TIMESTAMP) {
+#ifdef __HANDLE_STATS
+      GSTATS_ADD(tid, bundle_first, 1);
+#endif
+      *next = entry.ptr_;
+      return true;
     }
 
-    end_rq();
-    return ptr;
+    while (entry.ts_.load(std::memory_order_acquire) ==
+           BUNDLE_PENDING_TIMESTAMP) {
+      CPU_RELAX;
+    }
+    *next = entry.ptr_;
+    return true;
   }
 
-  inline void reclaimEntries(timestamp_t ts) {
-    unsigned int expected;
-    while (true) {
-      while (state_ & (RESIZE_STATE | RECLAIM_STATE))
-        ;  // Wait until resize is done.
-      expected = (state_ & ~RESIZE_STATE & ~RECLAIM_STATE);
-      // Move state to reclaim only if it is not resizing.
-      if (state_.compare_exchange_weak(expected, expected | RECLAIM_STATE)) {
-        break;
-      }
-    }
-    assert(state_ & (~RESIZE_STATE));
-    assert(state_ & RECLAIM_STATE);
-
-    int i = curr_;
-    int end = base_;
-    if (i == end || i == -1) {
-      state_.fetch_and(~RECLAIM_STATE);
-      return;
+  // Returns a reference to the node that immediately followed at timestamp ts.
+  inline bool getPtrByTimestamp(int tid, timestamp_t ts, NodeType **next) {
+    // head_ is read before buffer_ so that the buffer contains the head entry.
+    long long i = head_.load(std::memory_order_acquire);
+    BundleBufferRef<NodeType> buffer(buffer_.load(std::memory_order_acquire));
+    const long long tail = tail_.load(std::memory_order_acquire);
+    assert(i >= 0);  // An inserted node should always have an entry.
+
+    // Check if the first entry satisfies the timestamp.
+    BundleEntry<NodeType> *curr = &buffer.at(i);
+    if (curr->ts_.load(std::memory_order_acquire) <= ts) {
+#ifdef __HANDLE_STATS
+      GSTATS_ADD(tid, bundle_first, 1);
+#endif
+      *next = curr->ptr_;
+      return true;
     }
 
-    // Handle wrapping.
-    if (end > i) {
-      i = capacity_ + i;
+    // Optimization. Check the second entry in hopes that it satisfies
+    bool skip_first = false;
+    if (i > tail) {
+      BundleEntry<NodeType> *second = &buffer.at(i - 1);
+      timestamp_t second_ts = second->ts_.load(std::memory_order_acquire);
+      if (second_ts == ts) {
+// Success!
+#ifdef __HANDLE_STATS
+        GSTATS_ADD(tid, bundle_second, 1);
+#endif
+        *next = second->ptr_;
+        return true;
+      } else if (second_ts > ts) {
+// Ignore the pending entry.
+#ifdef __HANDLE_STATS
+        GSTATS_ADD(tid, bundle_skip_first, 1);
+#endif
+        --i;
+        skip_first = true;
+      }
     }
 
-    if (ts == BUNDLE_NULL_TIMESTAMP) {
-      // No active range queries.
-      base_ = curr_;
-      for (i = i - 1; i >= end; --i) {
-        entries_[i % capacity_].marked_ = true;
+    if (!skip_first) {
+      long long retries = 0;
+      while (curr->ts_.load(std::memory_order_acquire) ==
+             BUNDLE_PENDING_TIMESTAMP) {
+        CPU_RELAX;
+        ++retries;
       }
-    } else {
-      // Locate reclaimable entries.
-      bool set = false;
-      for (; i >= end; --i) {
-        if (entries_[i % capacity_].ts_ != BUNDLE_NULL_TIMESTAMP &&
-            entries_[i % capacity_].ts_ <= ts) {
-          // Found first entry to retire at index i - 1, so set base to i.
-          if (!set) {
-#ifdef BUNDLE_DEBUG
-            last_base_ = base_;
+#ifdef __HANDLE_STATS
+      GSTATS_APPEND(tid, bundle_retries, retries);
 #endif
-            base_ = i % capacity_;
-            assert(base_ >= 0);
-            assert(entries_[base_].marked_ == false);
-            set = true;
-          } else {
-            entries_[i % capacity_].marked_ = true;
-          }
-        }
-      }
     }
 
-    state_.fetch_and(~RECLAIM_STATE);
+    // Only the head entry can be pending, so the remaining timestamps are
+    // final.
+    long long traversals = 0;
+    while (i >= tail &&
+           buffer.at(i).ts_.load(std::memory_order_acquire) > ts) {
+      --i;
+      ++traversals;
+    }
+#ifdef __HANDLE_STATS
+    GSTATS_APPEND(tid, bundle_traversals, traversals);
+#endif
+    if (i >= tail) {
+      *next = buffer.at(i).ptr_;
+      return true;
+    } else {
+      return false;
+    }
   }
 
-  inline void prepare(NodeType *const ptr) {
-    unsigned int expected;
+  // Reclaims any entries that are older than the newest entry whose timestamp
+  // is at most ts, by moving the tail to that entry. If another thread is
+  // already reclaiming entries of this bundle, this returns immediately.
+  inline void reclaimEntries(const int tid, timestamp_t ts,
+                             BundleEntryManager<NodeType> *const entry_mgr) {
+    unsigned int expected = state_.load();
     while (true) {
-      while (state_ & PENDING_STATE)
-        ;  // Wait for ongoing op to finish.
-      expected = state_ & ~PENDING_STATE;
-      if (state_.compare_exchange_weak(expected, expected | PENDING_STATE)) {
+      if (expected & RECLAIM_STATE) return;
+      if (state_.compare_exchange_weak(expected, expected | RECLAIM_STATE)) {
         break;
       }
     }
-    assert(state_ & PENDING_STATE);
 
-    if (curr_ != -1 && (curr_ + 1) % capacity_ == base_) {
-      // Resize if we have run out of room.
-      grow();
+    const long long head = head_.load(std::memory_order_acquire);
+    BundleBufferRef<NodeType> buffer(buffer_.load(std::memory_order_acquire));
+    const long long tail = tail_.load(std::memory_order_relaxed);
+    for (long long i = head; i > tail; --i) {
+      // A pending entry is larger than any timestamp, so it is never chosen.
+      if (buffer.at(i).ts_.load(std::memory_order_acquire) <= ts) {
+        tail_.store(i, std::memory_order_release);
+        break;
+      }
     }
-    SOFTWARE_BARRIER;
-    entries_[(curr_ + 1) % capacity_].ptr_ = ptr;
-  }
 
-  inline void finalize(timestamp_t ts) {
-    // Assumes the bundles are in the pending state.
-    assert(state_ & PENDING_STATE && !(state_ & (RESIZE_STATE)));
-    assert(curr_ == -1 || (curr_ + 1) % capacity_ != base_);
-#ifdef BUNDLE_DEBUG
-    if (curr_ == -1) {
-      its_ = ts;
-      assert(its_ != 0);
-    }
-    ++updates_;
-#endif
-    entries_[(curr_ + 1) % capacity_].ts_ = ts;
-    entries_[(curr_ + 1) % capacity_].marked_ = false;
-    SOFTWARE_BARRIER;
-    curr_ = (curr_ + 1) % capacity_;
-    state_.fetch_and(~PENDING_STATE);
+    state_.fetch_and(~RECLAIM_STATE);
   }
 
-  // [UNSAFE]. Returns the number of entries in the bundle.
-  inline int size() override {
-    if (curr_ == -1) {
-      return 0;
-    } else if (base_ > curr_) {
-      return (capacity_ - base_) + curr_;
-    } else {
-      return curr_ - base_;
-    }
-  }
+  // [UNSAFE] Returns the number of bundle entries.
+  int size() { return (int)(head_.load() - tail_.load() + 1); }
 
-  NodeType *first(timestamp_t &ts) override {
-    // If the bundle has no entries, return nullptr.
-    if (curr_ == -1) {
-      ts = -1;
+  inline NodeType *first(timestamp_t &ts) {
+    const long long head = head_.load(std::memory_order_acquire);
+    if (head < 0) {
+      ts = BUNDLE_NULL_TIMESTAMP;
       return nullptr;
     }
-    ts = entries_[curr_].ts_;
-    return entries_[curr_].ptr_;
+    BundleEntry<NodeType> &entry = BundleBufferRef<NodeType>(buffer_).at(head);
+    ts = entry.ts_;
+    return entry.ptr_;
   }
 
-  // [UNSAFE]
-  std::pair<NodeType *, timestamp_t> *get(int &length) override {
+  // [UNSAFE] Returns the entries from newest to oldest.
+  std::pair<NodeType *, timestamp_t> *get(int &length) {
+    const long long head = head_.load();
+    const long long tail = tail_.load();
+    BundleBufferRef<NodeType> buffer(buffer_.load());
+    length = (int)(head - tail + 1);
     std::pair<NodeType *, timestamp_t> *retarr =
-        new std::pair<NodeType *, timestamp_t>[capacity_];
-    if (curr_ == -1) {
-      length = 0;
-      return retarr;
-    }
-    NodeType *ptr;
-    timestamp_t ts;
+        new std::pair<NodeType *, timestamp_t>[length];
     int pos = 0;
-    for (int i = base_; i <= (base_ > curr_ ? capacity_ + curr_ : curr_);
-         ++i, ++pos) {
-      ptr = entries_[i % capacity_].ptr_;
-      ts = entries_[i % capacity_].ts_;
-      retarr[pos] = std::pair<NodeType *, timestamp_t>(ptr, ts);
+    for (long long i = head; i >= tail; --i) {
+      retarr[pos++] = std::pair<NodeType *, timestamp_t>(
+          buffer.at(i).ptr_, buffer.at(i).ts_.load());
     }
-    length = pos;
     return retarr;
   }
 
-  string __attribute__((noinline)) dump(timestamp_t ts) override {
+  string __attribute__((noinline)) dump(timestamp_t ts) {
+    const long long head = head_.load();
+    const long long tail = tail_.load();
+    BundleBufferRef<NodeType> buffer(buffer_.load());
     std::stringstream ss;
     ss << "(ts=" << ts << ") : ";
-    long i = 0;
-    for (int i = 0; i < capacity_; ++i) {
-      ss << "<" << entries_[i].ts_ << "," << entries_[i].ptr_ << ","
-         << entries_[i].marked_ << ">"
-         << ", ";
+    for (long long i = head; i >= tail; --i) {
+      ss << "<" << buffer.at(i).ts_ << "," << buffer.at(i).ptr_ << ">"
+         << "-->";
     }
-    ss << " [curr_ = " << curr_ << ", base_ = " << base_
-#ifdef BUNDLE_DEBUG
-       << ", updates_ = " << updates_ << ", last_base_ = " << last_base_
-#endif
-       << "]" << std::endl;
+    ss << "(tail) [head_=" << head << ", tail_=" << tail
+       << ", capacity=" << buffer.mask() + 1 << ", state_=" << state_ << "]"
+       << std::endl;
     return ss.str();
   }
 };
 
-#endif  // BUNDLE_CIRCULAR_BUNDLE_H
\ No newline at end of file
+#endif  // BUNDLE_CIRCULAR_BUNDLE_H
@@ -20,13 +20,17 @@ class BundleEntryBase {
   bool marked_ = true;                      // True if not valid or is deleted.
 };
 
-template <typename NodeType>
+template <typename NodeType, typename EntryManager>
 class BundleInterface {
  public:
-  virtual void init() = 0;
+  // Empties the bundle of a newly allocated or recycled node. Storage left
+  // over from a recycled node's previous life is returned to entry_mgr by
+  // thread tid.
+  virtual void init(int tid, EntryManager *entry_mgr) = 0;
 
   // Prepares the next bundle entry by setting the timestamp to a pending state.
-  virtual void prepare(NodeType *ptr) = 0;
+  // Entries are allocated by thread tid from the provider's entry manager.
+  virtual void prepare(int tid, NodeType *ptr, EntryManager *entry_mgr) = 0;
 
   // Finalizes the bundle entry previously prepared by setting the timestamp to
   // ts, which is the linearization timestamp of the update.
@@ -36,8 +40,10 @@ class BundleInterface {
   virtual NodeType *getPtrByTimestamp(timestamp_t ts) = 0;
 
   // Removes all entries that are older than the first entry that is at least as
-  // old as the provided timestamp.
-  virtual void reclaimEntries(timestamp_t ts) = 0;
+  // old as the provided timestamp. Removed entries are retired to entry_mgr by
+  // thread tid.
+  virtual void reclaimEntries(int tid, timestamp_t ts,
+                              EntryManager *entry_mgr) = 0;
 
   // Returns the number of valid bundle entries in the bundle.
   virtual int size() = 0;
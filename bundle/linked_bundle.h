@@ -2,6 +2,16 @@
 //
 // This file implements a bundle as a linked list of bundle entries. A bundle is
 // prepared by CASing the head of the bundle to a pending entry.
+//
+// Entries come from a BundleEntryManager shared by all bundles of a data
+// structure (the range query provider owns it). Allocation is served from a
+// per-thread pool, and reclaimed entries are retired with DEBRA, so they return
+// to a pool once no range query can still be reading them.
+//
+// The newest entry is also copied into the bundle itself, next to head_, so a
+// range query that reads the newest version of a node (the common case) does
+// not miss on a separately allocated entry. The copy is guarded by a sequence
+// number, as in a seqlock.
 
 #ifndef BUNDLE_LINKED_BUNDLE_H
 #define BUNDLE_LINKED_BUNDLE_H
@@ -10,10 +20,12 @@
 #include <sys/types.h>
 
 #include <atomic>
+#include <cstdint>
 #include <mutex>
 
 #include "common_bundle.h"
 #include "plaf.h"
+#include "record_manager.h"
 #include "rq_debugging.h"
 
 #define CPU_RELAX asm volatile("pause\n" ::: "memory")
@@ -37,13 +49,17 @@ class BundleEntry {
   std::atomic<BundleEntry *> next_;
   volatile timestamp_t deleted_ts_;
 
-  BundleEntry() = delete;
-  BundleEntry(timestamp_t ts, NodeType *ptr, BundleEntry *next)
-      : ts_(ts), next_(next) {
-    this->ptr_ = ptr;
+  // Entries are recycled by the record manager, which does not run a
+  // constructor on reuse, so all fields are set by init().
+  BundleEntry() {}
+  ~BundleEntry() {}
+
+  inline void init(timestamp_t ts, NodeType *ptr, BundleEntry *next) {
+    ts_.store(ts, std::memory_order_relaxed);
+    ptr_ = ptr;
+    next_.store(next, std::memory_order_relaxed);
     deleted_ts_ = BUNDLE_NULL_TIMESTAMP;
   }
-  ~BundleEntry() {}
 
   void set_ts(const timestamp_t ts) { ts_ = ts; }
   void set_ptr(NodeType *const ptr) { this->ptr_ = ptr; }
@@ -59,9 +75,21 @@ class BundleEntry {
   }
 };
 
+template <typename NodeType>
+using BundleEntryManager =
+    record_manager<reclaimer_debra<>, allocator_new<>,
+                   pool_perthread_and_shared<>, BundleEntry<NodeType>>;
+
 template <typename NodeType>
 class LinkedBundle {
  private:
+  // Copy of the newest entry. newest_ts_ is BUNDLE_NULL_TIMESTAMP while the
+  // bundle is empty. newest_seq_ is odd from prepare() until finalize() or
+  // abort(), and the copy only changes while it is odd. It never goes back, so
+  // an abort that restores an older timestamp cannot pass a reader's check.
+  std::atomic<uint64_t> newest_seq_;
+  std::atomic<timestamp_t> newest_ts_;
+  NodeType *volatile newest_ptr_;
   std::atomic<BundleEntry<NodeType> *> head_;
   // BundleEntry<NodeType> *volatile tail_;
 
@@ -72,37 +100,85 @@ class LinkedBundle {
 #endif
 
  public:
-  ~LinkedBundle() {
-    BundleEntry<NodeType> *curr = head_.load();
-    BundleEntry<NodeType> *next;
+  LinkedBundle()
+      : newest_seq_(0),
+        newest_ts_(BUNDLE_NULL_TIMESTAMP),
+        newest_ptr_(nullptr),
+        head_(nullptr) {}
+
+  // Entries belong to the entry manager, so they are not freed here. They are
+  // returned to it by init() when the record manager recycles the node.
+  ~LinkedBundle() {}
+
+  // A node recycled by the record manager's pool still holds the entries of
+  // its previous life, since the pool runs neither the destructor nor the
+  // constructor. The node has been retired, so no range query can reach them
+  // through it any more; they are retired rather than freed because a cleanup
+  // pass may still be reading them.
+  void init(const int tid, BundleEntryManager<NodeType> *const entry_mgr) {
+    BundleEntry<NodeType> *curr = head_.load(std::memory_order_relaxed);
     while (curr != nullptr) {
-      assert(curr != nullptr);
-      next = curr->next_;
-      delete curr;
+      BundleEntry<NodeType> *const next = curr->next_;
+      entry_mgr->retire(tid, curr);
       curr = next;
     }
+    // Every prepare was finalized or aborted, so newest_seq_ is even. It keeps
+    // counting across lives.
+    assert((newest_seq_.load(std::memory_order_relaxed) & 1) == 0);
+    newest_ts_ = BUNDLE_NULL_TIMESTAMP;
+    newest_ptr_ = nullptr;
+    head_ = nullptr;
   }
 
-  void init() { head_ = nullptr; }
+  // Reads the newest entry without dereferencing head_. Returns false if an
+  // update is in flight, the bundle is empty or the copy changed while reading.
+  inline bool readNewest(timestamp_t &ts, NodeType **ptr) {
+    const uint64_t seq = newest_seq_.load(std::memory_order_acquire);
+    if (seq & 1) return false;
+    ts = newest_ts_.load(std::memory_order_relaxed);
+    *ptr = newest_ptr_;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return ts != BUNDLE_NULL_TIMESTAMP &&
+           newest_seq_.load(std::memory_order_relaxed) == seq;
+  }
+
+  // Marks the copy as being written. Only the thread whose entry is pending at
+  // the head calls this, and the matching endWrite().
+  inline void beginWrite() {
+    newest_seq_.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+
+  inline void endWrite() {
+    newest_seq_.fetch_add(1, std::memory_order_release);
+  }
 
   // Inserts a new rq_bundle_node at the head of the bundle.
-  inline void prepare(NodeType *const ptr) {
+  inline void prepare(const int tid, NodeType *const ptr,
+                      BundleEntryManager<NodeType> *const entry_mgr) {
     BundleEntry<NodeType> *new_entry =
-        new BundleEntry<NodeType>(BUNDLE_PENDING_TIMESTAMP, ptr, nullptr);
+        entry_mgr->template allocate<BundleEntry<NodeType>>(tid);
+    new_entry->init(BUNDLE_PENDING_TIMESTAMP, ptr, nullptr);
 
 #ifdef BUNDLE_LOCKFREE
     while (true) {
       BundleEntry<NodeType> *expected = head_;
-      if (expected->ts_ != BUNDLE_PENDING_TIMESTAMP &&
+      // Readers may follow next_ as soon as the entry is the head.
+      new_entry->next_.store(expected, std::memory_order_relaxed);
+      // A new node's bundles are empty until they are first prepared.
+      if ((expected == nullptr ||
+           expected->ts_ != BUNDLE_PENDING_TIMESTAMP) &&
           head_.compare_exchange_weak(expected, new_entry)) {
-        new_entry->next_ = expected;
+        beginWrite();
+        newest_ptr_ = ptr;
 #ifdef BUNDLE_DEBUG
         ++updates;
 #endif
         return;
       }
-      // long i = 0;
-      while (expected->ts_ == BUNDLE_PENDING_TIMESTAMP) {
+      // Re-read the head: an aborted entry is unlinked but stays pending.
+      while ((expected = head_) != nullptr &&
+             expected->ts_ == BUNDLE_PENDING_TIMESTAMP) {
         // DEBUG_PRINT("insertAtHead");
         CPU_RELAX;
       }
@@ -112,6 +188,8 @@ class LinkedBundle {
     // stringent memory order
     new_entry->next_.store(head_, std::memory_order_relaxed);
     head_.store(new_entry, std::memory_order_relaxed);
+    beginWrite();
+    newest_ptr_ = ptr;
 #ifdef BUNDLE_DEBUG
     ++updates;
 #endif
@@ -119,21 +197,47 @@ class LinkedBundle {
 #endif
   }
 
-  inline void abort() {
-    assert(head_->ts_ == BUNDLE_PENDING_TIMESTAMP);
-    NodeType *entry = head_;
-    head_ = entry->ptr_;
-    delete entry;
+  // Removes the pending entry. Readers may be waiting on it, so it is retired
+  // rather than freed.
+  inline void abort(const int tid,
+                    BundleEntryManager<NodeType> *const entry_mgr) {
+    assert(head_.load()->ts_ == BUNDLE_PENDING_TIMESTAMP);
+    BundleEntry<NodeType> *entry = head_;
+    BundleEntry<NodeType> *const next = entry->next_.load();
+    // Restore the newest entry before unlinking the pending one: with
+    // BUNDLE_LOCKFREE, another update may prepare as soon as head_ changes.
+    if (next != nullptr) {
+      newest_ptr_ = next->ptr_;
+      newest_ts_.store(next->ts_, std::memory_order_relaxed);
+    } else {
+      newest_ptr_ = nullptr;
+      newest_ts_.store(BUNDLE_NULL_TIMESTAMP, std::memory_order_relaxed);
+    }
+    endWrite();
+    head_ = next;
+    entry_mgr->retire(tid, entry);
   }
 
   // Labels the pending entry to make it visible to range queries.
   inline void finalize(timestamp_t ts) {
     assert(ts != BUNDLE_PENDING_TIMESTAMP);
     assert(head_.load()->ts_ == BUNDLE_PENDING_TIMESTAMP);
+    // Publish the copy first: with BUNDLE_LOCKFREE, another update may prepare
+    // (and overwrite the copy) as soon as the head entry is no longer pending.
+    newest_ts_.store(ts, std::memory_order_relaxed);
+    endWrite();
     head_.load()->ts_ = ts;
   }
 
   inline bool getPtr(int tid, NodeType **next) {
+    timestamp_t newest_ts;
+    if (readNewest(newest_ts, next)) {
+#ifdef __HANDLE_STATS
+      GSTATS_ADD(tid, bundle_first, 1);
+#endif
+      return true;
+    }
+
     BundleEntry<NodeType> *curr = head_;
     timestamp_t curr_ts = curr->ts_;
     if (curr_ts != BUNDLE_PENDING_TIMESTAMP) {
@@ -153,7 +257,19 @@ class LinkedBundle {
 
   // Returns a reference to the node that immediately followed at timestamp ts.
   inline bool getPtrByTimestamp(int tid, timestamp_t ts, NodeType **next) {
-    // Check if the first entry satisfies the timestamp.
+    // Check if the newest entry satisfies the timestamp, using the copy held in
+    // the bundle.
+    timestamp_t newest_ts;
+    NodeType *newest_ptr;
+    if (readNewest(newest_ts, &newest_ptr) && newest_ts <= ts) {
+#ifdef __HANDLE_STATS
+      GSTATS_ADD(tid, bundle_first, 1);
+#endif
+      *next = newest_ptr;
+      return true;
+    }
+
+    // Otherwise check the first entry of the list.
     BundleEntry<NodeType> *curr = head_;
     assert(head_ != nullptr);  // An inserted node should always have an entry.
     if (curr != nullptr) {
@@ -191,7 +307,9 @@ class LinkedBundle {
 
     if (!skip_first) {
       long long retries = 0;
-      while (curr->ts_ == BUNDLE_PENDING_TIMESTAMP) {
+      // Stop waiting if the entry was aborted (and so unlinked); the loop
+      // below then skips it.
+      while (curr->ts_ == BUNDLE_PENDING_TIMESTAMP && curr == head_) {
         CPU_RELAX;
         ++retries;
       }
@@ -225,8 +343,10 @@ class LinkedBundle {
   }
 
   // Reclaims any edges that are older than ts. At the moment this should be
-  // ordered before adding a new entry to the bundle.
-  inline void reclaimEntries(timestamp_t ts) {
+  // ordered before adding a new entry to the bundle. The caller must not be
+  // quiescent in entry_mgr.
+  inline void reclaimEntries(const int tid, timestamp_t ts,
+                             BundleEntryManager<NodeType> *const entry_mgr) {
     // Obtain a reference to the pred non-reclaimable entry and first
     // reclaimable one. Ignore the first entry if it is pending or return if
     // there is nothing to reclaim.
@@ -265,7 +385,7 @@ class LinkedBundle {
       curr = curr->next_;
       pred->mark(ts);
 #ifndef BUNDLE_CLEANUP_NO_FREE
-      delete pred;
+      entry_mgr->retire(tid, pred);
 #endif
     }
 #ifdef BUNDLE_DEBUG
@@ -301,6 +421,8 @@ class LinkedBundle {
   }
 
   inline NodeType *first(timestamp_t &ts) {
+    NodeType *ptr;
+    if (readNewest(ts, &ptr)) return ptr;
     BundleEntry<NodeType> *entry = head_;
     ts = entry->ts_;
     return entry->ptr_;
@@ -0,0 +1,121 @@
+/*
+ * File:   test_linked_bundle.cpp
+ *
+ * Stress test for the copy of the newest entry that a LinkedBundle keeps next
+ * to head_. Writer threads prepare entries on a single bundle and then either
+ * finalize or abort them, while reader threads call readNewest(). Every
+ * timestamp/pointer pair a reader accepts must be one that some writer
+ * finalized together. Aborted pointers never are.
+ */
+
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+#define BUNDLE_LOCKFREE
+#include "linked_bundle.h"
+
+struct node_t {};
+
+// The bundle never dereferences the pointers it stores, so each prepare gets a
+// unique fake pointer whose finalized timestamp is recorded in published.
+static inline node_t *encode(long long id) {
+    return reinterpret_cast<node_t *>((id + 1) << 4);
+}
+static inline long long decode(node_t *ptr) {
+    return (reinterpret_cast<long long>(ptr) >> 4) - 1;
+}
+
+int main(int argc, char** argv) {
+    if (argc != 4) {
+        cout<<"USAGE: "<<argv[0]<<" NUMBER_OF_WRITERS NUMBER_OF_READERS UPDATES_PER_WRITER"<<endl;
+        exit(-1);
+    }
+    const int writers = atoi(argv[1]);
+    const int readers = atoi(argv[2]);
+    const long long updates = atoll(argv[3]);
+    if (writers < 1 || readers < 1 || updates < 1) {
+        cout<<"ERROR: all arguments must be positive"<<endl;
+        exit(-1);
+    }
+
+    BundleEntryManager<node_t> mgr (writers + readers, SIGQUIT);
+    LinkedBundle<node_t> bundle;
+    mgr.initThread(0);
+    bundle.init(0, &mgr);
+
+    // published[id] is the timestamp the id's entry was finalized with, or
+    // BUNDLE_NULL_TIMESTAMP if it was aborted or is still pending.
+    const long long ids = writers * updates;
+    std::atomic<timestamp_t> * published = new std::atomic<timestamp_t>[ids];
+    for (long long i=0;i<ids;++i) published[i] = BUNDLE_NULL_TIMESTAMP;
+
+    // Writers are serialized by the pending head, so the clock only advances
+    // while one holds it and the bundle's timestamps stay ordered.
+    std::atomic<timestamp_t> clock (BUNDLE_MIN_TIMESTAMP);
+    std::atomic<int> running (writers);
+    std::atomic<bool> failed (false);
+    std::atomic<long long> aborts (0);
+    std::atomic<long long> hits (0);
+
+    std::vector<std::thread> threads;
+    for (int w=0;w<writers;++w) {
+        threads.emplace_back([&, w]() {
+            const int tid = w;
+            if (tid != 0) mgr.initThread(tid);
+            unsigned int seed = tid + 1;
+            for (long long i=0;i<updates;++i) {
+                const long long id = tid * updates + i;
+                mgr.leaveQuiescentState(tid);
+                bundle.prepare(tid, encode(id), &mgr);
+                if (rand_r(&seed) % 2) {
+                    bundle.abort(tid, &mgr);
+                    ++aborts;
+                } else {
+                    const timestamp_t ts = ++clock;
+                    published[id].store(ts, std::memory_order_release);
+                    bundle.finalize(ts);
+                }
+                mgr.enterQuiescentState(tid);
+            }
+            --running;
+        });
+    }
+    for (int r=0;r<readers;++r) {
+        threads.emplace_back([&, r]() {
+            const int tid = writers + r;
+            mgr.initThread(tid);
+            long long local_hits = 0;
+            while (running > 0 && !failed) {
+                timestamp_t ts;
+                node_t * ptr;
+                if (!bundle.readNewest(ts, &ptr)) continue;
+                ++local_hits;
+                const long long id = decode(ptr);
+                if (id < 0 || id >= ids || published[id].load(std::memory_order_acquire) != ts) {
+                    cout<<"ERROR: readNewest returned ts="<<ts<<" with the entry of id="<<id
+                        <<", which was "<<(id < 0 || id >= ids ? 0 : published[id].load())<<endl;
+                    failed = true;
+                }
+            }
+            hits += local_hits;
+        });
+    }
+    for (auto & t : threads) t.join();
+
+    delete[] published;
+    if (failed) exit(1);
+    if (aborts == 0 || hits == 0) {
+        cout<<"ERROR: the run did not mix aborts ("<<aborts<<") and reads ("<<hits<<")"<<endl;
+        exit(1);
+    }
+    cout<<"aborts="<<aborts<<" reads="<<hits<<endl;
+    cout<<"All tests passed."<<endl;
+    return 0;
+}
@@ -0,0 +1,14 @@
+#!/bin/bash
+#
+# File:   test_linked_bundle.sh
+#
+# Builds and runs the LinkedBundle abort/readNewest stress test.
+#
+
+cd "$(dirname "$0")"
+g++ -std=c++11 -mcx16 -O3 -DNDEBUG -pthread -DLOGICAL_PROCESSORS=128 -DMAX_TID_POW2=128 \
+    -I.. -I../../common -I../../recordmgr -I../../rq -I../../microbench \
+    -o test_linked_bundle.out test_linked_bundle.cpp -latomic || exit 1
+for ((x=0;x<10;++x)) ; do
+    ./test_linked_bundle.out 2 4 1000000 || exit 1
+done
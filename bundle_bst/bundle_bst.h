@@ -23,6 +23,7 @@
 #include <stdexcept>
 #include <string>
 
+#include "multiget.h"
 #include "node.h"
 #include "random.h"
 #include "record_manager.h"
@@ -33,6 +34,7 @@
 #define MAX_NODES_INSERTED_OR_DELETED_ATOMICALLY 4
 #endif
 #include "rq_provider.h"
+#include "rq_cursor.h"
 
 using namespace std;
 
@@ -240,11 +242,13 @@ class bundle_bst {
     Node<K, V> *insertedNodes[] = {_root, rootleft, NULL};
     Node<K, V> *deletedNodes[] = {NULL};
 
-    BUNDLE_TYPE_DECL<Node<K, V>> *bundles[] = {&(_root->left_bundle), nullptr};
-    Node<K, V> *ptrs[] = {rootleft, nullptr};
-    rqProvider->prepare_bundles(bundles, ptrs);
+    BUNDLE_TYPE_DECL<Node<K, V>> *bundles[] = {
+        &(_root->left_bundle), &(_root->right_bundle),
+        &(rootleft->left_bundle), &(rootleft->right_bundle), nullptr};
+    Node<K, V> *ptrs[] = {rootleft, nullptr, nullptr, nullptr, nullptr};
+    rqProvider->prepare_bundles(tid, bundles, ptrs);
     timestamp_t ts = rqProvider->linearize_update_at_write(tid, &root, _root);
-    rqProvider->finalize_bundles(bundles, tid);
+    rqProvider->finalize_bundles(bundles, ts);
   }
 
   Node<K, V> *debug_getEntryPoint() { return root; }
@@ -307,8 +311,16 @@ class bundle_bst {
   const V insertIfAbsent(const int tid, const K &key, const V &val);
   const pair<V, bool> erase(const int tid, const K &key);
   const pair<V, bool> find(const int tid, const K &key);
+  /** looks up keys[0..n-1] with interleaved traversals (see multiget.h);
+   * values[i] is NO_VALUE if keys[i] is absent. returns the number of keys
+   * found. **/
+  int multiGet(const int tid, const K *const keys, const int n,
+               V *const values);
   int rangeQuery(const int tid, const K &lo, const K &hi, K *const resultKeys,
                  V *const resultValues);
+  template <typename Visitor>
+  int rangeQueryVisit(const int tid, const K &lo, const K &hi,
+                      Visitor &visitor);
   bool contains(const int tid, const K &key);
   int size(void); /** warning: size is a LINEAR time operation, and does not
                      return consistent results with concurrency **/
@@ -28,8 +28,8 @@ bundle_bst_ns::Node<K, V>
     COUTATOMICTID("ERROR: could not allocate node" << endl);
     exit(-1);
   }
-  newnode->left_bundle.init();
-  newnode->right_bundle.init();
+  newnode->left_bundle.init(tid, rqProvider->get_entry_manager());
+  newnode->right_bundle.init(tid, rqProvider->get_entry_manager());
 #ifdef __HANDLE_STATS
   GSTATS_APPEND(tid, node_allocated_addresses,
                 ((long long)newnode) % (1 << 12));
@@ -169,6 +169,84 @@ int bundle_bst_ns::bundle_bst<K, V, Compare, RecManager>::rangeQuery(
   }
 }
 
+// Same phases as rangeQuery. Its depth first traversal pushes the right child
+// before the left one, so leaves are popped, and passed to the visitor, in
+// increasing key order. It can only restart until the first batch of keys has
+// been passed to the visitor. After that, a failed bundle lookup makes it walk
+// the snapshot again from the root, skipping the subtrees below the last key
+// added.
+template <class K, class V, class Compare, class RecManager>
+template <typename Visitor>
+int bundle_bst_ns::bundle_bst<K, V, Compare, RecManager>::rangeQueryVisit(
+    const int tid, const K &lo, const K &hi, Visitor &visitor) {
+  RQCursor<K, V, Visitor> cursor(visitor);
+  block<Node<K, V>> stack(NULL);
+  for (;;) {
+    recmgr->leaveQuiescentState(tid, true);
+    timestamp_t ts = rqProvider->start_traversal(tid);
+
+    // Phase 1. Pre-range traversal
+    Node<K, V> *prev = root;
+    Node<K, V> *curr = root->left;
+    Node<K, V> *left, *right;
+    bool is_left_child = true;
+    while (curr != nullptr) {
+      if (curr->key != this->NO_KEY && !cmp(curr->key, lo) &&
+          !cmp(hi, curr->key)) {
+        break;
+      } else if (curr->key != this->NO_KEY && !cmp(hi, curr->key)) {
+        // curr is lower than lo, go right
+        prev = curr;
+        curr = rqProvider->read_addr(tid, &curr->right);
+        is_left_child = false;
+      } else {
+        // curr is larger than hi, go left
+        prev = curr;
+        curr = rqProvider->read_addr(tid, &curr->left);
+        is_left_child = true;
+      }
+    }
+
+    // Phase 2. Enter range
+    bool ok = is_left_child
+                  ? prev->left_bundle.getPtrByTimestamp(tid, ts, &curr)
+                  : prev->right_bundle.getPtrByTimestamp(tid, ts, &curr);
+
+    // Phase 3. Pass the leaves of the interesting subtrees to the visitor.
+    K from = lo;
+    if (ok && curr != nullptr) stack.push(curr);
+    while (ok && !stack.isEmpty()) {
+      Node<K, V> *node = stack.pop();
+      ok = node->left_bundle.getPtrByTimestamp(tid, ts, &left);
+      if (ok && left != nullptr) {
+        if (node->key != this->NO_KEY && !cmp(hi, node->key)) {
+          ok = node->right_bundle.getPtrByTimestamp(tid, ts, &right);
+          if (ok) stack.push(right);
+        }
+        if (ok && (node->key == this->NO_KEY || cmp(from, node->key))) {
+          stack.push(left);
+        }
+      } else if (ok && isInRange(node->key, lo, hi) &&
+                 !cursor.add(
+                     getKeys(tid, node, cursor.keys(), cursor.values()))) {
+        break;
+      }
+      if (!ok && cursor.resume()) {
+        while (!stack.isEmpty()) stack.pop();
+        from = cursor.last();
+        stack.push(root);
+        ok = true;
+      }
+    }
+    while (!stack.isEmpty()) stack.pop();
+    const bool done = ok || !cursor.restart();
+    if (done) cursor.flush();
+    rqProvider->end_traversal(tid);
+    recmgr->enterQuiescentState(tid);
+    if (done) return cursor.visited();
+  }
+}
+
 template <class K, class V, class Compare, class RecManager>
 const pair<V, bool> bundle_bst_ns::bundle_bst<K, V, Compare, RecManager>::find(
     const int tid, const K &key) {
@@ -208,6 +286,44 @@ const pair<V, bool> bundle_bst_ns::bundle_bst<K, V, Compare, RecManager>::find(
   return pair<V, bool>(NO_VALUE, false);
 }
 
+template <class K, class V, class Compare, class RecManager>
+int bundle_bst_ns::bundle_bst<K, V, Compare, RecManager>::multiGet(
+    const int tid, const K *const keys, const int n, V *const values) {
+  int idx[MULTIGET_GROUP_SIZE];
+  Node<K, V> *l[MULTIGET_GROUP_SIZE];
+  int found = 0;
+  auto start = [&](const int s, const int i) {
+    idx[s] = i;
+    Node<K, V> *p = rqProvider->read_addr(tid, &root->left);
+    // NULL if there are no keys in data structure
+    l[s] = rqProvider->read_addr(tid, &p->left);
+    MULTIGET_PREFETCH(l[s]);
+  };
+  auto step = [&](const int s) {
+    const K &key = keys[idx[s]];
+    Node<K, V> *curr = l[s];
+    Node<K, V> *left =
+        (curr == NULL) ? NULL : rqProvider->read_addr(tid, &curr->left);
+    if (left == NULL) {
+      if (curr != NULL && key == curr->key) {
+        values[idx[s]] = curr->value;
+        ++found;
+      } else {
+        values[idx[s]] = NO_VALUE;
+      }
+      return false;
+    }
+    l[s] = cmp(key, curr->key) ? left
+                               : rqProvider->read_addr(tid, &curr->right);
+    MULTIGET_PREFETCH(l[s]);
+    return true;
+  };
+  recmgr->leaveQuiescentState(tid, true);
+  multiget_run(n, start, step);
+  recmgr->enterQuiescentState(tid);
+  return found;
+}
+
 // template<class K, class V, class Compare, class RecManager>
 // const V bundle_bst_ns::bundle_bst<K,V,Compare,RecManager>::insert(const int
 // tid, const K& key, const V& val) {
@@ -372,22 +488,28 @@ inline bool bundle_bst_ns::bundle_bst<K, V, Compare, RecManager>::
         &GET_ALLOCATED_NODE_PTR(tid, 1)->right_bundle,
         nullptr};
     Node<K, V> *ptrs[] = {
+        GET_ALLOCATED_NODE_PTR(tid, 1),
         nullptr,
         nullptr,
         (l->key == NO_KEY || cmp(key, l->key)) ? GET_ALLOCATED_NODE_PTR(tid, 0)
                                                : l,
         (l->key == NO_KEY || cmp(key, l->key)) ? l
                                                : GET_ALLOCATED_NODE_PTR(tid, 0),
-        GET_ALLOCATED_NODE_PTR(tid, 1),
         nullptr};
-    rqProvider->prepare_bundles(bundles, ptrs);
+    rqProvider->prepare_bundles(tid, bundles, ptrs);
     timestamp_t ts = rqProvider->get_update_lin_time(tid);
 
     bool retval =
         scx(tid, info, (l == pleft ? &p->left : &p->right),
             GET_ALLOCATED_NODE_PTR(tid, 1), insertedNodes, deletedNodes);
 
-    rqProvider->finalize_bundles(bundles, ts);
+    // If the SCX failed, the new nodes are reused by the retry, so their
+    // bundles are emptied along with p's.
+    if (retval) {
+      rqProvider->finalize_bundles(bundles, ts);
+    } else {
+      rqProvider->abort_bundles(tid, bundles);
+    }
 
 // #ifndef NDEBUG
 //     l->validate();
@@ -484,8 +606,8 @@ inline bool bundle_bst_ns::bundle_bst<K, V, Compare, RecManager>::
         p == gpleft ? &gp->left_bundle : &gp->right_bundle,
         &GET_ALLOCATED_NODE_PTR(tid, 0)->left_bundle,
         &GET_ALLOCATED_NODE_PTR(tid, 0)->right_bundle, nullptr};
-    Node<K, V> *ptrs[] = {sleft, sright, GET_ALLOCATED_NODE_PTR(tid, 0), NULL};
-    rqProvider->prepare_bundles(bundles, ptrs);
+    Node<K, V> *ptrs[] = {GET_ALLOCATED_NODE_PTR(tid, 0), sleft, sright, NULL};
+    rqProvider->prepare_bundles(tid, bundles, ptrs);
     timestamp_t ts = rqProvider->get_update_lin_time(tid);
 
     Node<K, V> *insertedNodes[] = {GET_ALLOCATED_NODE_PTR(tid, 0), NULL};
@@ -494,7 +616,11 @@ inline bool bundle_bst_ns::bundle_bst<K, V, Compare, RecManager>::
         scx(tid, info, (p == gpleft ? &gp->left : &gp->right),
             GET_ALLOCATED_NODE_PTR(tid, 0), insertedNodes, deletedNodes);
 
-    rqProvider->finalize_bundles(bundles, ts);
+    if (retval) {
+      rqProvider->finalize_bundles(bundles, ts);
+    } else {
+      rqProvider->abort_bundles(tid, bundles);
+    }
     return retval;
   }
 }
@@ -514,8 +640,6 @@ bundle_bst_ns::Node<K, V>
   rqProvider->write_addr(tid, &newnode->right, right);
   newnode->scxRecord.store((uintptr_t)DUMMY_SCXRECORD, memory_order_relaxed);
   newnode->marked.store(false, memory_order_relaxed);
-  newnode->left_bundle.init();
-  newnode->right_bundle.init();
   return newnode;
 }
 
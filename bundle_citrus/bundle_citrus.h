@@ -40,6 +40,9 @@
 #define MAX_NODES_INSERTED_OR_DELETED_ATOMICALLY 4
 #endif
 #include "rq_provider.h"
+#include "rq_aggregate.h"
+#include "rq_cursor.h"
+#include "multiget.h"
 
 using namespace std;
 
@@ -130,8 +133,18 @@ class bundle_citrustree {
   const V insertIfAbsent(const int tid, const K& key, const V& value);
   const pair<V, bool> erase(const int tid, const K& key);
   const pair<V, bool> find(const int tid, const K& key);
+  // looks up keys[0..n-1] with interleaved traversals (see multiget.h);
+  // values[i] is NO_VALUE if keys[i] is absent. returns the number of keys
+  // found.
+  int multiGet(const int tid, const K* const keys, const int n,
+               V* const values);
   int rangeQuery(const int tid, const K& lo, const K& hi, K* const resultKeys,
                  V* const resultValues);
+  int rangeQueryAggregate(const int tid, const K& lo, const K& hi,
+                          RQAggregate<K>& aggregate);
+  template <typename Visitor>
+  int rangeQueryVisit(const int tid, const K& lo, const K& hi,
+                      Visitor& visitor);
   void cleanup(int tid);
   void startCleanup() { rqProvider->startCleanup(); }
   void stopCleanup() { rqProvider->stopCleanup(); }
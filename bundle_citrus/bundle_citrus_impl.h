@@ -60,8 +60,8 @@ nodeptr bundle_citrustree<K, V, RecManager>::newNode(const int tid, K key,
   nnode->tag[1] = 0;
   nnode->value = value;
   nnode->lock = false;
-  nnode->rqbundle[0].init();
-  nnode->rqbundle[1].init();
+  nnode->rqbundle[0].init(tid, rqProvider->get_entry_manager());
+  nnode->rqbundle[1].init(tid, rqProvider->get_entry_manager());
 #ifdef __HANDLE_STATS
   GSTATS_APPEND(tid, node_allocated_addresses, ((long long)nnode) % (1 << 12));
 #endif
@@ -104,7 +104,7 @@ bundle_citrustree<K, V, RecManager>::bundle_citrustree(
       &_root->rqbundle[0], &_root->rqbundle[1], &_rootchild->rqbundle[0],
       &_rootchild->rqbundle[1], nullptr};
   nodeptr ptrs[] = {_rootchild, nullptr, nullptr, nullptr, nullptr};
-  rqProvider->prepare_bundles(bundles, ptrs);
+  rqProvider->prepare_bundles(tid, bundles, ptrs);
 
   // Perform linearization point.
   timestamp_t lin_time =
@@ -153,12 +153,50 @@ const pair<V, bool> bundle_citrustree<K, V, RecManager>::find(const int tid,
   return pair<V, bool>(result, true);
 }
 
+template <typename K, typename V, class RecManager>
+int bundle_citrustree<K, V, RecManager>::multiGet(const int tid,
+                                                  const K* const keys,
+                                                  const int n,
+                                                  V* const values) {
+  int idx[MULTIGET_GROUP_SIZE];
+  nodeptr curr[MULTIGET_GROUP_SIZE];
+  int found = 0;
+  auto start = [&](const int s, const int i) {
+    idx[s] = i;
+    curr[s] = root->child[0];
+    MULTIGET_PREFETCH(curr[s]);
+  };
+  auto step = [&](const int s) {
+    const K& key = keys[idx[s]];
+    if (curr[s] == NULL) {
+      values[idx[s]] = NO_VALUE;
+      return false;
+    }
+    K ckey = curr[s]->key;
+    if (ckey == key) {
+      values[idx[s]] = curr[s]->value;
+      ++found;
+      return false;
+    }
+    curr[s] = curr[s]->child[ckey < key];
+    MULTIGET_PREFETCH(curr[s]);
+    return true;
+  };
+  recordmgr->leaveQuiescentState(tid, true);
+  readLock();
+  multiget_run(n, start, step);
+  readUnlock();
+  recordmgr->enterQuiescentState(tid);
+  return found;
+}
+
 template <typename K, typename V, class RecManager>
 bool bundle_citrustree<K, V, RecManager>::contains(const int tid,
                                                    const K& key) {
   // return find(tid, key).second;
   while (true) {
     recordmgr->leaveQuiescentState(tid, true);
+    rqProvider->start_read(tid);
     readLock();
     nodeptr curr = root->child[0];
     nodeptr pred = root;
@@ -199,12 +237,12 @@ bool bundle_citrustree<K, V, RecManager>::contains(const int tid,
 
     readUnlock();
     if (curr == NULL) {
-      rqProvider->end_traversal(tid);
+      rqProvider->end_read(tid);
       recordmgr->enterQuiescentState(tid);
       return false;
     }
     V result = curr->value;
-    rqProvider->end_traversal(tid);
+    rqProvider->end_read(tid);
     recordmgr->enterQuiescentState(tid);
     return true;
   }
@@ -281,7 +319,7 @@ retry:
         &nnode->rqbundle[0], &nnode->rqbundle[1], &prev->rqbundle[direction],
         nullptr};
     nodeptr ptrs[] = {nullptr, nullptr, nnode, nullptr};
-    rqProvider->prepare_bundles(bundles, ptrs);
+    rqProvider->prepare_bundles(tid, bundles, ptrs);
 
     // Perform linearization.
     timestamp_t lin_time = rqProvider->linearize_update_at_write(
@@ -354,7 +392,7 @@ retry:
                                                  &curr->rqbundle[0],
                                                  &curr->rqbundle[1], nullptr};
     nodeptr ptrs[] = {curr->child[1], root->child[0], root->child[0], nullptr};
-    rqProvider->prepare_bundles(bundles, ptrs);
+    rqProvider->prepare_bundles(tid, bundles, ptrs);
 
     // Perform linearization.
     timestamp_t lin_time = rqProvider->linearize_update_at_write(
@@ -385,7 +423,7 @@ retry:
                                                  &curr->rqbundle[0],
                                                  &curr->rqbundle[1], nullptr};
     nodeptr ptrs[] = {curr->child[0], root->child[0], root->child[0], nullptr};
-    rqProvider->prepare_bundles(bundles, ptrs);
+    rqProvider->prepare_bundles(tid, bundles, ptrs);
 
     // Perform linearization.
     timestamp_t lin_time = rqProvider->linearize_update_at_write(
@@ -451,7 +489,7 @@ retry:
                       root->child[0],
                       (prevSucc != curr ? succ->child[1] : nullptr),
                       nullptr};
-    rqProvider->prepare_bundles(bundles, ptrs);
+    rqProvider->prepare_bundles(tid, bundles, ptrs);
 
     // Perform linearization.
     timestamp_t lin_time = rqProvider->linearize_update_at_write(
@@ -599,6 +637,136 @@ int bundle_citrustree<K, V, RecManager>::rangeQuery(const int tid, const K& lo,
   }
 }
 
+// Same phases as rangeQuery, but the keys of the snapshot are folded into
+// `aggregate`.
+template <typename K, typename V, class RecManager>
+int bundle_citrustree<K, V, RecManager>::rangeQueryAggregate(
+    const int tid, const K& lo, const K& hi, RQAggregate<K>& aggregate) {
+  const long long count_before = aggregate.count;
+  recordmgr->leaveQuiescentState(tid, true);
+  nodeptr curr = root->child[0];
+  nodeptr pred = curr;
+  nodeptr left;
+  nodeptr right;
+  int direction = 0;
+  bool ok;
+  // Phase 1. Search for the root of the subtree defining the range.
+  while (curr != nullptr && (curr->key < lo || curr->key > hi)) {
+    pred = curr;
+    direction = (curr->key < lo) ? 1 : 0;
+    curr = curr->child[direction];
+  }
+
+  // Phase 2. Enter snapshot.
+  timestamp_t ts = rqProvider->start_traversal(tid);
+  ok = pred->rqbundle[direction].getPtrByTimestamp(tid, ts, &curr);
+  assert(ok);
+
+  // Phase 3. Enter range.
+  while (curr != nullptr && (curr->key < lo || curr->key > hi)) {
+    ok = pred->rqbundle[(curr->key < lo) ? 1 : 0].getPtrByTimestamp(tid, ts,
+                                                                     &curr);
+    assert(ok);
+    pred = curr;
+  }
+
+  // Phase 4. Aggregate the subtree rooted at curr.
+  if (curr != nullptr) {
+    block<node_t<K, V>> stack(nullptr);
+    stack.push(curr);
+    while (!stack.isEmpty()) {
+      nodeptr node = stack.pop();
+      rqProvider->traversal_try_add(tid, node, aggregate, lo, hi);
+      ok = node->rqbundle[0].getPtrByTimestamp(tid, ts, &left);
+      assert(ok);
+      ok = node->rqbundle[1].getPtrByTimestamp(tid, ts, &right);
+      assert(ok);
+      if (left != nullptr && lo < node->key) {
+        stack.push(left);
+      }
+      if (right != nullptr && hi > node->key) {
+        stack.push(right);
+      }
+    }
+  }
+  rqProvider->end_traversal(tid);
+  recordmgr->enterQuiescentState(tid);
+  return aggregate.count - count_before;
+}
+
+// Same phases as rangeQuery, but the subtree is walked in order (left subtree,
+// node, right subtree) so that keys reach the visitor in increasing order. It
+// can only restart until the first batch of keys has been passed to the
+// visitor. After that, a failed bundle lookup makes it walk the snapshot again
+// from the root, skipping the subtrees below the last key added.
+template <typename K, typename V, class RecManager>
+template <typename Visitor>
+int bundle_citrustree<K, V, RecManager>::rangeQueryVisit(const int tid,
+                                                         const K& lo,
+                                                         const K& hi,
+                                                         Visitor& visitor) {
+  RQCursor<K, V, Visitor> cursor(visitor);
+  block<node_t<K, V>> stack(nullptr);
+  for (;;) {
+    recordmgr->leaveQuiescentState(tid, true);
+    nodeptr curr = root->child[0];
+    nodeptr pred = curr;
+    int direction = 0;
+    // Phase 1. Search for the root of the subtree defining the range.
+    while (curr != nullptr && (curr->key < lo || curr->key > hi)) {
+      pred = curr;
+      direction = (curr->key < lo) ? 1 : 0;
+      curr = curr->child[direction];
+    }
+
+    // Phase 2. Enter snapshot.
+    timestamp_t ts = rqProvider->start_traversal(tid);
+    bool ok = pred->rqbundle[direction].getPtrByTimestamp(tid, ts, &curr);
+    K from = lo;
+    while (ok) {
+      // Phase 3. Enter range.
+      while (ok && curr != nullptr && (curr->key < from || curr->key > hi)) {
+        ok = curr->rqbundle[(curr->key < from) ? 1 : 0].getPtrByTimestamp(
+            tid, ts, &curr);
+      }
+
+      // Phase 4. Pass the subtree rooted at curr to the visitor, in order.
+      bool more = true;
+      while (ok && more && (curr != nullptr || !stack.isEmpty())) {
+        if (curr != nullptr) {
+          stack.push(curr);
+          if (from < curr->key) {
+            ok = curr->rqbundle[0].getPtrByTimestamp(tid, ts, &curr);
+          } else {
+            curr = nullptr;
+          }
+          continue;
+        }
+        nodeptr node = stack.pop();
+        if (node->key > hi) break;
+        if (!(node->key < from)) {
+          more = cursor.add(getKeys(tid, node, cursor.keys(), cursor.values()));
+        }
+        if (node->key < hi) {
+          ok = node->rqbundle[1].getPtrByTimestamp(tid, ts, &curr);
+        } else {
+          more = false;
+        }
+      }
+      while (!stack.isEmpty()) stack.pop();
+      if (ok || !cursor.resume()) break;
+      from = cursor.last();
+      curr = root->child[0];
+      ok = true;
+    }
+    const bool done = ok || !cursor.restart();
+    if (done) cursor.flush();
+    rqProvider->end_traversal(tid);
+    recordmgr->enterQuiescentState(tid);
+    if (done) return cursor.visited();
+  }
+}
+
 template <typename K, typename V, class RecManager>
 void bundle_citrustree<K, V, RecManager>::cleanup(int tid) {
   recordmgr->leaveQuiescentState(tid, true);
@@ -625,6 +793,7 @@ void bundle_citrustree<K, V, RecManager>::cleanup(int tid) {
     BUNDLE_CLEAN_BUNDLE(node->rqbundle[0]);
     BUNDLE_CLEAN_BUNDLE(node->rqbundle[1]);
   }
+  BUNDLE_FINISH_CLEANUP(rqProvider);
   recordmgr->enterQuiescentState(tid);
 }
 
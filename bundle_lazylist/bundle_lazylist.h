@@ -10,6 +10,7 @@
 #endif
 #include "bundle_lazylist_impl.h"
 #include "rq_provider.h"
+#include "rq_cursor.h"
 
 template <typename K, typename V>
 class node_t;
@@ -55,6 +56,9 @@ class bundle_lazylist {
   V erase(const int tid, const K& key);
   int rangeQuery(const int tid, const K& lo, const K& hi, K* const resultKeys,
                  V* const resultValues);
+  template <typename Visitor>
+  int rangeQueryVisit(const int tid, const K& lo, const K& hi,
+                      Visitor& visitor);
   void cleanup(int tid);
   void startCleanup() { rqProvider->startCleanup(); }
   void stopCleanup() { rqProvider->stopCleanup(); }
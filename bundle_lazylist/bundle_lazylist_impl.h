@@ -75,7 +75,7 @@ bundle_lazylist<K, V, RecManager>::bundle_lazylist(const int numProcesses,
   // Perform linearization of max to ensure bundles correctly added.
   BUNDLE_TYPE_DECL<node_t<K, V>> *bundles[] = {&head->rqbundle, nullptr};
   nodeptr ptrs[] = {max, nullptr};
-  rqProvider->prepare_bundles(bundles, ptrs);
+  rqProvider->prepare_bundles(tid, bundles, ptrs);
   timestamp_t lin_time =
       rqProvider->linearize_update_at_write(tid, &head->next, max);
   rqProvider->finalize_bundles(bundles, lin_time);
@@ -135,7 +135,7 @@ nodeptr bundle_lazylist<K, V, RecManager>::new_node(const int tid, const K &key,
   nnode->next = next;
   nnode->marked = 0LL;
   nnode->lock = false;
-  nnode->rqbundle.init();
+  nnode->rqbundle.init(tid, rqProvider->get_entry_manager());
 #ifdef __HANDLE_STATS
   GSTATS_APPEND(tid, node_allocated_addresses, ((long long)nnode) % (1 << 12));
 #endif
@@ -154,6 +154,7 @@ bool bundle_lazylist<K, V, RecManager>::contains(const int tid, const K &key) {
   bool ok;
   while (true) {
     recordmgr->leaveQuiescentState(tid, true);
+    rqProvider->start_read(tid);
 
     nodeptr curr = head;
     nodeptr pred = curr;
@@ -175,6 +176,7 @@ bool bundle_lazylist<K, V, RecManager>::contains(const int tid, const K &key) {
     if ((curr->key == key) && !curr->marked) {
       res = curr->val;
     }
+    rqProvider->end_read(tid);
     recordmgr->enterQuiescentState(tid);
     return (res != NO_VALUE);
   }
@@ -226,7 +228,7 @@ V bundle_lazylist<K, V, RecManager>::doInsert(const int tid, const K &key,
       BUNDLE_TYPE_DECL<node_t<K, V>> *bundles[] = {&newnode->rqbundle,
                                                    &pred->rqbundle, nullptr};
       nodeptr ptrs[] = {curr, newnode, nullptr};
-      rqProvider->prepare_bundles(bundles, ptrs);
+      rqProvider->prepare_bundles(tid, bundles, ptrs);
       SOFTWARE_BARRIER;
 
       // Perform original linearization.
@@ -235,6 +237,9 @@ V bundle_lazylist<K, V, RecManager>::doInsert(const int tid, const K &key,
 
       // Finalize bundles.
       rqProvider->finalize_bundles(bundles, lin_time);
+#if defined USE_RQ_DEBUGGING
+      DEBUG_RECORD_UPDATE_KEY(tid, lin_time, key, 1);
+#endif
 
       // Release locks and return.
       releaseLock(&(newnode->lock));
@@ -283,7 +288,7 @@ V bundle_lazylist<K, V, RecManager>::erase(const int tid, const K &key) {
       BUNDLE_TYPE_DECL<node_t<K, V>> *bundles[] = {&pred->rqbundle,
                                                    &curr->rqbundle, nullptr};
       nodeptr ptrs[] = {c_nxt, head, nullptr};
-      rqProvider->prepare_bundles(bundles, ptrs);
+      rqProvider->prepare_bundles(tid, bundles, ptrs);
 
       // Perform original linearization point.
       timestamp_t lin_time =
@@ -291,6 +296,9 @@ V bundle_lazylist<K, V, RecManager>::erase(const int tid, const K &key) {
 
       // Finalize bundles.
       rqProvider->finalize_bundles(bundles, lin_time);
+#if defined USE_RQ_DEBUGGING
+      DEBUG_RECORD_UPDATE_KEY(tid, lin_time, key, -1);
+#endif
 
       pred->next = c_nxt;
       nodeptr deletedNodes[] = {curr, nullptr};
@@ -371,24 +379,82 @@ int bundle_lazylist<K, V, RecManager>::rangeQuery(const int tid, const K &lo,
 
     // Traversal was completed successfully.
     if (curr != nullptr) {
+#if defined USE_RQ_DEBUGGING
+      // depending on the clock, updates at ts itself may or may not be visible
+      DEBUG_RECORD_RQ_RESULT(tid, ts, ts, lo, hi, resultKeys, cnt);
+#endif
       return cnt;
     }
   }
 }
 
+// Follows rangeQuery, except that it can only restart until the first batch of
+// keys has been passed to the visitor. Nodes reached through bundles at ts were
+// in the list at ts, so once the range is entered bundle lookups should
+// succeed. If one fails anyway, the snapshot is walked again from the head.
+template <typename K, typename V, class RecManager>
+template <typename Visitor>
+int bundle_lazylist<K, V, RecManager>::rangeQueryVisit(const int tid,
+                                                       const K &lo, const K &hi,
+                                                       Visitor &visitor) {
+  RQCursor<K, V, Visitor> cursor(visitor);
+  for (;;) {
+    recordmgr->leaveQuiescentState(tid, true);
+
+    // Phase 1. Traverse to node immediately preceding range.
+    nodeptr curr = head;
+    nodeptr pred = curr;
+    while (curr->key < lo) {
+      pred = curr;
+      curr = curr->next;
+    }
+
+    // Phase 2. Enter range using bundles.
+    timestamp_t ts = rqProvider->start_traversal(tid);
+    bool ok = enterSnapshot(tid, pred, ts, &curr);
+    while (ok && curr->key < lo) {
+      ok = curr->rqbundle.getPtrByTimestamp(tid, ts, &curr);
+    }
+
+    // Phase 3. Pass the snapshot to the visitor.
+    while (ok && curr->key <= hi) {
+      if (!cursor.add(getKeys(tid, curr, cursor.keys(), cursor.values()))) {
+        break;
+      }
+      ok = curr->rqbundle.getPtrByTimestamp(tid, ts, &curr);
+      if (!ok && cursor.resume()) {
+        ok = enterSnapshot(tid, head, ts, &curr);
+        while (ok && curr->key < cursor.last()) {
+          ok = curr->rqbundle.getPtrByTimestamp(tid, ts, &curr);
+        }
+      }
+    }
+    const bool done = ok || !cursor.restart();
+    if (done) cursor.flush();
+    rqProvider->end_traversal(tid);
+    recordmgr->enterQuiescentState(tid);
+    if (done) return cursor.visited();
+#ifdef __HANDLE_STATS
+    GSTATS_ADD(tid, bundle_restarts, 1);
+#endif
+  }
+}
+
 template <typename K, typename V, class RecManager>
 void bundle_lazylist<K, V, RecManager>::cleanup(int tid) {
   // Walk the list using the newest edge and reclaim bundle entries.
   recordmgr->leaveQuiescentState(tid);
   BUNDLE_INIT_CLEANUP(rqProvider);
   if (head == nullptr) {
+    BUNDLE_FINISH_CLEANUP(rqProvider);
     recordmgr->enterQuiescentState(tid);
     return;
   }
-  BUNDLE_CLEAN_BUNDLE(&head->rqbundle);
+  BUNDLE_CLEAN_BUNDLE(head->rqbundle);
   for (nodeptr curr = head->next; curr->key != KEY_MAX; curr = curr->next) {
     BUNDLE_CLEAN_BUNDLE(curr->rqbundle);
   }
+  BUNDLE_FINISH_CLEANUP(rqProvider);
   recordmgr->enterQuiescentState(tid);
 }
 
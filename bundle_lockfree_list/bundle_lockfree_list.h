@@ -0,0 +1,140 @@
+// A bundled version of the lock-free (Harris) list in 'lockfree_list'.
+//
+// Every node has a bundle that holds the versions of its next pointer. Since
+// the list takes no node locks, each bundle is prepared with BUNDLE_LOCKFREE,
+// and a node's next pointer is only changed by the update that holds the
+// pending entry of its bundle. That entry is not helped, so it works as a lock
+// on the pointer: other updates of it, and range queries that read the bundle,
+// wait for the update to finalize or abort it. The bundled list is therefore
+// blocking, unlike the list it is built from.
+//
+// Helping would have to abort a stalled update whose CAS has not happened yet,
+// which means making that CAS fail. A plain CAS on next cannot do that; every
+// update of next would have to become a DCSS that also checks the state of its
+// pending entry (see dcss_plus/), and every read of next would have to help
+// such descriptors.
+//
+// Deleting a node adds an entry with a marked pointer to its own bundle, so a
+// range query that reaches the node at a later time skips its key. Unlinking a
+// marked node adds an entry to its predecessor's bundle.
+
+#ifndef BUNDLE_LOCKFREE_LIST_H
+#define BUNDLE_LOCKFREE_LIST_H
+
+#include <stack>
+#include <unordered_set>
+
+#ifndef MAX_NODES_INSERTED_OR_DELETED_ATOMICALLY
+// define BEFORE including rq_provider.h
+#define MAX_NODES_INSERTED_OR_DELETED_ATOMICALLY 4
+#endif
+#include "rq_provider.h"
+#include "rq_cursor.h"
+
+#ifndef BUNDLE_LOCKFREE
+#error "bundle_lflist requires BUNDLE_LOCKFREE"
+#endif
+
+template <typename K, typename V>
+class node_t;
+#define nodeptr node_t<K, V>*
+
+#ifndef casword_t
+#define casword_t intptr_t
+#endif
+
+template <typename K, typename V, class RecManager>
+class bundle_lflist {
+ private:
+  RecManager* const recordmgr;
+  RQProvider<K, V, node_t<K, V>, bundle_lflist<K, V, RecManager>, RecManager,
+             true, true>* const rqProvider;
+#ifdef USE_DEBUGCOUNTERS
+  debugCounters* const counters;
+#endif
+  nodeptr head;
+
+  nodeptr new_node(const int tid, const K& key, const V& val, nodeptr next);
+  bool unlink(const int tid, nodeptr pred, nodeptr curr, nodeptr succ);
+  bool enterSnapshot(const int tid, nodeptr pred, timestamp_t ts,
+                     nodeptr* next);
+  long long debugKeySum(nodeptr head);
+
+  V doInsert(const int tid, const K& key, const V& value, bool onlyIfAbsent);
+
+  int init[MAX_TID_POW2] = {
+      0,
+  };
+
+ public:
+  const K KEY_MIN;
+  const K KEY_MAX;
+  const V NO_VALUE;
+  bundle_lflist(int numProcesses, const K KEY_MIN, const K KEY_MAX,
+                const V NO_VALUE);
+  ~bundle_lflist();
+  bool contains(const int tid, const K& key);
+  V insert(const int tid, const K& key, const V& value) {
+    return doInsert(tid, key, value, false);
+  }
+  V insertIfAbsent(const int tid, const K& key, const V& value) {
+    return doInsert(tid, key, value, true);
+  }
+  V erase(const int tid, const K& key);
+  int rangeQuery(const int tid, const K& lo, const K& hi, K* const resultKeys,
+                 V* const resultValues);
+  template <typename Visitor>
+  int rangeQueryVisit(const int tid, const K& lo, const K& hi,
+                      Visitor& visitor);
+  void cleanup(int tid);
+  void startCleanup() { rqProvider->startCleanup(); }
+  void stopCleanup() { rqProvider->stopCleanup(); }
+  bool validateBundles(int tid);
+
+  /**
+   * This function must be called once by each thread that will
+   * invoke any functions on this class.
+   *
+   * It must be okay that we do this with the main thread and later with another
+   * thread!!!
+   */
+  void initThread(const int tid);
+  void deinitThread(const int tid);
+#ifdef USE_DEBUGCOUNTERS
+  debugCounters* debugGetCounters() { return counters; }
+  void clearCounters() { counters->clear(); }
+#endif
+  long long debugKeySum();
+  bool validate(const long long keysum, const bool checkkeysum);
+  long long getSize();
+  long long getSizeInNodes();
+  string getSizeString() {
+    stringstream ss;
+    ss << getSizeInNodes() << " nodes in data structure";
+    return ss.str();
+  }
+  RecManager* debugGetRecMgr() { return recordmgr; }
+
+  inline int getKeys(const int tid, node_t<K, V>* node, K* const outputKeys,
+                     V* const outputValues) {
+    // ignore marked
+    outputKeys[0] = node->key;
+    outputValues[0] = node->val;
+    return 1;
+  }
+
+  inline bool isInRange(const K& key, const K& lo, const K& hi) {
+    return (lo <= key && key <= hi);
+  }
+  inline bool isLogicallyDeleted(const int tid, node_t<K, V>* node);
+
+  inline bool isLogicallyInserted(const int tid, node_t<K, V>* node) {
+    return true;
+  }
+
+  node_t<K, V>* debug_getEntryPoint() { return head; }
+
+  string getBundleStatsString();
+};
+
+#endif /* BUNDLE_LOCKFREE_LIST_H */
@@ -0,0 +1,550 @@
+// This is the implementation of a bundled lock-free list, building off of the
+// implementation provided by Arbel-Raviv and Brown (see the 'lockfree_list'
+// directory for more information on it).
+
+#ifndef BUNDLE_LOCKFREE_LIST_IMPL_H
+#define BUNDLE_LOCKFREE_LIST_IMPL_H
+
+#include <cassert>
+#include <csignal>
+
+#include "bundle_lockfree_list.h"
+
+#define MARK_BIT 0x2
+#define BOOL_CAS __sync_bool_compare_and_swap
+
+template <typename K, typename V>
+class node_t {
+ public:
+  K key;
+  volatile V val;
+  nodeptr volatile next;
+  BUNDLE_TYPE_DECL<node_t<K, V>> rqbundle;
+
+  template <typename RQProvider>
+  bool isMarked(const int tid, RQProvider *const prov) {
+    return ((casword_t)(prov->read_addr(tid, &next)) & MARK_BIT);
+  }
+
+  bool validate() {
+    timestamp_t ts;
+    return next == rqbundle.first(ts);
+  }
+};
+
+template <typename K, typename V>
+inline bool isMarked(nodeptr val) {
+  return ((casword_t)val & MARK_BIT);
+}
+template <typename K, typename V>
+inline nodeptr getUnmarked(nodeptr val) {
+  return (nodeptr)((casword_t)val & ~MARK_BIT);
+}
+template <typename K, typename V>
+inline nodeptr getMarked(nodeptr val) {
+  return (nodeptr)((casword_t)val | MARK_BIT);
+}
+
+template <typename K, typename V, class RecManager>
+bundle_lflist<K, V, RecManager>::bundle_lflist(const int numProcesses,
+                                               const K _KEY_MIN,
+                                               const K _KEY_MAX,
+                                               const V _NO_VALUE)
+    : recordmgr(new RecManager(numProcesses, SIGQUIT)),
+      rqProvider(
+          new RQProvider<K, V, node_t<K, V>, bundle_lflist<K, V, RecManager>,
+                         RecManager, true, true>(numProcesses, this,
+                                                 recordmgr))
+#ifdef USE_DEBUGCOUNTERS
+      ,
+      counters(new debugCounters(numProcesses))
+#endif
+      ,
+      KEY_MIN(_KEY_MIN),
+      KEY_MAX(_KEY_MAX),
+      NO_VALUE(_NO_VALUE) {
+  const int tid = 0;
+  initThread(tid);
+  nodeptr max = new_node(tid, KEY_MAX, 0, NULL);
+  head = new_node(tid, KEY_MIN, 0, NULL);
+
+  // Perform linearization of max to ensure bundles correctly added.
+  BUNDLE_TYPE_DECL<node_t<K, V>> *bundles[] = {&head->rqbundle, nullptr};
+  nodeptr ptrs[] = {max, nullptr};
+  rqProvider->prepare_bundles(tid, bundles, ptrs);
+  timestamp_t lin_time =
+      rqProvider->linearize_update_at_write(tid, &head->next, max);
+  rqProvider->finalize_bundles(bundles, lin_time);
+}
+
+template <typename K, typename V, class RecManager>
+bundle_lflist<K, V, RecManager>::~bundle_lflist() {
+  const int dummyTid = 0;
+  nodeptr curr = head;
+  while (curr->key < KEY_MAX) {
+    nodeptr next = getUnmarked(curr->next);
+    recordmgr->deallocate(dummyTid, curr);
+    curr = next;
+  }
+  recordmgr->deallocate(dummyTid, curr);
+  delete rqProvider;
+  recordmgr->printStatus();
+  delete recordmgr;
+#ifdef USE_DEBUGCOUNTERS
+  delete counters;
+#endif
+}
+
+template <typename K, typename V, class RecManager>
+void bundle_lflist<K, V, RecManager>::initThread(const int tid) {
+  if (init[tid])
+    return;
+  else
+    init[tid] = !init[tid];
+
+  recordmgr->initThread(tid);
+  rqProvider->initThread(tid);
+}
+
+template <typename K, typename V, class RecManager>
+void bundle_lflist<K, V, RecManager>::deinitThread(const int tid) {
+  if (!init[tid])
+    return;
+  else
+    init[tid] = !init[tid];
+
+  recordmgr->deinitThread(tid);
+  rqProvider->deinitThread(tid);
+}
+
+template <typename K, typename V, class RecManager>
+nodeptr bundle_lflist<K, V, RecManager>::new_node(const int tid, const K &key,
+                                                  const V &val, nodeptr next) {
+  nodeptr nnode = recordmgr->template allocate<node_t<K, V>>(tid);
+  if (nnode == NULL) {
+    cout << "out of memory" << endl;
+    exit(1);
+  }
+  nnode->key = key;
+  nnode->val = val;
+  nnode->next = next;
+  nnode->rqbundle.init(tid, rqProvider->get_entry_manager());
+#ifdef __HANDLE_STATS
+  GSTATS_APPEND(tid, node_allocated_addresses, ((long long)nnode) % (1 << 12));
+#endif
+  return nnode;
+}
+
+// Physically deletes the marked node curr, whose successor is succ. Range
+// queries older than the unlink still reach curr through pred's bundle and
+// see that it is deleted in curr's own bundle.
+template <typename K, typename V, class RecManager>
+bool bundle_lflist<K, V, RecManager>::unlink(const int tid, nodeptr pred,
+                                             nodeptr curr, nodeptr succ) {
+  assert(isMarked(curr->next));
+  BUNDLE_TYPE_DECL<node_t<K, V>> *bundles[] = {&pred->rqbundle, nullptr};
+  nodeptr ptrs[] = {succ, nullptr};
+  rqProvider->prepare_bundles(tid, bundles, ptrs);
+  timestamp_t lin_time = rqProvider->get_update_lin_time(tid);
+
+  nodeptr deletedNodes[] = {curr, nullptr};
+  rqProvider->announce_physical_deletion(tid, deletedNodes);
+  if (BOOL_CAS(&pred->next, curr, succ)) {
+    rqProvider->finalize_bundles(bundles, lin_time);
+    rqProvider->physical_deletion_succeeded(tid, deletedNodes);
+    return true;
+  }
+  rqProvider->abort_bundles(tid, bundles);
+  rqProvider->physical_deletion_failed(tid, deletedNodes);
+  return false;
+}
+
+template <typename K, typename V, class RecManager>
+bool bundle_lflist<K, V, RecManager>::contains(const int tid, const K &key) {
+  recordmgr->leaveQuiescentState(tid, true);
+  nodeptr curr = head->next;
+  while (curr->key < key) {
+    curr = getUnmarked(curr->next);
+  }
+  const bool res = (curr->key == key) && !isMarked(curr->next);
+  recordmgr->enterQuiescentState(tid);
+  return res;
+}
+
+template <typename K, typename V, class RecManager>
+V bundle_lflist<K, V, RecManager>::doInsert(const int tid, const K &key,
+                                            const V &val, bool onlyIfAbsent) {
+  nodeptr pred;
+  nodeptr curr;
+  nodeptr succ;
+  nodeptr node;
+  while (true) {
+  retry_insert:
+    recordmgr->leaveQuiescentState(tid);
+    pred = head;
+    curr = head->next;  // head is never marked
+    while (true) {
+      nodeptr succ_field = curr->next;
+      succ = getUnmarked(succ_field);
+      while (isMarked(succ_field)) {
+        if (!unlink(tid, pred, curr, succ)) {
+          recordmgr->enterQuiescentState(tid);
+          goto retry_insert;
+        }
+        curr = succ;
+        succ_field = curr->next;
+        succ = getUnmarked(succ_field);
+      }
+      if (curr->key >= key) break;
+      pred = curr;
+      curr = succ;
+    }
+    if (curr->key == key) {
+      if (onlyIfAbsent) {
+        V result = curr->val;
+        recordmgr->enterQuiescentState(tid);
+        return result;
+      }
+      cout << "ERROR: insert-replace functionality not implemented for "
+              "bundle_lflist at this time."
+           << endl;
+      exit(-1);
+    }
+    node = new_node(tid, key, val, curr);
+
+    // Prepare bundles. Holding the pending entry of pred's bundle keeps other
+    // updates from changing pred->next until it is finalized or aborted.
+    BUNDLE_TYPE_DECL<node_t<K, V>> *bundles[] = {&node->rqbundle,
+                                                 &pred->rqbundle, nullptr};
+    nodeptr ptrs[] = {curr, node, nullptr};
+    rqProvider->prepare_bundles(tid, bundles, ptrs);
+    timestamp_t lin_time = rqProvider->get_update_lin_time(tid);
+
+    nodeptr insertedNodes[] = {node, nullptr};
+    nodeptr deletedNodes[] = {nullptr};
+    if (rqProvider->linearize_update_at_cas(tid, &pred->next, curr, node,
+                                            insertedNodes,
+                                            deletedNodes) == curr) {
+      rqProvider->finalize_bundles(bundles, lin_time);
+#if defined USE_RQ_DEBUGGING
+      DEBUG_RECORD_UPDATE_KEY(tid, lin_time, key, 1);
+#endif
+      recordmgr->enterQuiescentState(tid);
+      return NO_VALUE;
+    }
+    rqProvider->abort_bundles(tid, bundles);
+    recordmgr->deallocate(tid, node);
+    recordmgr->enterQuiescentState(tid);
+  }
+}
+
+template <typename K, typename V, class RecManager>
+V bundle_lflist<K, V, RecManager>::erase(const int tid, const K &key) {
+  nodeptr pred;
+  nodeptr curr;
+  nodeptr succ;
+  while (true) {
+  retry_erase:
+    recordmgr->leaveQuiescentState(tid);
+    pred = head;
+    curr = head->next;  // head is never marked
+    while (true) {
+      nodeptr succ_field = curr->next;
+      succ = getUnmarked(succ_field);
+      while (isMarked(succ_field)) {
+        if (!unlink(tid, pred, curr, succ)) {
+          recordmgr->enterQuiescentState(tid);
+          goto retry_erase;
+        }
+        curr = succ;
+        succ_field = curr->next;
+        succ = getUnmarked(succ_field);
+      }
+      if (curr->key >= key) break;
+      pred = curr;
+      curr = succ;
+    }
+
+    if (curr->key != key) {
+      recordmgr->enterQuiescentState(tid);
+      return NO_VALUE;
+    }
+
+    // Logical deletion. The marked pointer in curr's bundle tells range
+    // queries at lin_time or later that curr is deleted.
+    BUNDLE_TYPE_DECL<node_t<K, V>> *bundles[] = {&curr->rqbundle, nullptr};
+    nodeptr ptrs[] = {getMarked(succ), nullptr};
+    rqProvider->prepare_bundles(tid, bundles, ptrs);
+    timestamp_t lin_time = rqProvider->get_update_lin_time(tid);
+
+    nodeptr insertedNodes[] = {nullptr};
+    nodeptr deletedNodes[] = {curr, nullptr};
+    if (rqProvider->linearize_update_at_cas(tid, &curr->next, succ,
+                                            getMarked(succ), insertedNodes,
+                                            deletedNodes) == succ) {
+      rqProvider->finalize_bundles(bundles, lin_time);
+#if defined USE_RQ_DEBUGGING
+      DEBUG_RECORD_UPDATE_KEY(tid, lin_time, key, -1);
+#endif
+      V result = curr->val;
+
+      // attempt physical deletion of the marked node once
+      // if we fail, threads will simply attempt physical deletion if they
+      // encounter the node
+      unlink(tid, pred, curr, succ);
+      recordmgr->enterQuiescentState(tid);
+      return result;
+    }
+    rqProvider->abort_bundles(tid, bundles);
+    recordmgr->enterQuiescentState(tid);
+  }
+}
+
+// Sets *next to the successor of pred at time ts. Returns false if pred is
+// not in the snapshot (it was inserted after ts, or deleted at or before ts,
+// in which case its successors at ts may not be reachable from it).
+template <typename K, typename V, class RecManager>
+inline bool bundle_lflist<K, V, RecManager>::enterSnapshot(const int tid,
+                                                           nodeptr pred,
+                                                           timestamp_t ts,
+                                                           nodeptr *next) {
+  return pred->rqbundle.getPtrByTimestamp(tid, ts, next) && !isMarked(*next);
+}
+
+template <typename K, typename V, class RecManager>
+int bundle_lflist<K, V, RecManager>::rangeQuery(const int tid, const K &lo,
+                                                const K &hi,
+                                                K *const resultKeys,
+                                                V *const resultValues) {
+  timestamp_t ts;
+  int cnt;
+  bool ok;
+  for (;;) {
+    recordmgr->leaveQuiescentState(tid, true);
+
+    // Phase 1. Traverse to node immediately preceding range.
+    nodeptr curr = head;
+    nodeptr pred = curr;
+    while (curr->key < lo) {
+      pred = curr;
+      curr = getUnmarked(curr->next);
+    }
+
+    // Phase 2. Enter range using bundles, from the head if pred is not in the
+    // snapshot.
+    ts = rqProvider->start_traversal(tid);
+    if (!enterSnapshot(tid, pred, ts, &curr)) {
+#ifdef __HANDLE_STATS
+      GSTATS_ADD(tid, bundle_restarts, 1);
+#endif
+      ok = enterSnapshot(tid, head, ts, &curr);
+      assert(ok);
+    }
+
+    // Phase 3. Range collect, skipping nodes deleted at ts.
+    cnt = 0;
+    ok = true;
+    while (curr->key <= hi) {
+      nodeptr next;
+      ok = curr->rqbundle.getPtrByTimestamp(tid, ts, &next);
+      if (!ok) break;
+      if (!isMarked(next) && curr->key >= lo) {
+        cnt += getKeys(tid, curr, resultKeys + cnt, resultValues + cnt);
+      }
+      curr = getUnmarked(next);
+    }
+
+    rqProvider->end_traversal(tid);
+    recordmgr->enterQuiescentState(tid);
+
+    // Traversal was completed successfully.
+    if (ok) {
+#if defined USE_RQ_DEBUGGING
+      // depending on the clock, updates at ts itself may or may not be visible
+      DEBUG_RECORD_RQ_RESULT(tid, ts, ts, lo, hi, resultKeys, cnt);
+#endif
+      return cnt;
+    }
+  }
+}
+
+// Follows rangeQuery, except that it can only restart until the first batch of
+// keys has been passed to the visitor. Nodes reached through bundles at ts were
+// in the list at ts, so once the range is entered bundle lookups should
+// succeed. If one fails anyway, the snapshot is walked again from the head.
+template <typename K, typename V, class RecManager>
+template <typename Visitor>
+int bundle_lflist<K, V, RecManager>::rangeQueryVisit(const int tid,
+                                                     const K &lo, const K &hi,
+                                                     Visitor &visitor) {
+  RQCursor<K, V, Visitor> cursor(visitor);
+  for (;;) {
+    recordmgr->leaveQuiescentState(tid, true);
+
+    // Phase 1. Traverse to node immediately preceding range.
+    nodeptr curr = head;
+    nodeptr pred = curr;
+    while (curr->key < lo) {
+      pred = curr;
+      curr = getUnmarked(curr->next);
+    }
+
+    // Phase 2. Enter range using bundles, from the head if pred is not in the
+    // snapshot.
+    timestamp_t ts = rqProvider->start_traversal(tid);
+    bool ok = enterSnapshot(tid, pred, ts, &curr);
+    if (!ok) {
+#ifdef __HANDLE_STATS
+      GSTATS_ADD(tid, bundle_restarts, 1);
+#endif
+      ok = enterSnapshot(tid, head, ts, &curr);
+      assert(ok);
+    }
+
+    // Phase 3. Pass the snapshot to the visitor, skipping nodes deleted at ts.
+    while (ok && curr->key <= hi) {
+      nodeptr next;
+      ok = curr->rqbundle.getPtrByTimestamp(tid, ts, &next);
+      if (!ok) {
+        // The cursor drops the keys it has already added.
+        if (!cursor.resume()) break;
+        ok = enterSnapshot(tid, head, ts, &curr);
+        continue;
+      }
+      if (!isMarked(next) && curr->key >= lo) {
+        if (!cursor.add(getKeys(tid, curr, cursor.keys(), cursor.values()))) {
+          break;
+        }
+      }
+      curr = getUnmarked(next);
+    }
+    const bool done = ok || !cursor.restart();
+    if (done) cursor.flush();
+    rqProvider->end_traversal(tid);
+    recordmgr->enterQuiescentState(tid);
+    if (done) return cursor.visited();
+  }
+}
+
+template <typename K, typename V, class RecManager>
+void bundle_lflist<K, V, RecManager>::cleanup(int tid) {
+  // Walk the list using the newest edge and reclaim bundle entries.
+  recordmgr->leaveQuiescentState(tid);
+  BUNDLE_INIT_CLEANUP(rqProvider);
+  BUNDLE_CLEAN_BUNDLE(head->rqbundle);
+  for (nodeptr curr = getUnmarked(head->next); curr->key != KEY_MAX;
+       curr = getUnmarked(curr->next)) {
+    BUNDLE_CLEAN_BUNDLE(curr->rqbundle);
+  }
+  BUNDLE_FINISH_CLEANUP(rqProvider);
+  recordmgr->enterQuiescentState(tid);
+}
+
+template <typename K, typename V, class RecManager>
+bool bundle_lflist<K, V, RecManager>::validateBundles(int tid) {
+  bool valid = true;
+#ifdef BUNDLE_DEBUG
+  for (nodeptr curr = head; curr->key < KEY_MAX;
+       curr = getUnmarked(curr->next)) {
+    if (!curr->validate()) {
+      std::cout << "Pointer mismatch! [key=" << curr->key << "] "
+                << curr->rqbundle.dump(0) << std::flush;
+      valid = false;
+    }
+  }
+#endif
+  return valid;
+}
+
+template <typename K, typename V, class RecManager>
+string bundle_lflist<K, V, RecManager>::getBundleStatsString() {
+  unsigned int max = 0;
+  long total = 0;
+  stack<nodeptr> s;
+  unordered_set<nodeptr> unique;
+  nodeptr curr = head;
+  s.push(curr);
+  while (!s.empty()) {
+    // Try to add the current node to set of unique nodes.
+    curr = s.top();
+    s.pop();
+    auto result = unique.insert(curr);
+    if (result.second && curr->key != KEY_MAX) {
+      int size;
+      std::pair<nodeptr, timestamp_t> *entries = curr->rqbundle.get(size);
+      s.push(getUnmarked(entries[0].first));
+      if (size > max) {
+        max = size;
+      }
+      total += size;
+      delete[] entries;
+    }
+  }
+
+  stringstream ss;
+  ss << "total reachable nodes         : " << unique.size() << endl;
+  ss << "average bundle size           : " << (total / (double)unique.size())
+     << endl;
+  ss << "max bundle size               : " << max << endl;
+  return ss.str();
+}
+
+template <typename K, typename V, class RecManager>
+long long bundle_lflist<K, V, RecManager>::debugKeySum(nodeptr head) {
+  long long result = 0;
+  nodeptr curr = head->next;
+  while (curr->key < KEY_MAX) {
+    if (!isMarked(curr->next)) {
+      result += curr->key;
+    }
+    curr = getUnmarked(curr->next);
+  }
+  return result;
+}
+
+template <typename K, typename V, class RecManager>
+long long bundle_lflist<K, V, RecManager>::debugKeySum() {
+  return debugKeySum(head);
+}
+
+template <typename K, typename V, class RecManager>
+bool bundle_lflist<K, V, RecManager>::validate(const long long keysum,
+                                               const bool checkkeysum) {
+  nodeptr pred = head;
+  nodeptr curr = head->next;  // head is never marked
+  while (curr->key < KEY_MAX) {
+    if (curr->key <= pred->key) {
+      return false;
+    }
+    pred = curr;
+    curr = getUnmarked(curr->next);
+  }
+  return true;
+}
+
+template <typename K, typename V, class RecManager>
+long long bundle_lflist<K, V, RecManager>::getSize() {
+  long long size = 0;
+  for (nodeptr curr = head->next; curr->key != KEY_MAX;
+       curr = getUnmarked(curr->next)) {
+    size += !isMarked(curr->next);
+  }
+  return size;
+}
+
+template <typename K, typename V, class RecManager>
+long long bundle_lflist<K, V, RecManager>::getSizeInNodes() {
+  long long size = 0;
+  for (nodeptr curr = head->next; curr->key != KEY_MAX;
+       curr = getUnmarked(curr->next)) {
+    ++size;
+  }
+  return size;
+}
+
+template <typename K, typename V, class RecManager>
+inline bool bundle_lflist<K, V, RecManager>::isLogicallyDeleted(
+    const int tid, node_t<K, V> *node) {
+  return node->isMarked(tid, rqProvider);
+}
+#endif /* BUNDLE_LOCKFREE_LIST_IMPL_H */
@@ -12,6 +12,8 @@
 #include "plaf.h"
 #include "random.h"
 #include "rq_provider.h"
+#include "rq_cursor.h"
+#include "multiget.h"
 
 using namespace std;
 
@@ -48,9 +50,19 @@ class node_t {
                       // fields that are modified at linearization points of
                       // operations to occupy a machine word)
 
+    // Must be last: a node only has room for p_next[0..topLevel].
     node_t<K, V>* volatile p_next[SKIPLIST_MAX_LEVEL];
   };
 
+  // Size of a node with p_next[0..topLevel]. About half of all nodes have
+  // topLevel 0, so this is much less than sizeof(node_t).
+  static size_t sizeOf(const int topLevel) {
+    return sizeof(node_t<K, V>) -
+           (SKIPLIST_MAX_LEVEL - 1 - topLevel) * sizeof(p_next[0]);
+  }
+  // Lets recordmgr pools recycle nodes by size class (see pool_interface.h).
+  size_t recordSize() const { return sizeOf(topLevel); }
+
   bool validate() {
     timestamp_t ts;
     return p_next[0] == rqbundle.first(ts);
@@ -83,7 +95,7 @@ class bundle_skiplist {
   debugCounters* const counters;
 #endif
 
-  nodeptr allocateNode(const int tid);
+  nodeptr allocateNode(const int tid, const int height);
 
   void initNode(const int tid, nodeptr p_node, K key, V value, int height);
   int find_impl(const int tid, K key, nodeptr* p_preds, nodeptr* p_succs,
@@ -106,6 +118,11 @@ class bundle_skiplist {
 
   bool contains(const int tid, K key);
   const pair<V, bool> find(const int tid, const K& key);
+  // looks up keys[0..n-1] with interleaved traversals (see multiget.h);
+  // values[i] is NO_VALUE if keys[i] is absent. returns the number of keys
+  // found.
+  int multiGet(const int tid, const K* const keys, const int n,
+               V* const values);
   V insert(const int tid, const K& key, const V& value) {
     return doInsert(tid, key, value, false);
   }
@@ -115,6 +132,9 @@ class bundle_skiplist {
   V erase(const int tid, const K& key);
   int rangeQuery(const int tid, const K& lo, const K& hi, K* const resultKeys,
                  V* const resultValues);
+  template <typename Visitor>
+  int rangeQueryVisit(const int tid, const K& lo, const K& hi,
+                      Visitor& visitor);
 
   void cleanup(int tid);
 
@@ -64,7 +64,7 @@ static int sl_randomLevel(const int tid, Random* const threadRNGs) {
 template <typename K, typename V, class RecordMgr>
 void bundle_skiplist<K, V, RecordMgr>::initNode(const int tid, nodeptr p_node,
                                                 K key, V value, int height) {
-  p_node->rqbundle.init();
+  p_node->rqbundle.init(tid, rqProvider->get_entry_manager());
   p_node->key = key;
   p_node->val = value;
   p_node->topLevel = height;
@@ -74,8 +74,10 @@ void bundle_skiplist<K, V, RecordMgr>::initNode(const int tid, nodeptr p_node,
 }
 
 template <typename K, typename V, class RecordMgr>
-nodeptr bundle_skiplist<K, V, RecordMgr>::allocateNode(const int tid) {
-  nodeptr nnode = recmgr->template allocate<node_t<K, V>>(tid);
+nodeptr bundle_skiplist<K, V, RecordMgr>::allocateNode(const int tid,
+                                                       const int height) {
+  nodeptr nnode = recmgr->template allocate<node_t<K, V>>(
+      tid, node_t<K, V>::sizeOf(height));
   if (nnode == NULL) {
     cout << "ERROR: out of memory" << endl;
     exit(-1);
@@ -137,15 +139,15 @@ bundle_skiplist<K, V, RecManager>::bundle_skiplist(const int numProcesses,
       new RQProvider<K, V, node_t<K, V>, bundle_skiplist<K, V, RecManager>,
                      RecManager, true, false>(numProcesses, this, recmgr);
 
-  p_tail = allocateNode(dummyTid);
+  p_tail = allocateNode(dummyTid, SKIPLIST_MAX_LEVEL - 1);
   initNode(dummyTid, p_tail, KEY_MAX, NO_VALUE, SKIPLIST_MAX_LEVEL - 1);
 
-  p_head = allocateNode(dummyTid);
+  p_head = allocateNode(dummyTid, SKIPLIST_MAX_LEVEL - 1);
   initNode(dummyTid, p_head, KEY_MIN, NO_VALUE, SKIPLIST_MAX_LEVEL - 1);
 
   BUNDLE_TYPE_DECL<node_t<K, V>>* bundles[] = {&p_head->rqbundle, nullptr};
   nodeptr ptrs[] = {p_tail, nullptr};
-  rqProvider->prepare_bundles(bundles, ptrs);
+  rqProvider->prepare_bundles(dummyTid, bundles, ptrs);
   timestamp_t ts = rqProvider->get_update_lin_time(dummyTid);
 
   for (i = 0; i < SKIPLIST_MAX_LEVEL; i++) {
@@ -211,6 +213,7 @@ bool bundle_skiplist<K, V, RecManager>::contains(const int tid, K key) {
 
   while (true) {
     recmgr->leaveQuiescentState(tid, true);
+    rqProvider->start_read(tid);
     lFound = find_impl(tid, key, p_preds, p_succs, &p_found);
 
     if (lFound >= 0) {
@@ -229,7 +232,7 @@ bool bundle_skiplist<K, V, RecManager>::contains(const int tid, K key) {
     } else {
       res = false;
     }
-    rqProvider->end_traversal(tid);
+    rqProvider->end_read(tid);
     recmgr->enterQuiescentState(tid);
     return res;
   }
@@ -262,6 +265,55 @@ const pair<V, bool> bundle_skiplist<K, V, RecManager>::find(const int tid,
   }
 }
 
+template <typename K, typename V, class RecManager>
+int bundle_skiplist<K, V, RecManager>::multiGet(const int tid,
+                                                const K* const keys,
+                                                const int n,
+                                                V* const values) {
+  int idx[MULTIGET_GROUP_SIZE];
+  int level[MULTIGET_GROUP_SIZE];
+  nodeptr p_pred[MULTIGET_GROUP_SIZE];
+  nodeptr p_curr[MULTIGET_GROUP_SIZE];
+  int found = 0;
+  auto start = [&](const int s, const int i) {
+    idx[s] = i;
+    level[s] = SKIPLIST_MAX_LEVEL - 1;
+    p_pred[s] = p_head;
+    p_curr[s] = p_head->p_next[level[s]];
+    MULTIGET_PREFETCH(p_curr[s]);
+  };
+  // Same path as find_impl, but a lookup stops at the highest level where it
+  // sees its key, which is the node find() checks.
+  auto step = [&](const int s) {
+    const K& key = keys[idx[s]];
+    nodeptr p_node = p_curr[s];
+    if (key > p_node->key) {
+      p_pred[s] = p_node;
+      p_curr[s] = p_node->p_next[level[s]];
+    } else if (key == p_node->key) {
+      const bool res = p_node->fullyLinked && !p_node->marked;
+#ifdef RQ_SNAPCOLLECTOR
+      rqProvider->search_report_target_key(tid, key, p_node);
+#endif
+      values[idx[s]] = res ? p_node->val : NO_VALUE;
+      if (res) ++found;
+      return false;
+    } else if (level[s] == 0) {
+      values[idx[s]] = NO_VALUE;
+      return false;
+    } else {
+      --level[s];
+      p_curr[s] = p_pred[s]->p_next[level[s]];
+    }
+    MULTIGET_PREFETCH(p_curr[s]);
+    return true;
+  };
+  recmgr->leaveQuiescentState(tid, true);
+  multiget_run(n, start, step);
+  recmgr->enterQuiescentState(tid);
+  return found;
+}
+
 template <typename K, typename V, class RecManager>
 V bundle_skiplist<K, V, RecManager>::doInsert(const int tid, const K& key,
                                               const V& value,
@@ -328,7 +380,7 @@ V bundle_skiplist<K, V, RecManager>::doInsert(const int tid, const K& key,
     }
 
     if (valid) {
-      p_new_node = allocateNode(tid);  // shmem_none->allocateNode(tid);
+      p_new_node = allocateNode(tid, topLevel);
 #ifdef __HANDLE_STATS
       GSTATS_APPEND(tid, node_allocated_addresses,
                     ((long long)p_new_node) % (1 << 12));
@@ -344,7 +396,7 @@ V bundle_skiplist<K, V, RecManager>::doInsert(const int tid, const K& key,
       BUNDLE_TYPE_DECL<node_t<K, V>>* bundles[] = {
           &p_preds[0]->rqbundle, &p_new_node->rqbundle, nullptr};
       nodeptr ptrs[] = {p_new_node, p_succs[0], nullptr};
-      rqProvider->prepare_bundles(bundles, ptrs);
+      rqProvider->prepare_bundles(tid, bundles, ptrs);
 
       SOFTWARE_BARRIER;
       timestamp_t lin_time = rqProvider->get_update_lin_time(tid);
@@ -357,6 +409,9 @@ V bundle_skiplist<K, V, RecManager>::doInsert(const int tid, const K& key,
       p_new_node->fullyLinked = 1;
       SOFTWARE_BARRIER;
       rqProvider->finalize_bundles(bundles, lin_time);
+#if defined USE_RQ_DEBUGGING
+      DEBUG_RECORD_UPDATE_KEY(tid, lin_time, key, 1);
+#endif
 #ifdef __HANDLE_STATS
       GSTATS_ADD_IX(tid, skiplist_inserted_on_level, 1, topLevel);
 #endif
@@ -437,10 +492,13 @@ V bundle_skiplist<K, V, RecManager>::erase(const int tid, const K& key) {
         BUNDLE_TYPE_DECL<node_t<K, V>>* bundles[] = {
             &p_preds[0]->rqbundle, &p_victim->rqbundle, nullptr};
         nodeptr ptrs[] = {p_victim->p_next[0], p_head, nullptr};
-        rqProvider->prepare_bundles(bundles, ptrs);
+        rqProvider->prepare_bundles(tid, bundles, ptrs);
         timestamp_t lin_time = rqProvider->linearize_update_at_write(
             tid, &p_victim->marked, (long long)1);
         rqProvider->finalize_bundles(bundles, lin_time);
+#if defined USE_RQ_DEBUGGING
+        DEBUG_RECORD_UPDATE_KEY(tid, lin_time, key, -1);
+#endif
         for (level = topLevel; level >= 0; level--) {
           p_preds[level]->p_next[level] = p_victim->p_next[level];
         }
@@ -541,11 +599,69 @@ int bundle_skiplist<K, V, RecManager>::rangeQuery(const int tid, const K& lo,
 
     // Traversal successful.
     if (curr != nullptr) {
+#if defined USE_RQ_DEBUGGING
+      // depending on the clock, updates at ts itself may or may not be visible
+      DEBUG_RECORD_RQ_RESULT(tid, ts, ts, lo, hi, resultKeys, cnt);
+#endif
       return cnt;
     }
   }
 }
 
+// Follows rangeQuery, except that it can only restart until the first batch of
+// keys has been passed to the visitor. Nodes reached through bundles at ts were
+// in the structure at ts, so once the range is entered bundle lookups should
+// succeed. If one fails anyway, the snapshot is walked again from the head.
+template <typename K, typename V, class RecManager>
+template <typename Visitor>
+int bundle_skiplist<K, V, RecManager>::rangeQueryVisit(const int tid,
+                                                       const K& lo, const K& hi,
+                                                       Visitor& visitor) {
+  RQCursor<K, V, Visitor> cursor(visitor);
+  while (true) {
+    recmgr->leaveQuiescentState(tid, true);
+    nodeptr pred = p_head;
+    nodeptr curr = nullptr;
+    // Phase 1. Pre-range traversal
+    for (int level = SKIPLIST_MAX_LEVEL - 1; level >= 0; level--) {
+      curr = pred->p_next[level];
+      while (curr->key < lo) {
+        pred = curr;
+        curr = curr->p_next[level];
+      }
+    }
+
+    // Phase 2. Enter snapshot
+    timestamp_t ts = rqProvider->start_traversal(tid);
+    bool ok = pred->rqbundle.getPtrByTimestamp(tid, ts, &curr);
+    while (ok && curr != nullptr && curr->key < lo) {
+      ok = curr->rqbundle.getPtrByTimestamp(tid, ts, &curr);
+    }
+
+    // Phase 3. Stream range
+    while (ok && curr != nullptr && curr->key <= hi) {
+      if (!cursor.add(getKeys(tid, curr, cursor.keys(), cursor.values()))) {
+        break;
+      }
+      ok = curr->rqbundle.getPtrByTimestamp(tid, ts, &curr);
+      if (!ok && cursor.resume()) {
+        ok = p_head->rqbundle.getPtrByTimestamp(tid, ts, &curr);
+        while (ok && curr->key < cursor.last()) {
+          ok = curr->rqbundle.getPtrByTimestamp(tid, ts, &curr);
+        }
+      }
+    }
+    const bool done = (ok && curr != nullptr) || !cursor.restart();
+    if (done) cursor.flush();
+    rqProvider->end_traversal(tid);
+    recmgr->enterQuiescentState(tid);
+    if (done) return cursor.visited();
+#ifdef __HANDLE_STATS
+    GSTATS_ADD(tid, bundle_restarts, 1);
+#endif
+  }
+}
+
 template <typename K, typename V, class RecManager>
 void bundle_skiplist<K, V, RecManager>::cleanup(int tid) {
   recmgr->leaveQuiescentState(tid);
@@ -557,6 +673,7 @@ void bundle_skiplist<K, V, RecManager>::cleanup(int tid) {
       BUNDLE_CLEAN_BUNDLE(curr->rqbundle);
     }
   }
+  BUNDLE_FINISH_CLEANUP(rqProvider);
   recmgr->enterQuiescentState(tid);
 }
 
@@ -0,0 +1,284 @@
+#ifndef BUNDLE_UNROLLED_SKIPLIST_H
+#define BUNDLE_UNROLLED_SKIPLIST_H
+
+#include <stack>
+#include <type_traits>
+#include <unordered_set>
+
+#ifndef MAX_NODES_INSERTED_OR_DELETED_ATOMICALLY
+// define BEFORE including rq_provider.h
+#define MAX_NODES_INSERTED_OR_DELETED_ATOMICALLY 4
+#endif
+#include "plaf.h"
+#include "random.h"
+#include "rq_provider.h"
+#include "rq_cursor.h"
+
+using namespace std;
+
+/////////////////////////////////////////////////////////
+// DEFINES
+/////////////////////////////////////////////////////////
+#ifdef SKIPLIST_DEBUGGING_FLATTEN_MAX_LEVEL
+#define SKIPLIST_MAX_LEVEL (1)
+#else
+#define SKIPLIST_MAX_LEVEL (20)
+#endif
+
+// Keys per node. Range queries read all of a node's keys at once, so this must
+// stay below RQ_DEBUGGING_MAX_KEYS_PER_NODE.
+#ifndef UNROLLED_SKIPLIST_NODE_KEYS
+#define UNROLLED_SKIPLIST_NODE_KEYS (16)
+#endif
+#if UNROLLED_SKIPLIST_NODE_KEYS >= RQ_DEBUGGING_MAX_KEYS_PER_NODE
+#error "UNROLLED_SKIPLIST_NODE_KEYS must be less than RQ_DEBUGGING_MAX_KEYS_PER_NODE"
+#endif
+
+/////////////////////////////////////////////////////////
+// TYPES
+/////////////////////////////////////////////////////////
+
+// A node holds a sorted run of the keys in (previous node's key, key], so
+// `key` is a fence rather than a key of the set. The run never changes once
+// the node is linked: updates replace nodes instead (see replaceNodes).
+template <typename K, typename V>
+class unrolled_node_t {
+ public:
+  BUNDLE_TYPE_DECL<unrolled_node_t<K, V>> rqbundle;
+  struct {
+   public:
+    volatile long lock;
+    volatile K key;
+    volatile int topLevel;
+    volatile int size;
+    volatile long long marked;
+    volatile long long fullyLinked;
+    K keys[UNROLLED_SKIPLIST_NODE_KEYS];
+    V vals[UNROLLED_SKIPLIST_NODE_KEYS];
+
+    // Must be last: a node only has room for p_next[0..topLevel].
+    unrolled_node_t<K, V>* volatile p_next[SKIPLIST_MAX_LEVEL];
+  };
+
+  // Size of a node with p_next[0..topLevel].
+  static size_t sizeOf(const int topLevel) {
+    return sizeof(unrolled_node_t<K, V>) -
+           (SKIPLIST_MAX_LEVEL - 1 - topLevel) * sizeof(p_next[0]);
+  }
+  // Lets recordmgr pools recycle nodes by size class (see pool_interface.h).
+  size_t recordSize() const { return sizeOf(topLevel); }
+
+  bool validate() {
+    timestamp_t ts;
+    return p_next[0] == rqbundle.first(ts);
+  }
+
+  template <typename RQProvider>
+  bool isMarked(const int tid, RQProvider* const prov) {
+    return (prov->read_addr(tid, &marked) == 1);
+  }
+};
+
+#define nodeptr unrolled_node_t<K, V>*
+
+template <typename K, typename V, class RecManager>
+class bundle_unrolled_skiplist {
+ private:
+  volatile char padding0[PREFETCH_SIZE_BYTES];
+  nodeptr volatile p_head;
+  nodeptr volatile p_tail;
+  volatile char padding2[PREFETCH_SIZE_BYTES];
+
+  const int NUM_PROCESSES;
+  RecManager* const recmgr;
+  Random* const
+      threadRNGs;  // threadRNGs[tid * PREFETCH_SIZE_WORDS] = rng for thread tid
+  RQProvider<K, V, unrolled_node_t<K, V>,
+             bundle_unrolled_skiplist<K, V, RecManager>, RecManager, true,
+             false>* rqProvider;
+#ifdef USE_DEBUGCOUNTERS
+  debugCounters* const counters;
+#endif
+
+  nodeptr allocateNode(const int tid, const int height);
+
+  void initNode(const int tid, nodeptr p_node, K key, V value, int height);
+  nodeptr newNode(const int tid, const K& fence, const int height,
+                  const K* const keys, const V* const vals, const int size);
+  void find_impl(const int tid, K key, nodeptr* p_preds, nodeptr* p_succs);
+  int searchNode(nodeptr p_node, const K& key);
+  bool replaceNodes(const int tid, nodeptr* p_preds, nodeptr* p_succs,
+                    nodeptr* const oldNodes, const int numOld,
+                    nodeptr* const newNodes, const int numNew, const K& key,
+                    const int delta);
+  V doInsert(const int tid, const K& key, const V& value, bool onlyIfAbsent);
+
+  int init[MAX_TID_POW2] = {
+      0,
+  };
+
+ public:
+  const K KEY_MIN;
+  const K KEY_MAX;
+  const V NO_VALUE;
+  volatile char padding3[PREFETCH_SIZE_BYTES];
+
+  bundle_unrolled_skiplist(const int numProcesses, const K _KEY_MIN,
+                           const K _KEY_MAX, const V NO_VALUE,
+                           Random* const threadRNGs);
+  ~bundle_unrolled_skiplist();
+
+  bool contains(const int tid, K key);
+  const pair<V, bool> find(const int tid, const K& key);
+  V insert(const int tid, const K& key, const V& value) {
+    return doInsert(tid, key, value, false);
+  }
+  V insertIfAbsent(const int tid, const K& key, const V& value) {
+    return doInsert(tid, key, value, true);
+  }
+  V erase(const int tid, const K& key);
+  int rangeQuery(const int tid, const K& lo, const K& hi, K* const resultKeys,
+                 V* const resultValues);
+  template <typename Visitor>
+  int rangeQueryVisit(const int tid, const K& lo, const K& hi,
+                      Visitor& visitor);
+
+  void cleanup(int tid);
+
+  void initThread(const int tid);
+  void deinitThread(const int tid);
+#ifdef USE_DEBUGCOUNTERS
+  debugCounters* debugGetCounters() { return counters; }
+  void clearCounters() { counters->clear(); }
+#endif
+  long long getSizeInNodes() {
+    long long size = 0;
+    for (nodeptr curr = p_head->p_next[0]; curr != p_tail;
+         curr = curr->p_next[0]) {
+      ++size;
+    }
+    return size;
+  }
+  // warning: this can only be used when there are no other threads accessing
+  // the data structure
+  long long getSize() {
+    long long size = 0;
+    for (nodeptr curr = p_head->p_next[0]; curr != p_tail;
+         curr = curr->p_next[0]) {
+      if (!curr->marked) size += curr->size;
+    }
+    return size;
+  }
+  string getSizeString() {
+    stringstream ss;
+    ss << getSizeInNodes() << " nodes in data structure";
+    return ss.str();
+  }
+
+  RecManager* const debugGetRecMgr() { return recmgr; }
+
+  inline int getKeys(const int tid, unrolled_node_t<K, V>* node,
+                     K* const outputKeys, V* const outputValues) {
+    const int size = node->size;
+    for (int i = 0; i < size; ++i) {
+      outputKeys[i] = node->keys[i];
+      outputValues[i] = node->vals[i];
+    }
+    return size;
+  }
+
+  bool isInRange(const K& key, const K& lo, const K& hi) {
+    return (lo <= key && key <= hi);
+  }
+  inline bool isLogicallyDeleted(const int tid, unrolled_node_t<K, V>* node) {
+    return (rqProvider->read_addr(tid, &node->marked));
+  }
+
+  inline bool isLogicallyInserted(const int tid, unrolled_node_t<K, V>* node) {
+    return (rqProvider->read_addr(tid, &node->fullyLinked));
+  }
+
+  bool validate(const long long keysum, const bool checkkeysum) { return true; }
+
+  unrolled_node_t<K, V>* debug_getEntryPoint() { return p_head; }
+
+ private:
+  // Copies the keys of node in [lo, hi] to outputKeys and outputValues.
+  inline int getKeysInRange(unrolled_node_t<K, V>* node, const K& lo,
+                            const K& hi, K* const outputKeys,
+                            V* const outputValues) {
+    const int size = node->size;
+    int cnt = 0;
+    for (int i = 0; i < size; ++i) {
+      const K key = node->keys[i];
+      if (key < lo) continue;
+      if (key > hi) break;
+      outputKeys[cnt] = key;
+      outputValues[cnt] = node->vals[i];
+      ++cnt;
+    }
+    return cnt;
+  }
+
+  // warning: this can only be used when there are no other threads accessing
+  // the data structure
+  long long debugKeySum(nodeptr head) {
+    long long result = 0;
+    // traverse lowest level
+    nodeptr curr = (nodeptr)head->p_next[0];
+    while (curr != p_tail) {
+      if (!curr->marked) {
+        for (int i = 0; i < curr->size; ++i) result += curr->keys[i];
+      }
+      curr = curr->p_next[0];
+    }
+    return result;
+  }
+
+ public:
+  long long debugKeySum() { return debugKeySum(p_head); }
+
+  void startCleanup() { rqProvider->startCleanup(); }
+
+  void stopCleanup() { rqProvider->stopCleanup(); }
+
+  bool validateBundles(int tid);
+
+  string getBundleStatsString() {
+    unsigned int max = 0;
+    long total = 0;
+    long keys = 0;
+    stack<nodeptr> s;
+    unordered_set<unrolled_node_t<K, V>*> unique;
+    nodeptr curr = p_head;
+    s.push(curr);
+    while (!s.empty()) {
+      // Try to add the current node to set of unique nodes.
+      curr = s.top();
+      s.pop();
+      auto result = unique.insert(curr);
+      if (result.second && curr != p_tail) {
+        int size;
+        std::pair<nodeptr, timestamp_t>* entries = curr->rqbundle.get(size);
+        s.push(entries[0].first);
+        if (size > max) {
+          max = size;
+        }
+        total += size;
+        keys += curr->size;
+        delete[] entries;
+      }
+    }
+
+    stringstream ss;
+    ss << "total reachable nodes         : " << unique.size() << endl;
+    ss << "average keys per node         : " << (keys / (double)unique.size())
+       << endl;
+    ss << "average bundle size           : " << (total / (double)unique.size())
+       << endl;
+    ss << "max bundle size               : " << max << endl;
+    return ss.str();
+  }
+};
+
+#endif  // BUNDLE_UNROLLED_SKIPLIST_H
@@ -0,0 +1,740 @@
+// A bundled skip-list whose nodes hold sorted runs of up to
+// UNROLLED_SKIPLIST_NODE_KEYS keys, with one bundle per node.
+//
+// It follows the lazy-locking skip-list of bundle_skiplist_impl.h, but the
+// runs are copy-on-write: an update locks the nodes it changes and their
+// predecessors, links in new nodes that hold the new runs (splitting a full
+// node in two, or merging a sparse node into its successor), and marks the
+// old ones. A range query over R keys then reads about R /
+// UNROLLED_SKIPLIST_NODE_KEYS nodes and bundles instead of R.
+
+#ifndef BUNDLE_UNROLLED_SKIPLIST_IMPL_H
+#define BUNDLE_UNROLLED_SKIPLIST_IMPL_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bundle_unrolled_skiplist.h"
+
+#define CAS __sync_val_compare_and_swap
+
+template <typename K, typename V>
+static void sl_node_lock(nodeptr p_node) {
+  while (1) {
+    long cur_lock = p_node->lock;
+    if (likely(cur_lock == 0)) {
+      if (likely(CAS(&(p_node->lock), 0, 1) == 0)) {
+        return;
+      }
+    }
+    CPU_RELAX;
+  }
+}
+
+template <typename K, typename V>
+static void sl_node_unlock(nodeptr p_node) {
+  p_node->lock = 0;
+  SOFTWARE_BARRIER;
+}
+
+static int sl_randomLevel(const int tid, Random* const threadRNGs) {
+  // idea: new node level is the number of trailing zero bits in a random #.
+  unsigned int v =
+      threadRNGs[tid * PREFETCH_SIZE_WORDS]
+          .nextNatural();  // 32-bit word input to count zero bits on right
+  unsigned int c = 32;     // c will be the number of zero bits on the right
+  v &= -signed(v);
+  if (v) c--;
+  if (v & 0x0000FFFF) c -= 16;
+  if (v & 0x00FF00FF) c -= 8;
+  if (v & 0x0F0F0F0F) c -= 4;
+  if (v & 0x33333333) c -= 2;
+  if (v & 0x55555555) c -= 1;
+  return (c < SKIPLIST_MAX_LEVEL) ? c : SKIPLIST_MAX_LEVEL - 1;
+}
+
+template <typename K, typename V, class RecordMgr>
+void bundle_unrolled_skiplist<K, V, RecordMgr>::initNode(const int tid,
+                                                         nodeptr p_node, K key,
+                                                         V value, int height) {
+  p_node->rqbundle.init(tid, rqProvider->get_entry_manager());
+  p_node->key = key;
+  p_node->topLevel = height;
+  p_node->size = 0;
+  p_node->lock = 0;
+  p_node->marked = (long long)0;
+  p_node->fullyLinked = (long long)0;
+}
+
+template <typename K, typename V, class RecordMgr>
+nodeptr bundle_unrolled_skiplist<K, V, RecordMgr>::allocateNode(
+    const int tid, const int height) {
+  nodeptr nnode = recmgr->template allocate<unrolled_node_t<K, V>>(
+      tid, unrolled_node_t<K, V>::sizeOf(height));
+  if (nnode == NULL) {
+    cout << "ERROR: out of memory" << endl;
+    exit(-1);
+  }
+  return nnode;
+}
+
+// Returns a locked, unlinked node holding keys[0..size-1].
+template <typename K, typename V, class RecordMgr>
+nodeptr bundle_unrolled_skiplist<K, V, RecordMgr>::newNode(
+    const int tid, const K& fence, const int height, const K* const keys,
+    const V* const vals, const int size) {
+  nodeptr p_node = allocateNode(tid, height);
+  initNode(tid, p_node, fence, NO_VALUE, height);
+  for (int i = 0; i < size; ++i) {
+    p_node->keys[i] = keys[i];
+    p_node->vals[i] = vals[i];
+  }
+  p_node->size = size;
+  sl_node_lock(p_node);
+  return p_node;
+}
+
+// Fills p_preds and p_succs so that p_succs[0] is the first node whose fence
+// is at least key, i.e., the node that holds key if it is in the set.
+template <typename K, typename V, class RecordMgr>
+void bundle_unrolled_skiplist<K, V, RecordMgr>::find_impl(const int tid, K key,
+                                                          nodeptr* p_preds,
+                                                          nodeptr* p_succs) {
+  nodeptr p_pred = p_head;
+  nodeptr p_curr = NULL;
+
+  for (int level = SKIPLIST_MAX_LEVEL - 1; level >= 0; level--) {
+    p_curr = p_pred->p_next[level];
+    while (key > p_curr->key) {
+      p_pred = p_curr;
+      p_curr = p_pred->p_next[level];
+    }
+    p_preds[level] = p_pred;
+    p_succs[level] = p_curr;
+  }
+}
+
+// Returns the index of key in p_node's run, or -1.
+template <typename K, typename V, class RecordMgr>
+int bundle_unrolled_skiplist<K, V, RecordMgr>::searchNode(nodeptr p_node,
+                                                          const K& key) {
+  const int size = p_node->size;
+  for (int i = 0; i < size; ++i) {
+    if (p_node->keys[i] >= key) return (p_node->keys[i] == key) ? i : -1;
+  }
+  return -1;
+}
+
+// Atomically replaces oldNodes[0..numOld-1], which are consecutive at level 0,
+// by the locked, unlinked newNodes[0..numNew-1], which must be sorted by fence
+// and have fences no larger than the last old node's (or than the successor's,
+// if there are no old nodes). p_preds and p_succs come from find_impl for a key
+// that oldNodes[0] holds, or would hold. Returns false, having changed nothing,
+// if the nodes have changed since; the caller still owns newNodes then.
+//
+// Locks are taken in decreasing fence order (the old nodes from the last one,
+// then the predecessors from level 0 up) and new nodes stay locked until they
+// are fully linked, which prevents deadlock.
+template <typename K, typename V, class RecManager>
+bool bundle_unrolled_skiplist<K, V, RecManager>::replaceNodes(
+    const int tid, nodeptr* p_preds, nodeptr* p_succs, nodeptr* const oldNodes,
+    const int numOld, nodeptr* const newNodes, const int numNew, const K& key,
+    const int delta) {
+  nodeptr p_after[SKIPLIST_MAX_LEVEL];
+  int topLevel = 0;
+  int i;
+  int level;
+  for (i = 0; i < numOld; ++i) {
+    if (oldNodes[i]->topLevel > topLevel) topLevel = oldNodes[i]->topLevel;
+  }
+  for (i = 0; i < numNew; ++i) {
+    if (newNodes[i]->topLevel > topLevel) topLevel = newNodes[i]->topLevel;
+  }
+
+  int lowestOldLocked = numOld;
+  int valid = 1;
+  for (i = numOld - 1; valid && i >= 0; --i) {
+    sl_node_lock(oldNodes[i]);
+    lowestOldLocked = i;
+    valid = (!oldNodes[i]->marked &&
+             (i == numOld - 1 || oldNodes[i]->p_next[0] == oldNodes[i + 1]));
+  }
+
+  int highestLocked = -1;
+  for (level = 0; valid && (level <= topLevel); level++) {
+    // the old nodes on this level lie between p_preds[level] and p_after
+    nodeptr p_expected = p_succs[level];
+    p_after[level] = p_succs[level];
+    bool seen = false;
+    for (i = 0; i < numOld; ++i) {
+      if (oldNodes[i]->topLevel >= level) {
+        if (!seen) p_expected = oldNodes[i];
+        seen = true;
+        p_after[level] = oldNodes[i]->p_next[level];
+      }
+    }
+    if (level == 0 || p_preds[level] != p_preds[level - 1]) {
+      // don't try to lock same node twice
+      sl_node_lock(p_preds[level]);
+    }
+    highestLocked = level;
+    valid = (!p_preds[level]->marked && !p_after[level]->marked &&
+             (p_preds[level]->p_next[level] == p_expected));
+  }
+  // a fence may only be raised up to the successor's
+  valid = valid && (numNew == 0 || newNodes[numNew - 1]->key < p_after[0]->key);
+
+  if (valid) {
+    nodeptr p_first[SKIPLIST_MAX_LEVEL];
+    for (level = 0; level <= topLevel; level++) p_first[level] = p_after[level];
+    for (i = numNew - 1; i >= 0; --i) {
+      for (level = 0; level <= newNodes[i]->topLevel; level++) {
+        newNodes[i]->p_next[level] = p_first[level];
+        p_first[level] = newNodes[i];
+      }
+    }
+
+    // Bundle preparation must occur before the nodes are connected.
+    BUNDLE_TYPE_DECL<unrolled_node_t<K, V>>* bundles[6];
+    nodeptr ptrs[6];
+    int numBundles = 0;
+    bundles[numBundles] = &p_preds[0]->rqbundle;
+    ptrs[numBundles++] = p_first[0];
+    for (i = 0; i < numNew; ++i) {
+      bundles[numBundles] = &newNodes[i]->rqbundle;
+      ptrs[numBundles++] = newNodes[i]->p_next[0];
+    }
+    for (i = 0; i < numOld; ++i) {
+      bundles[numBundles] = &oldNodes[i]->rqbundle;
+      ptrs[numBundles++] = p_head;
+    }
+    bundles[numBundles] = nullptr;
+    ptrs[numBundles] = nullptr;
+    rqProvider->prepare_bundles(tid, bundles, ptrs);
+
+    timestamp_t lin_time;
+    if (numOld > 0) {
+      lin_time = rqProvider->linearize_update_at_write(
+          tid, &oldNodes[0]->marked, (long long)1);
+      for (i = 1; i < numOld; ++i) oldNodes[i]->marked = 1;
+    } else {
+      SOFTWARE_BARRIER;
+      lin_time = rqProvider->get_update_lin_time(tid);
+      SOFTWARE_BARRIER;
+    }
+    for (level = 0; level <= topLevel; level++) {
+      p_preds[level]->p_next[level] = p_first[level];
+    }
+    for (i = 0; i < numNew; ++i) newNodes[i]->fullyLinked = 1;
+    SOFTWARE_BARRIER;
+    rqProvider->finalize_bundles(bundles, lin_time);
+#if defined USE_RQ_DEBUGGING
+    DEBUG_RECORD_UPDATE_KEY(tid, lin_time, key, delta);
+#endif
+    if (numOld > 0) rqProvider->physical_deletion_succeeded(tid, oldNodes);
+    for (i = 0; i < numNew; ++i) sl_node_unlock(newNodes[i]);
+  }
+
+  // unlock everything here
+  for (level = 0; level <= highestLocked; level++) {
+    if (level == 0 || p_preds[level] != p_preds[level - 1]) {
+      // don't try to unlock the same node twice
+      sl_node_unlock(p_preds[level]);
+    }
+  }
+  for (i = lowestOldLocked; i < numOld; ++i) sl_node_unlock(oldNodes[i]);
+  return valid;
+}
+
+template <typename K, typename V, class RecManager>
+bundle_unrolled_skiplist<K, V, RecManager>::bundle_unrolled_skiplist(
+    const int numProcesses, const K _KEY_MIN, const K _KEY_MAX,
+    const V NO_VALUE, Random* const threadRNGs)
+    : NUM_PROCESSES(numProcesses),
+      recmgr(new RecManager(numProcesses, 0)),
+      threadRNGs(threadRNGs)
+#ifdef USE_DEBUGCOUNTERS
+      ,
+      counters(new debugCounters(numProcesses))
+#endif
+      ,
+      KEY_MIN(_KEY_MIN),
+      KEY_MAX(_KEY_MAX),
+      NO_VALUE(NO_VALUE) {
+
+  int i;
+  const int dummyTid = 0;
+  recmgr->initThread(dummyTid);
+
+  rqProvider =
+      new RQProvider<K, V, unrolled_node_t<K, V>,
+                     bundle_unrolled_skiplist<K, V, RecManager>, RecManager,
+                     true, false>(numProcesses, this, recmgr);
+
+  p_tail = allocateNode(dummyTid, SKIPLIST_MAX_LEVEL - 1);
+  initNode(dummyTid, p_tail, KEY_MAX, NO_VALUE, SKIPLIST_MAX_LEVEL - 1);
+
+  p_head = allocateNode(dummyTid, SKIPLIST_MAX_LEVEL - 1);
+  initNode(dummyTid, p_head, KEY_MIN, NO_VALUE, SKIPLIST_MAX_LEVEL - 1);
+
+  BUNDLE_TYPE_DECL<unrolled_node_t<K, V>>* bundles[] = {&p_head->rqbundle,
+                                                        nullptr};
+  nodeptr ptrs[] = {p_tail, nullptr};
+  rqProvider->prepare_bundles(dummyTid, bundles, ptrs);
+  timestamp_t ts = rqProvider->get_update_lin_time(dummyTid);
+
+  for (i = 0; i < SKIPLIST_MAX_LEVEL; i++) {
+    p_head->p_next[i] = p_tail;
+  }
+
+  rqProvider->finalize_bundles(bundles, ts);
+}
+
+template <typename K, typename V, class RecManager>
+bundle_unrolled_skiplist<K, V, RecManager>::~bundle_unrolled_skiplist() {
+  const int dummyTid = 0;
+  nodeptr curr = p_head;
+  while (curr != p_tail) {
+    auto tmp = curr;
+    curr = curr->p_next[0];
+    recmgr->retire(dummyTid, tmp);
+  }
+  recmgr->retire(dummyTid, curr);
+  delete rqProvider;
+  recmgr->printStatus();
+  delete recmgr;
+#ifdef USE_DEBUGCOUNTERS
+  delete counters;
+#endif
+}
+
+template <typename K, typename V, class RecManager>
+void bundle_unrolled_skiplist<K, V, RecManager>::initThread(const int tid) {
+  if (init[tid])
+    return;
+  else
+    init[tid] = !init[tid];
+
+  recmgr->initThread(tid);
+  rqProvider->initThread(tid);
+}
+
+template <typename K, typename V, class RecManager>
+void bundle_unrolled_skiplist<K, V, RecManager>::deinitThread(const int tid) {
+  if (!init[tid])
+    return;
+  else
+    init[tid] = !init[tid];
+
+  recmgr->deinitThread(tid);
+  rqProvider->deinitThread(tid);
+}
+
+template <typename K, typename V, class RecManager>
+bool bundle_unrolled_skiplist<K, V, RecManager>::contains(const int tid,
+                                                          K key) {
+  nodeptr p_preds[SKIPLIST_MAX_LEVEL] = {
+      0,
+  };
+  nodeptr p_succs[SKIPLIST_MAX_LEVEL] = {
+      0,
+  };
+  nodeptr curr;
+
+  recmgr->leaveQuiescentState(tid, true);
+  rqProvider->start_read(tid);
+  find_impl(tid, key, p_preds, p_succs);
+  bool ok = p_preds[0]->rqbundle.getPtr(tid, &curr);
+  assert(ok);
+  while (curr->key < key) {
+    ok = curr->rqbundle.getPtr(tid, &curr);
+    assert(ok);
+  }
+  bool res = (searchNode(curr, key) != -1);
+  rqProvider->end_read(tid);
+  recmgr->enterQuiescentState(tid);
+  return res;
+}
+
+template <typename K, typename V, class RecManager>
+const pair<V, bool> bundle_unrolled_skiplist<K, V, RecManager>::find(
+    const int tid, const K& key) {
+  nodeptr p_preds[SKIPLIST_MAX_LEVEL] = {
+      0,
+  };
+  nodeptr p_succs[SKIPLIST_MAX_LEVEL] = {
+      0,
+  };
+  while (true) {
+    recmgr->leaveQuiescentState(tid, true);
+    find_impl(tid, key, p_preds, p_succs);
+    nodeptr p_node = p_succs[0];
+    if (p_node == p_tail) {
+      recmgr->enterQuiescentState(tid);
+      return pair<V, bool>(NO_VALUE, false);
+    }
+    if (p_node->marked) {
+      recmgr->enterQuiescentState(tid);
+      continue;  // replaced; try again
+    }
+    while (!p_node->fullyLinked) {
+      CPU_RELAX;
+    }  // keep spinning
+    int i = searchNode(p_node, key);
+    V val = (i != -1) ? p_node->vals[i] : NO_VALUE;
+    recmgr->enterQuiescentState(tid);
+    return pair<V, bool>(val, i != -1);
+  }
+}
+
+template <typename K, typename V, class RecManager>
+V bundle_unrolled_skiplist<K, V, RecManager>::doInsert(const int tid,
+                                                       const K& key,
+                                                       const V& value,
+                                                       bool onlyIfAbsent) {
+  nodeptr p_preds[SKIPLIST_MAX_LEVEL] = {
+      0,
+  };
+  nodeptr p_succs[SKIPLIST_MAX_LEVEL] = {
+      0,
+  };
+  K keys[UNROLLED_SKIPLIST_NODE_KEYS + 1];
+  V vals[UNROLLED_SKIPLIST_NODE_KEYS + 1];
+
+  while (true) {
+    nodeptr oldNodes[] = {nullptr, nullptr};
+    nodeptr newNodes[] = {nullptr, nullptr};
+    int numOld = 0;
+    int numNew = 0;
+
+    recmgr->leaveQuiescentState(tid);
+    find_impl(tid, key, p_preds, p_succs);
+    nodeptr p_node = p_succs[0];
+    if (p_node != p_tail) {
+      if (p_node->marked) {
+        recmgr->enterQuiescentState(tid);
+        continue;  // try again
+      }
+      while (!p_node->fullyLinked) {
+        CPU_RELAX;
+      }  // keep spinning
+      int i = searchNode(p_node, key);
+      if (i != -1) {
+        // key is found and fully linked!
+        V ret = p_node->vals[i];
+        recmgr->enterQuiescentState(tid);
+        if (onlyIfAbsent) {
+          return ret;
+        } else {
+          cout << "ERROR: insert-replace functionality not implemented for "
+                  "bundle_unrolled_skiplist_impl"
+               << endl;
+          exit(-1);
+        }
+      }
+    } else if (p_preds[0] != p_head &&
+               p_preds[0]->size < UNROLLED_SKIPLIST_NODE_KEYS) {
+      // key is above every fence: raise the last node's fence to key rather
+      // than starting a new node, so ascending inserts still fill nodes
+      p_node = p_preds[0];
+      find_impl(tid, p_node->key, p_preds, p_succs);
+      if (p_succs[0] != p_node) {
+        recmgr->enterQuiescentState(tid);
+        continue;  // try again
+      }
+    } else {
+      p_node = nullptr;
+    }
+
+    if (p_node == nullptr) {
+      newNodes[numNew++] = newNode(tid, key, sl_randomLevel(tid, threadRNGs),
+                                   &key, &value, 1);
+    } else {
+      // the node's run with key added in order
+      const int size = p_node->size;
+      int n = 0;
+      int i = 0;
+      for (; i < size && p_node->keys[i] < key; ++i, ++n) {
+        keys[n] = p_node->keys[i];
+        vals[n] = p_node->vals[i];
+      }
+      keys[n] = key;
+      vals[n++] = value;
+      for (; i < size; ++i, ++n) {
+        keys[n] = p_node->keys[i];
+        vals[n] = p_node->vals[i];
+      }
+      const K fence = (p_node->key < key) ? key : (K)p_node->key;
+
+      oldNodes[numOld++] = p_node;
+      if (n <= UNROLLED_SKIPLIST_NODE_KEYS) {
+        newNodes[numNew++] =
+            newNode(tid, fence, p_node->topLevel, keys, vals, n);
+      } else {
+        // split: the upper half keeps the node's fence and height
+        const int half = n / 2;
+        newNodes[numNew++] = newNode(tid, keys[half - 1],
+                                     sl_randomLevel(tid, threadRNGs), keys,
+                                     vals, half);
+        newNodes[numNew++] = newNode(tid, fence, p_node->topLevel, keys + half,
+                                     vals + half, n - half);
+      }
+    }
+
+    if (replaceNodes(tid, p_preds, p_succs, oldNodes, numOld, newNodes,
+                     numNew, key, 1)) {
+#ifdef __HANDLE_STATS
+      GSTATS_ADD_IX(tid, skiplist_inserted_on_level, 1,
+                    newNodes[0]->topLevel);
+#endif
+      recmgr->enterQuiescentState(tid);
+      return NO_VALUE;
+    }
+    for (int i = 0; i < numNew; ++i) {
+      recmgr->deallocate(tid, newNodes[i]);
+    }
+    recmgr->enterQuiescentState(tid);
+  }
+}
+
+template <typename K, typename V, class RecManager>
+V bundle_unrolled_skiplist<K, V, RecManager>::erase(const int tid,
+                                                    const K& key) {
+  nodeptr p_preds[SKIPLIST_MAX_LEVEL] = {
+      0,
+  };
+  nodeptr p_succs[SKIPLIST_MAX_LEVEL] = {
+      0,
+  };
+  K keys[2 * UNROLLED_SKIPLIST_NODE_KEYS];
+  V vals[2 * UNROLLED_SKIPLIST_NODE_KEYS];
+
+  while (true) {
+    recmgr->leaveQuiescentState(tid);
+    find_impl(tid, key, p_preds, p_succs);
+    nodeptr p_victim = p_succs[0];
+    if (p_victim == p_tail) {
+      recmgr->enterQuiescentState(tid);
+      return NO_VALUE;
+    }
+    if (p_victim->marked) {
+      recmgr->enterQuiescentState(tid);
+      continue;  // try again
+    }
+    while (!p_victim->fullyLinked) {
+      CPU_RELAX;
+    }  // keep spinning
+    const int found = searchNode(p_victim, key);
+    if (found == -1) {
+      recmgr->enterQuiescentState(tid);
+      return NO_VALUE;
+    }
+    const V ret = p_victim->vals[found];
+
+    // the node's run without key
+    const int size = p_victim->size;
+    int n = 0;
+    for (int i = 0; i < size; ++i) {
+      if (i == found) continue;
+      keys[n] = p_victim->keys[i];
+      vals[n++] = p_victim->vals[i];
+    }
+
+    nodeptr oldNodes[] = {p_victim, nullptr, nullptr};
+    nodeptr newNodes[] = {nullptr};
+    int numOld = 1;
+    int numNew = 0;
+    if (n > 0) {
+      // merge into the successor if both fit in half a node
+      nodeptr p_next = p_victim->p_next[0];
+      if (p_next != p_tail &&
+          n + p_next->size <= UNROLLED_SKIPLIST_NODE_KEYS / 2) {
+        for (int i = 0; i < p_next->size; ++i) {
+          keys[n] = p_next->keys[i];
+          vals[n++] = p_next->vals[i];
+        }
+        oldNodes[numOld++] = p_next;
+        newNodes[numNew++] =
+            newNode(tid, (K)p_next->key, p_next->topLevel, keys, vals, n);
+      } else {
+        newNodes[numNew++] =
+            newNode(tid, (K)p_victim->key, p_victim->topLevel, keys, vals, n);
+      }
+    }
+
+    if (replaceNodes(tid, p_preds, p_succs, oldNodes, numOld, newNodes,
+                     numNew, key, -1)) {
+      recmgr->enterQuiescentState(tid);
+      return ret;
+    }
+    for (int i = 0; i < numNew; ++i) {
+      recmgr->deallocate(tid, newNodes[i]);
+    }
+    recmgr->enterQuiescentState(tid);
+  }
+}
+
+template <typename K, typename V, class RecManager>
+int bundle_unrolled_skiplist<K, V, RecManager>::rangeQuery(
+    const int tid, const K& lo, const K& hi, K* const resultKeys,
+    V* const resultValues) {
+  timestamp_t ts;
+  bool ok;
+  while (true) {
+    // `could_restart` tracks whether or not we have traversed from the head
+    // because we don't want range queries whose range immediately follows the
+    // head to be counted as restarted.
+    bool could_restart = false;
+    int cnt = 0;
+    recmgr->leaveQuiescentState(tid, true);
+    nodeptr pred = p_head;
+    nodeptr curr = nullptr;
+    // Phase 1. Pre-range traversal
+    for (int level = SKIPLIST_MAX_LEVEL - 1; level >= 0; level--) {
+      curr = pred->p_next[level];
+      while (curr->key < lo) {
+        pred = curr;
+        curr = curr->p_next[level];
+        if (!could_restart) could_restart = true;
+      }
+    }
+
+    // Phase 2. Enter snapshot
+    ts = rqProvider->start_traversal(tid);
+    ok = pred->rqbundle.getPtrByTimestamp(tid, ts, &curr);
+    assert(ok);
+    if (unlikely(could_restart && curr == p_head)) {
+#ifdef __HANDLE_STATS
+      GSTATS_ADD(tid, bundle_restarts, 1);
+#endif
+    }
+
+    while (curr != nullptr && curr->key < lo) {
+      ok = curr->rqbundle.getPtrByTimestamp(tid, ts, &curr);
+      assert(ok);
+    }
+
+    // Phase 3. Collect range. Keys above a node's fence are in later nodes, so
+    // the node whose fence reaches hi is the last one.
+    while (curr != nullptr) {
+      cnt += getKeysInRange(curr, lo, hi, resultKeys + cnt, resultValues + cnt);
+      if (curr->key >= hi) break;
+      ok = curr->rqbundle.getPtrByTimestamp(tid, ts, &curr);
+      assert(ok);
+    }
+    rqProvider->end_traversal(tid);
+    recmgr->enterQuiescentState(tid);
+
+    // Traversal successful.
+    if (curr != nullptr) {
+#if defined USE_RQ_DEBUGGING
+      // depending on the clock, updates at ts itself may or may not be visible
+      DEBUG_RECORD_RQ_RESULT(tid, ts, ts, lo, hi, resultKeys, cnt);
+#endif
+      return cnt;
+    }
+  }
+}
+
+// Follows rangeQuery, except that it can only restart until the first batch of
+// keys has been passed to the visitor. Updates replace nodes, so the
+// predecessor found before the snapshot is often newer than it, and then the
+// range query restarts before reaching the range. Nodes reached through
+// bundles at ts always have an entry at ts; if a lookup fails anyway once keys
+// have been passed on, the snapshot is walked again from the head.
+template <typename K, typename V, class RecManager>
+template <typename Visitor>
+int bundle_unrolled_skiplist<K, V, RecManager>::rangeQueryVisit(
+    const int tid, const K& lo, const K& hi, Visitor& visitor) {
+  RQCursor<K, V, Visitor> cursor(visitor);
+  while (true) {
+    recmgr->leaveQuiescentState(tid, true);
+    nodeptr pred = p_head;
+    nodeptr curr = nullptr;
+    // Phase 1. Pre-range traversal
+    for (int level = SKIPLIST_MAX_LEVEL - 1; level >= 0; level--) {
+      curr = pred->p_next[level];
+      while (curr->key < lo) {
+        pred = curr;
+        curr = curr->p_next[level];
+      }
+    }
+
+    // Phase 2. Enter snapshot
+    timestamp_t ts = rqProvider->start_traversal(tid);
+    bool ok = pred->rqbundle.getPtrByTimestamp(tid, ts, &curr);
+    while (ok && curr != nullptr && curr->key < lo) {
+      ok = curr->rqbundle.getPtrByTimestamp(tid, ts, &curr);
+    }
+
+    // Phase 3. Stream range
+    while (ok && curr != nullptr) {
+      if (!cursor.add(getKeysInRange(curr, lo, hi, cursor.keys(),
+                                     cursor.values()))) {
+        break;
+      }
+      if (curr->key >= hi) break;
+      ok = curr->rqbundle.getPtrByTimestamp(tid, ts, &curr);
+      if (!ok && cursor.resume()) {
+        ok = p_head->rqbundle.getPtrByTimestamp(tid, ts, &curr);
+        while (ok && curr->key < cursor.last()) {
+          ok = curr->rqbundle.getPtrByTimestamp(tid, ts, &curr);
+        }
+      }
+    }
+    const bool done = (ok && curr != nullptr) || !cursor.restart();
+    if (done) cursor.flush();
+    rqProvider->end_traversal(tid);
+    recmgr->enterQuiescentState(tid);
+    if (done) return cursor.visited();
+#ifdef __HANDLE_STATS
+    GSTATS_ADD(tid, bundle_restarts, 1);
+#endif
+  }
+}
+
+template <typename K, typename V, class RecManager>
+void bundle_unrolled_skiplist<K, V, RecManager>::cleanup(int tid) {
+  recmgr->leaveQuiescentState(tid);
+  BUNDLE_INIT_CLEANUP(rqProvider);
+  BUNDLE_CLEAN_BUNDLE(p_head->rqbundle);
+  for (nodeptr curr = p_head->p_next[0]; curr != p_tail;
+       curr = curr->p_next[0]) {
+    if (!curr->marked) {
+      BUNDLE_CLEAN_BUNDLE(curr->rqbundle);
+    }
+  }
+  BUNDLE_FINISH_CLEANUP(rqProvider);
+  recmgr->enterQuiescentState(tid);
+}
+
+template <typename K, typename V, class RecManager>
+bool bundle_unrolled_skiplist<K, V, RecManager>::validateBundles(int tid) {
+  bool valid = true;
+#ifdef BUNDLE_DEBUG
+  for (nodeptr curr = p_head->p_next[0]; curr != p_tail;
+       curr = curr->p_next[0]) {
+    timestamp_t ts;
+    nodeptr ptr = curr->rqbundle.first(ts);
+    if (ptr != curr->p_next[0]) {
+      std::cout << "Pointer mismatch! [key=" << curr->p_next[0]->key
+                << ",marked=" << curr->p_next[0]->marked << "] "
+                << curr->p_next[0] << " vs. [key=" << ptr->key
+                << ",marked=" << ptr->marked << "] " << curr->rqbundle.dump(0)
+                << std::flush;
+      valid = false;
+    }
+#ifdef BUNDLE_CLEANUP
+    if (curr->rqbundle.size() > 1) {
+      std::cout << curr->rqbundle.dump(0) << std::flush;
+      return false;
+    }
+#endif
+  }
+#endif
+  return valid;
+}
+
+#endif /* BUNDLE_UNROLLED_SKIPLIST_IMPL_H */
@@ -34,6 +34,7 @@
     #define MAX_NODES_INSERTED_OR_DELETED_ATOMICALLY 4
 #endif
 #include "rq_provider.h"
+#include "multiget.h"
 using namespace std;
 
 #define LOGICAL_DELETION_USAGE false
@@ -94,6 +95,9 @@ public:
     const V insertIfAbsent(const int tid, const K& key, const V& value);
     const pair<V, bool> erase(const int tid, const K& key);
     const pair<V, bool> find(const int tid, const K& key);
+    // looks up keys[0..n-1] with interleaved traversals (see multiget.h);
+    // values[i] is NO_VALUE if keys[i] is absent. returns the number of keys found.
+    int multiGet(const int tid, const K * const keys, const int n, V * const values);
     int rangeQuery(const int tid, const K& lo, const K& hi, K * const resultKeys, V * const resultValues);
     bool contains(const int tid, const K& key);
     int size(); // warning: this is a linear time operation, and is not linearizable
@@ -131,6 +131,40 @@ const pair<V, bool> citrustree<K,V,RecManager>::find(const int tid, const K& key
     return pair<V, bool>(result, true);
 }
 
+template <typename K, typename V, class RecManager>
+int citrustree<K,V,RecManager>::multiGet(const int tid, const K * const keys, const int n, V * const values) {
+    int idx[MULTIGET_GROUP_SIZE];
+    nodeptr curr[MULTIGET_GROUP_SIZE];
+    int found = 0;
+    auto start = [&](const int s, const int i) {
+        idx[s] = i;
+        curr[s] = rqProvider->read_addr(tid, &root->child[0]);
+        MULTIGET_PREFETCH(curr[s]);
+    };
+    auto step = [&](const int s) {
+        const K& key = keys[idx[s]];
+        if (curr[s] == NULL) {
+            values[idx[s]] = NO_VALUE;
+            return false;
+        }
+        K ckey = curr[s]->key;
+        if (ckey == key) {
+            values[idx[s]] = curr[s]->value;
+            ++found;
+            return false;
+        }
+        curr[s] = rqProvider->read_addr(tid, &curr[s]->child[ckey < key]);
+        MULTIGET_PREFETCH(curr[s]);
+        return true;
+    };
+    recordmgr->leaveQuiescentState(tid, true);
+    readLock();
+    multiget_run(n, start, step);
+    readUnlock();
+    recordmgr->enterQuiescentState(tid);
+    return found;
+}
+
 template <typename K, typename V, class RecManager>
 bool citrustree<K,V,RecManager>::contains(const int tid, const K& key) {
     return find(tid, key).second;
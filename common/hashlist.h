@@ -46,6 +46,161 @@
         }
     };
 
+#elif defined USE_PROBING_HASHLIST
+
+    /**
+     * Open addressing set of keys, for the duplicate checks of range queries.
+     * Keys live in groups of HL_GROUP_SIZE slots, one group per cache line,
+     * and are probed a group at a time (with one AVX2 compare for 8 byte keys,
+     * when compiled with -mavx2). Groups fill from the front, so a group that
+     * is not full ends a probe sequence.
+     * Each group is tagged with the generation in which it was last written,
+     * and groups from older generations are empty, so clear() is O(1).
+     */
+
+    #include "plaf.h"
+    #include <algorithm>
+    #include <cassert>
+    #include <cstdint>
+    #include <cstdlib>
+    #include <cstring>
+    #include <iostream>
+    #ifdef __AVX2__
+        #include <immintrin.h>
+    #endif
+    #ifndef BIG_CONSTANT
+        #define BIG_CONSTANT(x) (x##LLU)
+    #endif
+
+    #define HL_GROUP_SIZE 4
+
+    template <typename T>
+    class HashList {
+    private:
+        struct group_t {
+            T keys[HL_GROUP_SIZE];
+            uint32_t gen;   // group is empty unless gen == current generation
+            uint32_t count; // number of keys in the group
+        } __attribute__((aligned(BYTES_IN_CACHE_LINE)));
+
+        volatile char padding0[PREFETCH_SIZE_BYTES];
+        group_t * groups;
+        long long numGroups;    // power of 2
+        long long size;
+        uint32_t gen;
+        volatile char padding1[PREFETCH_SIZE_BYTES];
+
+        inline long long hash(const T& element) {
+            unsigned long long p = (unsigned long long) element;
+            p ^= p >> 33;
+            p *= BIG_CONSTANT(0xff51afd7ed558ccd);
+            p ^= p >> 33;
+            p *= BIG_CONSTANT(0xc4ceb9fe1a85ec53);
+            p ^= p >> 33;
+            return p & (numGroups - 1);
+        }
+
+        inline bool groupContains(group_t * const g, const T& element) {
+#ifdef __AVX2__
+            if (sizeof(T) == 8) {
+                const __m256i needle = _mm256_set1_epi64x((long long) element);
+                const __m256i keys = _mm256_load_si256((const __m256i *) g->keys);
+                const int mask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(needle, keys)));
+                return mask & ((1 << g->count) - 1);
+            }
+#endif
+            for (uint32_t i=0;i<g->count;++i) {
+                if (g->keys[i] == element) return true;
+            }
+            return false;
+        }
+
+        // returns the group containing element, or the group it would be inserted in
+        inline group_t * findGroup(const T& element) {
+            long long ix = hash(element);
+            while (true) {
+                group_t * const g = &groups[ix];
+                if (g->gen != gen) return g;
+                if (groupContains(g, element)) return g;
+                if (g->count < HL_GROUP_SIZE) return g;
+                ix = (ix + 1) & (numGroups - 1);
+            }
+        }
+
+        inline void allocate(const long long _numGroups) {
+            numGroups = _numGroups;
+            // new[] need not honour the alignment of group_t before c++17
+            if (posix_memalign((void **) &groups, BYTES_IN_CACHE_LINE, sizeof(group_t) * numGroups)) {
+                std::cout<<"ERROR: could not allocate hash table"<<std::endl;
+                exit(-1);
+            }
+            memset(groups, 0, sizeof(group_t) * numGroups);
+        }
+
+        // keep the table at most half full
+        inline void tryExpand() {
+            if (2 * size <= numGroups * HL_GROUP_SIZE) return;
+            group_t * const oldGroups = groups;
+            const long long oldNumGroups = numGroups;
+            const uint32_t oldGen = gen;
+            allocate(2 * oldNumGroups);
+            gen = 1;
+            for (long long i=0;i<oldNumGroups;++i) {
+                group_t * const old = &oldGroups[i];
+                if (old->gen != oldGen) continue;
+                for (uint32_t j=0;j<old->count;++j) {
+                    addToGroup(findGroup(old->keys[j]), old->keys[j]);
+                }
+            }
+            free(oldGroups);
+        }
+
+        inline void addToGroup(group_t * const g, const T& element) {
+            if (g->gen != gen) {
+                g->gen = gen;
+                g->count = 0;
+            }
+            g->keys[g->count++] = element;
+        }
+
+    public:
+        void init(const long long initCapacityPow2) {
+            assert(__builtin_popcount(initCapacityPow2) == 1);
+            // at least two slots per key keeps probe sequences short
+            allocate(std::max(1LL, 2 * initCapacityPow2 / HL_GROUP_SIZE));
+            size = 0;
+            gen = 1;
+        }
+
+        void destroy() {
+            free(groups);
+        }
+
+        inline void clear() {
+            size = 0;
+            if (++gen == 0) {
+                // generations wrapped around, so tags from long ago could match
+                for (long long i=0;i<numGroups;++i) groups[i].gen = 0;
+                gen = 1;
+            }
+        }
+
+        inline bool contains(const T& element) {
+            group_t * const g = findGroup(element);
+            return g->gen == gen && groupContains(g, element);
+        }
+
+        inline void insert(const T& element) {
+            group_t * const g = findGroup(element);
+            if (g->gen == gen && groupContains(g, element)) return;
+            addToGroup(g, element);
+            ++size;
+            tryExpand();
+        }
+
+        inline long long getSize() { return size; }
+    };
+
 #elif defined USE_SIMPLIFIED_HASHLIST
 
     #include "plaf.h"
@@ -0,0 +1,41 @@
+/*
+ * File:   htm_support.h
+ *
+ * Runtime check for RTM, so that binaries built with an HTM fast path can run
+ * on machines without TSX (or with TSX disabled by microcode) by taking their
+ * software path instead.
+ *
+ * CPUID tells us whether XBEGIN exists. Some parts report RTM but abort every
+ * transaction, so, like test_htm_support.cpp, we also run a few trivial
+ * transactions and require that at least one of them commits.
+ */
+
+#ifndef HTM_SUPPORT_H
+#define HTM_SUPPORT_H
+
+#include <cpuid.h>
+#include "rtm.h"
+
+#define HTM_SUPPORT_PROBE_ATTEMPTS 64
+
+inline bool htm_support_probe() {
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) return false;
+    if (!(ebx & (1 << 11))) return false; // RTM
+    for (int i=0;i<HTM_SUPPORT_PROBE_ATTEMPTS;++i) {
+        if (XBEGIN() == _XBEGIN_STARTED) {
+            XEND();
+            return true;
+        }
+    }
+    return false;
+}
+
+// Probes on first use. Function-local static so the header can be included
+// in several translation units.
+inline bool htm_supported() {
+    static const bool supported = htm_support_probe();
+    return supported;
+}
+
+#endif /* HTM_SUPPORT_H */
@@ -0,0 +1,57 @@
+/*
+ * File:   multiget.h
+ *
+ * Driver for batched lookups (multiGet) that interleaves the traversals of
+ * several keys, so that the cache misses of one traversal overlap with the
+ * work of the others (asynchronous memory access chaining).
+ *
+ * Up to MULTIGET_GROUP_SIZE lookups are in flight at once, each in its own
+ * slot. The driver visits the slots round-robin and advances each lookup by
+ * one node; a data structure prefetches the node a lookup will read next, so
+ * by the time the driver returns to that slot the node is (hopefully) in the
+ * cache. As soon as a lookup finishes, its slot starts the next key.
+ *
+ * Every lookup returns the same result as find() and is linearized on its
+ * own; a batch is not atomic.
+ */
+
+#ifndef MULTIGET_H
+#define MULTIGET_H
+
+#ifndef MULTIGET_GROUP_SIZE
+#define MULTIGET_GROUP_SIZE 8
+#endif
+
+// Read prefetch into all cache levels.
+#define MULTIGET_PREFETCH(addr) __builtin_prefetch((const void *) (addr), 0, 3)
+
+/**
+ * Looks up keys 0..n-1. start(slot, i) begins the lookup of key i in slot and
+ * prefetches the first node it will read. step(slot) advances the lookup in
+ * slot by one node and prefetches the next one; it returns false once the
+ * lookup has finished and stored its result.
+ */
+template <typename Start, typename Step>
+inline void multiget_run(const int n, Start& start, Step& step) {
+    int slots = (n < MULTIGET_GROUP_SIZE) ? n : MULTIGET_GROUP_SIZE;
+    bool active[MULTIGET_GROUP_SIZE];
+    int next = 0;
+    for (int s = 0; s < slots; ++s) {
+        start(s, next++);
+        active[s] = true;
+    }
+    int numActive = slots;
+    while (numActive > 0) {
+        for (int s = 0; s < slots; ++s) {
+            if (!active[s] || step(s)) continue;
+            if (next < n) {
+                start(s, next++);
+            } else {
+                active[s] = false;
+                --numActive;
+            }
+        }
+    }
+}
+
+#endif /* MULTIGET_H */
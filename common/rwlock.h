@@ -169,6 +169,132 @@ public:
     }
 };
 
+#elif defined RWLOCK_BRAVO
+
+/**
+ * BRAVO reader-writer lock (Dice and Kogan, "BRAVO: Biased Locking for
+ * Reader-Writer Locks", USENIX ATC 2019), layered over the reader-preference
+ * lock above.
+ *
+ * While the lock is reader-biased, a reader only CASes its own padded slot
+ * from 0 to 1 and re-checks the bias, so concurrent readers do not write any
+ * shared cache line. A writer takes the underlying lock, revokes the bias and
+ * waits for the slots to drain. Revocation is slow, so readers that find the
+ * lock unbiased use the underlying counter, and the bias is only restored
+ * BRAVO_INHIBIT_MULTIPLIER times the last revocation's duration later.
+ *
+ * Threads pick a slot on their first read-lock. If two threads end up on the
+ * same slot (more than BRAVO_SLOTS threads), whichever finds it occupied takes
+ * the slow path.
+ */
+
+#include <x86intrin.h>
+#include <atomic>
+
+#ifndef BRAVO_SLOTS
+#define BRAVO_SLOTS MAX_TID_POW2 // must be a power of two
+#endif
+#ifndef BRAVO_INHIBIT_MULTIPLIER
+#define BRAVO_INHIBIT_MULTIPLIER 9
+#endif
+
+class RWLock {
+private:
+    union slot_t {
+        volatile long long readers;
+        volatile char bytes[PREFETCH_SIZE_BYTES];
+    } __attribute__((aligned(BYTES_IN_CACHE_LINE)));
+
+    volatile char padding0[PREFETCH_SIZE_BYTES];
+    volatile long long lock; // two bit fields: [ number of readers ] [ writer bit ]
+    volatile bool rbias;
+    volatile unsigned long long inhibitUntil;
+    volatile char padding1[PREFETCH_SIZE_BYTES];
+    slot_t slots[BRAVO_SLOTS];
+
+    static inline int mySlot() {
+        static std::atomic<int> nextSlot(0);
+        static thread_local int slot = nextSlot.fetch_add(1) & (BRAVO_SLOTS-1);
+        return slot;
+    }
+    // identifies the calling thread in the slot it occupies
+    static inline long long myToken() {
+        static thread_local char token;
+        return (long long) &token;
+    }
+    inline bool isSlowReadLocked() {
+        return lock & ~1;
+    }
+    inline bool isFastReadLocked() {
+        for (int i=0;i<BRAVO_SLOTS;++i) {
+            if (slots[i].readers) return true;
+        }
+        return false;
+    }
+    inline void slowReadLock() {
+        __sync_add_and_fetch(&lock, 2);
+        while (isWriteLocked());
+        // no writer can be active now, so it is safe to restore the bias
+        if (!rbias && __rdtsc() >= inhibitUntil) rbias = true;
+    }
+    
+public:
+    RWLock() {
+        lock = 0;
+        rbias = true;
+        inhibitUntil = 0;
+        for (int i=0;i<BRAVO_SLOTS;++i) slots[i].readers = 0;
+    }
+    inline bool isWriteLocked() {
+        return lock & 1;
+    }
+    inline bool isReadLocked() {
+        return isSlowReadLocked() || isFastReadLocked();
+    }
+    inline bool isLocked() {
+        return lock || isFastReadLocked();
+    }
+    inline void readLock() {
+        if (rbias) {
+            slot_t * const slot = &slots[mySlot()];
+            if (__sync_bool_compare_and_swap(&slot->readers, 0, myToken())) {
+                // the CAS is a full fence, so a writer that has not yet
+                // revoked the bias will see our slot when it scans
+                if (rbias) return;
+                slot->readers = 0;
+            }
+        }
+        slowReadLock();
+    }
+    inline void readUnlock() {
+        slot_t * const slot = &slots[mySlot()];
+        if (slot->readers == myToken()) {
+            slot->readers = 0;
+        } else {
+            __sync_add_and_fetch(&lock, -2);
+        }
+    }
+    inline void writeLock() {
+        // readers in the slots are waited for after the bias is revoked, so
+        // that new fast-path readers cannot starve this writer
+        while (1) {
+            while (lock) {}
+            if (__sync_bool_compare_and_swap(&lock, 0, 1)) break;
+        }
+        if (rbias) {
+            rbias = false;
+            __sync_synchronize();
+            const unsigned long long start = __rdtsc();
+            while (isFastReadLocked()) {}
+            const unsigned long long now = __rdtsc();
+            inhibitUntil = now + (now - start) * BRAVO_INHIBIT_MULTIPLIER;
+        }
+    }
+    inline void writeUnlock() {
+        __sync_add_and_fetch(&lock, -1);
+    }
+};
+
 #else
 #error Must specify RWLOCK implementation; see rwlock.h
 #endif
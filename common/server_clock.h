@@ -8,19 +8,19 @@
 #ifndef SERVER_CLOCK_H
 #define SERVER_CLOCK_H
 
-#ifndef CPU_FREQ_GHZ
-#error "Must define CPU_FREQ_GHZ for server_clock.h"
-#endif
+#include "tsc_calibration.h"
 
+// nanoseconds, using the TSC frequency measured at startup (tsc_calibration.h)
 inline uint64_t get_server_clock() {
 #if defined(__i386__)
     uint64_t ret;
     __asm__ __volatile__("rdtsc" : "=A" (ret));
+    ret = tsc_to_ns(ret);
 #elif defined(__x86_64__)
     unsigned hi, lo;
     __asm__ __volatile__ ("rdtsc" : "=a"(lo), "=d"(hi));
     uint64_t ret = ( (uint64_t)lo)|( ((uint64_t)hi)<<32 );
-        ret = (uint64_t) ((double)ret / CPU_FREQ_GHZ);
+        ret = tsc_to_ns(ret);
 #else 
         timespec * tp = new timespec;
     clock_gettime(CLOCK_REALTIME, tp);
@@ -0,0 +1,151 @@
+/*
+ * File:   tsc_calibration.h
+ *
+ * Startup calibration of the time stamp counter (TSC).
+ *
+ * Replaces the hard-coded cpu_freq_ghz from config.mk. The TSC frequency is
+ * measured against CLOCK_MONOTONIC_RAW the first time tsc_calibration() is
+ * called (main() does this before any timed region), and is turned into a
+ * fixed-point multiplier so that converting ticks to nanoseconds costs one
+ * 64x64->128 bit multiply and a shift instead of a double divide.
+ *
+ * CPUID is queried for an invariant TSC (constant rate, and not stopped in
+ * deep C-states). Without it, TSC values are not comparable over time or
+ * across cores, so the RDTSC-based timestamp providers refuse to run
+ * (see tsc_require_safe()).
+ */
+
+#ifndef TSC_CALIBRATION_H
+#define TSC_CALIBRATION_H
+
+#include <stdint.h>
+#include <time.h>
+#include <cstdlib>
+#include <iostream>
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+
+// ns = (ticks * ns_mult) >> TSC_CALIBRATION_SHIFT
+#define TSC_CALIBRATION_SHIFT 32
+// the reported frequency is the median over this many measurement windows
+#define TSC_CALIBRATION_ROUNDS 5
+#define TSC_CALIBRATION_WINDOW_NS 10000000ULL
+
+struct tsc_calibration_t {
+    bool invariant;         // CPUID.80000007H:EDX[8]
+    bool has_rdtscp;        // CPUID.80000001H:EDX[27]
+    uint64_t hz;            // measured TSC frequency
+    uint64_t ns_mult;       // fixed-point nanoseconds per tick
+};
+
+inline uint64_t tsc_monotonic_raw_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+inline uint64_t tsc_read_raw() {
+    return __rdtsc();
+}
+
+// Pairs a TSC read with the CLOCK_MONOTONIC_RAW time halfway between two
+// clock reads that bracket it. The tightest of a few tries is kept, so a
+// preemption or SMI between the reads does not skew the sample.
+inline void tsc_sample(uint64_t &ns, uint64_t &ticks) {
+    uint64_t best = ~0ULL;
+    for (int i = 0; i < 8; ++i) {
+        const uint64_t before = tsc_monotonic_raw_ns();
+        _mm_lfence();
+        const uint64_t t = tsc_read_raw();
+        _mm_lfence();
+        const uint64_t after = tsc_monotonic_raw_ns();
+        if (after - before < best) {
+            best = after - before;
+            ns = before + (after - before) / 2;
+            ticks = t;
+        }
+    }
+}
+
+inline tsc_calibration_t tsc_calibrate() {
+    tsc_calibration_t c;
+    unsigned eax, ebx, ecx, edx;
+    c.invariant = false;
+    c.has_rdtscp = false;
+    if (__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx)) {
+        const unsigned maxExtended = eax;
+        if (maxExtended >= 0x80000001 && __get_cpuid(0x80000001, &eax, &ebx, &ecx, &edx)) {
+            c.has_rdtscp = (edx >> 27) & 1;
+        }
+        if (maxExtended >= 0x80000007 && __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx)) {
+            c.invariant = (edx >> 8) & 1;
+        }
+    }
+
+    uint64_t rounds[TSC_CALIBRATION_ROUNDS];
+    for (int r = 0; r < TSC_CALIBRATION_ROUNDS; ++r) {
+        uint64_t ns0, ticks0, ns1, ticks1;
+        tsc_sample(ns0, ticks0);
+        while (tsc_monotonic_raw_ns() - ns0 < TSC_CALIBRATION_WINDOW_NS) {}
+        tsc_sample(ns1, ticks1);
+        rounds[r] = (uint64_t) ((unsigned __int128) (ticks1 - ticks0) * 1000000000ULL / (ns1 - ns0));
+    }
+    // insertion sort; there are only a handful of rounds
+    for (int i = 1; i < TSC_CALIBRATION_ROUNDS; ++i) {
+        for (int j = i; j > 0 && rounds[j-1] > rounds[j]; --j) {
+            const uint64_t tmp = rounds[j]; rounds[j] = rounds[j-1]; rounds[j-1] = tmp;
+        }
+    }
+    c.hz = rounds[TSC_CALIBRATION_ROUNDS / 2];
+    if (c.hz == 0) {
+        std::cerr<<"ERROR: TSC calibration measured a frequency of 0 Hz"<<std::endl;
+        exit(1);
+    }
+    c.ns_mult = (uint64_t) (((unsigned __int128) 1000000000ULL << TSC_CALIBRATION_SHIFT) / c.hz);
+    return c;
+}
+
+#else
+
+// no TSC: get_server_clock() falls back to clock_gettime, which is already in ns
+inline tsc_calibration_t tsc_calibrate() {
+    tsc_calibration_t c;
+    c.invariant = false;
+    c.has_rdtscp = false;
+    c.hz = 1000000000ULL;
+    c.ns_mult = 1ULL << TSC_CALIBRATION_SHIFT;
+    return c;
+}
+
+#endif
+
+// Calibrates on first use. Function-local static so the header can be
+// included in several translation units.
+inline const tsc_calibration_t &tsc_calibration() {
+    static const tsc_calibration_t c = tsc_calibrate();
+    return c;
+}
+
+inline uint64_t tsc_to_ns(const uint64_t ticks) {
+    return (uint64_t) (((unsigned __int128) ticks * tsc_calibration().ns_mult) >> TSC_CALIBRATION_SHIFT);
+}
+
+// Exits if the TSC cannot be used as a timestamp: it must be invariant, and
+// RDTSCP must exist if the caller uses it.
+inline void tsc_require_safe(const char *who, const bool needsRdtscp) {
+    const tsc_calibration_t &c = tsc_calibration();
+    if (!c.invariant) {
+        std::cerr<<"ERROR: "<<who<<" requires an invariant TSC, but CPUID.80000007H:EDX[8] is not set on this machine"<<std::endl;
+        exit(1);
+    }
+    if (needsRdtscp && !c.has_rdtscp) {
+        std::cerr<<"ERROR: "<<who<<" requires the RDTSCP instruction, which this CPU does not support"<<std::endl;
+        exit(1);
+    }
+}
+
+#endif /* TSC_CALIBRATION_H */
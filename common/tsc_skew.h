@@ -0,0 +1,143 @@
+/*
+ * File:   tsc_skew.h
+ *
+ * Startup probe for the worst-case TSC skew between the cores this process
+ * may run on.
+ *
+ * For every CPU in the affinity mask, a thread pinned to it plays ping-pong
+ * with a thread pinned to a reference CPU over one shared cache line. Each
+ * side publishes its TSC, and the other side reads its own TSC after seeing
+ * it. Since the read happens after the write in real time, the difference
+ * bounds the offset d = TSC(cpu) - TSC(reference) from one side per
+ * direction; the tightest bounds over many rounds give an interval
+ * [lo, hi] containing d. The reported epsilon bounds |TSC(a) - TSC(b)| for
+ * every pair of probed CPUs: max(hi) - min(lo), plus one so that it can be
+ * used as a strict bound. It includes the one-way cache line latency, so it
+ * is conservative.
+ */
+
+#ifndef TSC_SKEW_H
+#define TSC_SKEW_H
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <x86intrin.h>
+
+#ifndef TSC_SKEW_ROUNDS
+#define TSC_SKEW_ROUNDS 2000
+#endif
+
+struct tsc_skew_t {
+    int64_t epsilon;        // bound on |TSC(a) - TSC(b)| over probed CPUs, in ticks
+    int referenceCpu;
+    int worstCpu;           // CPU whose offset interval lies furthest from the reference
+    int probedCpus;
+};
+
+struct tsc_skew_line_t {
+    std::atomic<uint64_t> seq;
+    std::atomic<uint64_t> tsc;
+    char padding[64 - 2*sizeof(std::atomic<uint64_t>)];
+} __attribute__((aligned(64)));
+
+inline uint64_t tsc_skew_read() {
+    unsigned aux;
+    return __rdtscp(&aux);
+}
+
+inline void tsc_skew_pin(const int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set)) {
+        std::cerr<<"ERROR: could not pin the TSC skew probe to cpu "<<cpu<<std::endl;
+        exit(1);
+    }
+}
+
+// Measures [lo, hi] such that lo < TSC(cpu) - TSC(referenceCpu) < hi.
+inline void tsc_skew_probe_pair(const int referenceCpu, const int cpu, int64_t &lo, int64_t &hi) {
+    tsc_skew_line_t line;
+    line.seq.store(0);
+    line.tsc.store(0);
+    int64_t minBackward = INT64_MAX;    // min over rounds of TSC(reference) read - TSC(cpu) written
+    int64_t minForward = INT64_MAX;     // min over rounds of TSC(cpu) read - TSC(reference) written
+
+    std::thread reference([&]() {
+        tsc_skew_pin(referenceCpu);
+        for (uint64_t r = 0; r < TSC_SKEW_ROUNDS; ++r) {
+            line.tsc.store(tsc_skew_read(), std::memory_order_relaxed);
+            line.seq.store(2*r + 1, std::memory_order_release);
+            while (line.seq.load(std::memory_order_acquire) != 2*r + 2) {}
+            const int64_t diff = (int64_t) (tsc_skew_read() - line.tsc.load(std::memory_order_relaxed));
+            if (diff < minBackward) minBackward = diff;
+        }
+    });
+    std::thread probed([&]() {
+        tsc_skew_pin(cpu);
+        for (uint64_t r = 0; r < TSC_SKEW_ROUNDS; ++r) {
+            while (line.seq.load(std::memory_order_acquire) != 2*r + 1) {}
+            const int64_t diff = (int64_t) (tsc_skew_read() - line.tsc.load(std::memory_order_relaxed));
+            if (diff < minForward) minForward = diff;
+            line.tsc.store(tsc_skew_read(), std::memory_order_relaxed);
+            line.seq.store(2*r + 2, std::memory_order_release);
+        }
+    });
+    reference.join();
+    probed.join();
+    lo = -minBackward;
+    hi = minForward;
+}
+
+inline tsc_skew_t tsc_skew_probe() {
+    tsc_skew_t result;
+    result.epsilon = 0;
+    result.referenceCpu = -1;
+    result.worstCpu = -1;
+    result.probedCpus = 0;
+
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed)) {
+        std::cerr<<"ERROR: could not read the cpu affinity mask for the TSC skew probe"<<std::endl;
+        exit(1);
+    }
+    int64_t minLo = 0, maxHi = 0;   // the reference itself has offset exactly 0
+    int64_t worstWidth = -1;
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (!CPU_ISSET(cpu, &allowed)) continue;
+        ++result.probedCpus;
+        if (result.referenceCpu < 0) {
+            result.referenceCpu = cpu;
+            continue;
+        }
+        int64_t lo, hi;
+        tsc_skew_probe_pair(result.referenceCpu, cpu, lo, hi);
+        if (lo < minLo) minLo = lo;
+        if (hi > maxHi) maxHi = hi;
+        const int64_t width = (hi > -lo) ? hi : -lo;
+        if (width > worstWidth) {
+            worstWidth = width;
+            result.worstCpu = cpu;
+        }
+    }
+    result.epsilon = maxHi - minLo + 1;
+    return result;
+}
+
+// Probes on first use. Function-local static so the header can be included
+// in several translation units.
+inline const tsc_skew_t &tsc_skew() {
+    static const tsc_skew_t s = tsc_skew_probe();
+    return s;
+}
+
+#endif /* TSC_SKEW_H */
@@ -13,9 +13,8 @@
 #define VIRTUAL_PART_CNT 1
 #define PAGE_SIZE 4096
 #define CL_SIZE 64
-// CPU_FREQ is used to get accurate timing info
-//#define CPU_FREQ 					2.410426 	// in
-//GHz/s
+// timing info uses the TSC frequency measured at startup (see
+// common/tsc_calibration.h), so there is no CPU_FREQ to set here
 
 // # of transactions to run for warmup
 #define WARMUP 0
@@ -83,6 +82,8 @@
 #define TS_ALLOC TS_CAS
 #define TS_BATCH_ALLOC false
 #define TS_BATCH_NUM 1
+// clock used by the RQ provider of the index: logical, rdtsc or rdtscp
+#define RQ_TS_PROVIDER "logical"
 // [MVCC]
 // when read/write history is longer than HIS_RECYCLE_LEN
 // the history should be recycled.
@@ -141,7 +141,9 @@ typedef skiplist<KEY_TYPE, VALUE_TYPE, RECORD_MANAGER_TYPE> INDEX_TYPE;
 #define VALUES_ARRAY_TYPE VALUE_TYPE *
 
 #elif (INDEX_STRUCT == IDX_SKIPLISTLOCK_RQ_BUNDLE)
+#ifndef BUNDLE_CIRCULAR_BUNDLE
 #define BUNDLE_LINKED_BUNDLE
+#endif
 #define BUNDLE_OPTIMIZED_CONTAINS
 #include "bundle_skiplist_impl.h"
 typedef node_t<KEY_TYPE, VALUE_TYPE> NODE_TYPE;
@@ -163,7 +165,8 @@ typedef bundle_skiplist<KEY_TYPE, VALUE_TYPE, RECORD_MANAGER_TYPE> INDEX_TYPE;
 using namespace vcas_skiplist_lock;
 typedef node_t<KEY_TYPE, VALUE_TYPE> NODE_TYPE;
 typedef bool DESCRIPTOR_TYPE;  // no descriptor
-typedef record_manager<RECLAIMER_TYPE, ALLOCATOR_TYPE, POOL_TYPE, NODE_TYPE>
+typedef record_manager<RECLAIMER_TYPE, ALLOCATOR_TYPE, POOL_TYPE, NODE_TYPE,
+                       vcas_obj_t<NODE_TYPE *>, vcas_obj_t<long long>>
     RECORD_MANAGER_TYPE;
 typedef skiplist<KEY_TYPE, VALUE_TYPE, RECORD_MANAGER_TYPE> INDEX_TYPE;
 #define INDEX_CONSTRUCTOR_ARGS                   \
@@ -188,7 +191,9 @@ typedef unsafe_skiplist<KEY_TYPE, VALUE_TYPE, RECORD_MANAGER_TYPE> INDEX_TYPE;
 #define VALUES_ARRAY_TYPE VALUE_TYPE *
 
 #elif (INDEX_STRUCT == IDX_CITRUS_RQ_BUNDLE)
+#ifndef BUNDLE_CIRCULAR_BUNDLE
 #define BUNDLE_LINKED_BUNDLE
+#endif
 #define BUNDLE_OPTIMIZED_CONTAINS
 #include "bundle_citrus_impl.h"
 typedef node_t<KEY_TYPE, VALUE_TYPE> NODE_TYPE;
@@ -213,7 +218,8 @@ typedef bundle_citrustree<KEY_TYPE, VALUE_TYPE, RECORD_MANAGER_TYPE> INDEX_TYPE;
 using namespace vcas_citrus;
 typedef node_t<KEY_TYPE, VALUE_TYPE> NODE_TYPE;
 typedef bool DESCRIPTOR_TYPE;  // no descriptor
-typedef record_manager<RECLAIMER_TYPE, ALLOCATOR_TYPE, POOL_TYPE, NODE_TYPE>
+typedef record_manager<RECLAIMER_TYPE, ALLOCATOR_TYPE, POOL_TYPE, NODE_TYPE,
+                       vcas_obj_t<NODE_TYPE *>>
     RECORD_MANAGER_TYPE;
 typedef citrustree<KEY_TYPE, VALUE_TYPE, RECORD_MANAGER_TYPE> INDEX_TYPE;
 #define INDEX_CONSTRUCTOR_ARGS \
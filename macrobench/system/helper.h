@@ -4,6 +4,7 @@
 #include <iostream>
 #include <stdint.h>
 #include "global.h"
+#include "tsc_calibration.h"
 
 
 /************************************************/
@@ -90,6 +91,13 @@
 	if (STATS_ENABLE) \
 		stats.tmp_stats[tid]->name += value;
 
+// for code that may also run before a worker thread has set up its stats
+// (e.g., the indexes while the tables are loaded), or on a thread that is not
+// a worker (see rq/timestamp_provider.h)
+#define INC_STATS_IF_READY(tid, name, value) \
+	if (STATS_ENABLE && (uint64_t) (tid) < g_thread_cnt && stats._stats[tid]) \
+		stats._stats[tid]->name += value;
+
 #define INC_GLOB_STATS(name, value) \
 	if (STATS_ENABLE) \
 		stats.name += value;
@@ -168,6 +176,7 @@ uint64_t get_part_id(void * addr);
 //uint64_t merge_idx_key(uint64_t key1, uint64_t key2, uint64_t key3);
 
 extern timespec * res;
+// nanoseconds, using the TSC frequency measured at startup (tsc_calibration.h)
 inline uint64_t get_server_clock() {
 #if defined(__i386__)
     uint64_t ret;
@@ -176,7 +185,7 @@ inline uint64_t get_server_clock() {
     unsigned hi, lo;
     __asm__ __volatile__ ("rdtsc" : "=a"(lo), "=d"(hi));
     uint64_t ret = ( (uint64_t)lo)|( ((uint64_t)hi)<<32 );
-	ret = (uint64_t) ((double)ret / CPU_FREQ);
+	ret = tsc_to_ns(ret);
 #else 
 	timespec * tp = new timespec;
     clock_gettime(CLOCK_REALTIME, tp);
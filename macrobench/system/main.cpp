@@ -22,6 +22,8 @@ void parser(int argc, char *argv[]);
 
 int main(int argc, char *argv[]) {
   parser(argc, argv);
+  // calibrate the TSC before anything is timed (see tsc_calibration.h)
+  printf("TSC_HZ=%llu\n", (unsigned long long)tsc_calibration().hz);
 
   thread_pinning::configurePolicy(g_thread_cnt, g_thr_pinning_policy);
 
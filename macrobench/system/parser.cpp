@@ -1,5 +1,6 @@
 #include "global.h"
 #include "helper.h"
+#include "timestamp_provider.h"
 #include <string>
 
 void print_usage() {
@@ -21,6 +22,7 @@ void print_usage() {
 	
 	printf("\t-GbINT      ; TS_BATCH_ALLOC\n");
 	printf("\t-GuINT      ; TS_BATCH_NUM\n");
+	printf("\t-GsSTRING   ; RQ_TS_PROVIDER (logical, rdtsc, rdtscp or rdtscp_skew)\n");
 	
 	printf("\t-o STRING   ; output file\n\n");
 	printf("  [YCSB]:\n");
@@ -42,6 +44,7 @@ void print_usage() {
 }
 
 void parser(int argc, char * argv[]) {
+    const char * rq_ts_provider = RQ_TS_PROVIDER;
     g_params["abort_buffer_enable"] = ABORT_BUFFER_ENABLE ? "true" : "false";
     g_params["write_copy_form"] = WRITE_COPY_FORM;
     g_params["validation_lock"] = VALIDATION_LOCK;
@@ -78,6 +81,7 @@ void parser(int argc, char * argv[]) {
             else if (argv[i][2]=='l') g_dl_loop_detect = atoi(&argv[i][3]);
             else if (argv[i][2]=='b') g_ts_batch_alloc = atoi(&argv[i][3]);
             else if (argv[i][2]=='u') g_ts_batch_num = atoi(&argv[i][3]);
+            else if (argv[i][2]=='s') rq_ts_provider = &argv[i][3];
         } else if (argv[i][1]=='T') {
             if (argv[i][2]=='p') g_perc_payment = atof(&argv[i][3]);
             if (argv[i][2]=='u') g_wh_update = atoi(&argv[i][3]);
@@ -104,4 +108,9 @@ void parser(int argc, char * argv[]) {
     }
     if (g_thread_cnt<g_init_parallelism)
         g_init_parallelism = g_thread_cnt;
+    if (!timestamp_select(rq_ts_provider)) {
+        printf("bad RQ_TS_PROVIDER: %s\n", rq_ts_provider);
+        exit(1);
+    }
+    printf("RQ_TS_PROVIDER=%s\n", timestamp_kind_name(timestamp_selected_kind()));
 }
@@ -34,6 +34,9 @@ void Stats_thd::clear() {
 	time_ts_alloc = 0;
 	latency = 0;
 	time_query = 0;
+	timestamp_calls = 0;
+	timestamp_cas_skipped = 0;
+	timestamp_cas_lost = 0;
 }
 
 void Stats_tmp_index::clear() {
@@ -67,6 +70,8 @@ void Stats::init() {
 		return;
 	_stats = (Stats_thd**) 
 			_mm_malloc(sizeof(Stats_thd*) * g_thread_cnt, ALIGNMENT);
+	// threads set up their own stats later (see INC_STATS_IF_READY)
+	memset(_stats, 0, sizeof(Stats_thd*) * g_thread_cnt);
 	tmp_stats = (Stats_tmp**) 
 			_mm_malloc(sizeof(Stats_tmp*) * g_thread_cnt, ALIGNMENT);
 	dl_detect_time = 0;
@@ -375,6 +380,24 @@ void Stats::print(workload * wl) {
                 , ixThroughput
         );
         
+        /**
+         * Compute logical clock contention stats
+         */
+        uint64_t timestampCalls = 0;
+        uint64_t timestampCasSkipped = 0;
+        uint64_t timestampCasLost = 0;
+        for (uint64_t tid = 0; tid < g_thread_cnt; tid ++) {
+                timestampCalls += _stats[tid]->timestamp_calls;
+                timestampCasSkipped += _stats[tid]->timestamp_cas_skipped;
+                timestampCasLost += _stats[tid]->timestamp_cas_lost;
+        }
+        printf("Timestamp stats: "
+                "timestampCalls=%ld, timestampCasSkipped=%ld, timestampCasLost=%ld\n"
+                , timestampCalls
+                , timestampCasSkipped
+                , timestampCasLost
+        );
+        
         /**
          * Print summary
          */
@@ -44,6 +44,11 @@ public:
 	uint64_t debug5;
 	
 	uint64_t latency;       // unused
+	// contention on the logical clocks of the range query providers, summed
+	// over all indexes (see rq/timestamp_provider.h)
+	uint64_t timestamp_calls;
+	uint64_t timestamp_cas_skipped;
+	uint64_t timestamp_cas_lost;
 	uint64_t * all_debug1;
 	uint64_t * all_debug2;
 	char _pad[CL_SIZE];
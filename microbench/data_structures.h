@@ -43,7 +43,8 @@ const test_type KEY_MAX =
 #define FIND_FUNC contains
 #endif
 
-#if defined ABTREE || defined BSLACK
+#if defined ABTREE || defined BSLACK || defined BUNDLE_ABTREE || \
+    defined VCAS_ABTREE
 #define VALUE ((void *)(int64_t)key)
 #define KEY keys[0]
 #define VALUE_TYPE void *
@@ -79,6 +80,10 @@ using namespace bslack_ns;
   (rqcnt) = ds->RQ_FUNC(tid, key, key + RQSIZE - 1, rqResultKeys, \
                         (VALUE_TYPE *)rqResultValues)
 #define RQ_GARBAGE(rqcnt) rqResultKeys[0] + rqResultKeys[(rqcnt)-1]
+#ifdef RQ_LOCKFREE
+#define RQ_AGGREGATE_AND_COUNT(aggregate) \
+  ds->rangeQueryAggregate(tid, key, key + RQSIZE - 1, aggregate)
+#endif
 #define INIT_THREAD(tid) ds->initThread(tid)
 #define DEINIT_THREAD(tid) ds->deinitThread(tid)
 #define INIT_ALL
@@ -104,6 +109,8 @@ using namespace bst_ns;
   ds->INSERT_FUNC(tid, key, VALUE) == ds->NO_VALUE
 #define DELETE_AND_CHECK_SUCCESS ds->ERASE_FUNC(tid, key).second
 #define FIND_AND_CHECK_SUCCESS ds->FIND_FUNC(tid, key)
+#define MULTIGET_AND_COUNT(keys, n, values) \
+  ds->multiGet(tid, keys, n, values)
 #define RQ_AND_CHECK_SUCCESS(rqcnt)                               \
   (rqcnt) = ds->RQ_FUNC(tid, key, key + RQSIZE - 1, rqResultKeys, \
                         (VALUE_TYPE *)rqResultValues)
@@ -130,6 +137,8 @@ using namespace bst_ns;
   ds->INSERT_FUNC(tid, key, VALUE) == ds->NO_VALUE
 #define DELETE_AND_CHECK_SUCCESS ds->ERASE_FUNC(tid, key).second
 #define FIND_AND_CHECK_SUCCESS ds->FIND_FUNC(tid, key)
+#define MULTIGET_AND_COUNT(keys, n, values) \
+  ds->multiGet(tid, keys, n, values)
 #define RQ_AND_CHECK_SUCCESS(rqcnt)                             \
   rqcnt = ds->RQ_FUNC(tid, key, key + RQSIZE - 1, rqResultKeys, \
                       (VALUE_TYPE *)rqResultValues)
@@ -156,6 +165,9 @@ using namespace bst_ns;
 #define DS_CONSTRUCTOR \
   new DS_DECLARATION(TOTAL_THREADS, KEY_MIN, KEY_MAX, NO_VALUE)
 
+// bulk prefilling inserts every key next to the head (see prefill_bulk)
+#define BULK_PREFILL_DESCENDING
+
 #define INSERT_AND_CHECK_SUCCESS \
   ds->INSERT_FUNC(tid, key, VALUE) == ds->NO_VALUE
 #define DELETE_AND_CHECK_SUCCESS ds->ERASE_FUNC(tid, key) != ds->NO_VALUE
@@ -187,6 +199,8 @@ using namespace bst_ns;
   ds->INSERT_FUNC(tid, key, VALUE) == ds->NO_VALUE
 #define DELETE_AND_CHECK_SUCCESS ds->ERASE_FUNC(tid, key) != ds->NO_VALUE
 #define FIND_AND_CHECK_SUCCESS ds->FIND_FUNC(tid, key)
+#define MULTIGET_AND_COUNT(keys, n, values) \
+  ds->multiGet(tid, keys, n, values)
 #define RQ_AND_CHECK_SUCCESS(rqcnt)                              \
   (rqcnt = ds->RQ_FUNC(tid, key, key + RQSIZE - 1, rqResultKeys, \
                        (VALUE_TYPE *)rqResultValues))
@@ -202,8 +216,8 @@ using namespace bst_ns;
        << endl;
 
 #elif defined(LFLIST)
-#include "lockfree_list_impl.h"
 #include "record_manager.h"
+#include "lockfree_list_impl.h"
 
 #define DS_DECLARATION lflist<test_type, test_type, MEMMGMT_T>
 #define MEMMGMT_T                      \
@@ -212,6 +226,9 @@ using namespace bst_ns;
 #define DS_CONSTRUCTOR \
   new DS_DECLARATION(TOTAL_THREADS, KEY_MIN, KEY_MAX, NO_VALUE)
 
+// bulk prefilling inserts every key next to the head (see prefill_bulk)
+#define BULK_PREFILL_DESCENDING
+
 #define INSERT_AND_CHECK_SUCCESS \
   ds->INSERT_FUNC(tid, key, VALUE) == ds->NO_VALUE
 #define DELETE_AND_CHECK_SUCCESS ds->ERASE_FUNC(tid, key) != ds->NO_VALUE
@@ -270,6 +287,9 @@ using namespace bst_ns;
 #define DS_CONSTRUCTOR \
   new DS_DECLARATION(TOTAL_THREADS, KEY_MIN, KEY_MAX, NO_VALUE)
 
+// bulk prefilling inserts every key next to the head (see prefill_bulk)
+#define BULK_PREFILL_DESCENDING
+
 #define INSERT_AND_CHECK_SUCCESS \
   ds->INSERT_FUNC(tid, key, VALUE) == ds->NO_VALUE
 #define DELETE_AND_CHECK_SUCCESS ds->ERASE_FUNC(tid, key).second
@@ -333,7 +353,6 @@ rlu_thread_data_t *rlu_tdata = NULL;
        << " including header=" << RLU_OBJ_HEADER_SIZE << endl;
 
 #elif defined(BUNDLE_LIST)
-#define BUNDLE_TYPE_DECL LinkedBundle
 #include "record_manager.h"
 #include "bundle_lazylist_impl.h"
 
@@ -343,6 +362,9 @@ rlu_thread_data_t *rlu_tdata = NULL;
 #define DS_CONSTRUCTOR \
   new DS_DECLARATION(TOTAL_THREADS + 1, KEY_MIN, KEY_MAX, NO_VALUE)
 
+// bulk prefilling inserts every key next to the head (see prefill_bulk)
+#define BULK_PREFILL_DESCENDING
+
 #define INSERT_AND_CHECK_SUCCESS \
   ds->INSERT_FUNC(tid, key, VALUE) == ds->NO_VALUE
 #define DELETE_AND_CHECK_SUCCESS ds->ERASE_FUNC(tid, key) != ds->NO_VALUE
@@ -351,6 +373,10 @@ rlu_thread_data_t *rlu_tdata = NULL;
   rqcnt = ds->RQ_FUNC(tid, key, key + RQSIZE - 1, rqResultKeys, \
                       (VALUE_TYPE *)rqResultValues)
 #define RQ_GARBAGE(rqcnt) rqResultKeys[0] + rqResultKeys[rqcnt - 1]
+#define RQ_VISIT_AND_COUNT(visitor) \
+  ds->rangeQueryVisit(tid, key, key + RQSIZE - 1, visitor)
+#define RQ_AGGREGATE_AND_COUNT(aggregate) \
+  ds->rangeQueryVisit(tid, key, key + RQSIZE - 1, aggregate)
 #define INIT_THREAD(tid) ds->initThread(tid)
 #define INIT_RQ_THREAD(tid) ds->initThread(tid, true)
 #define DEINIT_THREAD(tid) ds->deinitThread(tid);
@@ -362,6 +388,47 @@ rlu_thread_data_t *rlu_tdata = NULL;
 #define INIT_ALL
 #define DEINIT_ALL VALIDATE_BUNDLES
 
+#define BUNDLE_OBJ_SIZE (sizeof(BUNDLE_TYPE_DECL<node_t<test_type, test_type>>))
+#define PRINT_OBJ_SIZES                                              \
+  cout << "sizes: node="                                             \
+       << ((sizeof(node_t<test_type, test_type>)) + BUNDLE_OBJ_SIZE) \
+       << " including header=" << BUNDLE_OBJ_SIZE << endl;
+
+#elif defined(BUNDLE_LFLIST)
+#define BUNDLE_LOCKFREE
+#include "record_manager.h"
+#include "bundle_lockfree_list_impl.h"
+
+#define DS_DECLARATION bundle_lflist<test_type, test_type, MEMMGMT_T>
+#define MEMMGMT_T \
+  record_manager<RECLAIM, ALLOC, POOL, node_t<test_type, test_type>>
+#define DS_CONSTRUCTOR \
+  new DS_DECLARATION(TOTAL_THREADS, KEY_MIN, KEY_MAX, NO_VALUE)
+
+// bulk prefilling inserts every key next to the head (see prefill_bulk)
+#define BULK_PREFILL_DESCENDING
+
+#define INSERT_AND_CHECK_SUCCESS \
+  ds->INSERT_FUNC(tid, key, VALUE) == ds->NO_VALUE
+#define DELETE_AND_CHECK_SUCCESS ds->ERASE_FUNC(tid, key) != ds->NO_VALUE
+#define FIND_AND_CHECK_SUCCESS ds->FIND_FUNC(tid, key)
+#define RQ_AND_CHECK_SUCCESS(rqcnt)                             \
+  rqcnt = ds->RQ_FUNC(tid, key, key + RQSIZE - 1, rqResultKeys, \
+                      (VALUE_TYPE *)rqResultValues)
+#define RQ_GARBAGE(rqcnt) rqResultKeys[0] + rqResultKeys[rqcnt - 1]
+#define RQ_VISIT_AND_COUNT(visitor) \
+  ds->rangeQueryVisit(tid, key, key + RQSIZE - 1, visitor)
+#define RQ_AGGREGATE_AND_COUNT(aggregate) \
+  ds->rangeQueryVisit(tid, key, key + RQSIZE - 1, aggregate)
+#define INIT_THREAD(tid) ds->initThread(tid)
+#define DEINIT_THREAD(tid) ds->deinitThread(tid);
+#define VALIDATE_BUNDLES                                  \
+  ((DS_DECLARATION *)glob.__ds)->validateBundles(0)       \
+      ? std::cout << "Bundle validation OK." << std::endl \
+      : std::cout << "Bundle validation failed." << std::endl;
+#define INIT_ALL
+#define DEINIT_ALL VALIDATE_BUNDLES
+
 #define BUNDLE_OBJ_SIZE (sizeof(BUNDLE_TYPE_DECL<node_t<test_type, test_type>>))
 #define PRINT_OBJ_SIZES                                              \
   cout << "sizes: node="                                             \
@@ -382,10 +449,16 @@ rlu_thread_data_t *rlu_tdata = NULL;
   ds->INSERT_FUNC(tid, key, VALUE) == ds->NO_VALUE
 #define DELETE_AND_CHECK_SUCCESS ds->ERASE_FUNC(tid, key) != ds->NO_VALUE
 #define FIND_AND_CHECK_SUCCESS ds->FIND_FUNC(tid, key)
+#define MULTIGET_AND_COUNT(keys, n, values) \
+  ds->multiGet(tid, keys, n, values)
 #define RQ_AND_CHECK_SUCCESS(rqcnt)                             \
   rqcnt = ds->RQ_FUNC(tid, key, key + RQSIZE - 1, rqResultKeys, \
                       (VALUE_TYPE *)rqResultValues)
 #define RQ_GARBAGE(rqcnt) rqResultKeys[0] + rqResultKeys[rqcnt - 1]
+#define RQ_VISIT_AND_COUNT(visitor) \
+  ds->rangeQueryVisit(tid, key, key + RQSIZE - 1, visitor)
+#define RQ_AGGREGATE_AND_COUNT(aggregate) \
+  ds->rangeQueryVisit(tid, key, key + RQSIZE - 1, aggregate)
 #define INIT_THREAD(tid) ds->initThread(tid)
 #define DEINIT_THREAD(tid) ds->deinitThread(tid);
 #define VALIDATE_BUNDLES                                  \
@@ -401,8 +474,45 @@ rlu_thread_data_t *rlu_tdata = NULL;
        << ((sizeof(node_t<test_type, test_type>)) + BUNDLE_OBJ_SIZE) \
        << " including header=" << BUNDLE_OBJ_SIZE << endl;
 
+#elif defined(BUNDLE_UNROLLED_SKIPLIST)
+#include "record_manager.h"
+#include "bundle_unrolled_skiplist_impl.h"
+
+#define DS_DECLARATION bundle_unrolled_skiplist<test_type, test_type, MEMMGMT_T>
+#define MEMMGMT_T \
+  record_manager<RECLAIM, ALLOC, POOL, unrolled_node_t<test_type, test_type>>
+#define DS_CONSTRUCTOR \
+  new DS_DECLARATION(TOTAL_THREADS + 1, KEY_MIN, KEY_MAX, NO_VALUE, glob.rngs)
+
+#define INSERT_AND_CHECK_SUCCESS \
+  ds->INSERT_FUNC(tid, key, VALUE) == ds->NO_VALUE
+#define DELETE_AND_CHECK_SUCCESS ds->ERASE_FUNC(tid, key) != ds->NO_VALUE
+#define FIND_AND_CHECK_SUCCESS ds->FIND_FUNC(tid, key)
+#define RQ_AND_CHECK_SUCCESS(rqcnt)                             \
+  rqcnt = ds->RQ_FUNC(tid, key, key + RQSIZE - 1, rqResultKeys, \
+                      (VALUE_TYPE *)rqResultValues)
+#define RQ_GARBAGE(rqcnt) rqResultKeys[0] + rqResultKeys[rqcnt - 1]
+#define RQ_VISIT_AND_COUNT(visitor) \
+  ds->rangeQueryVisit(tid, key, key + RQSIZE - 1, visitor)
+#define RQ_AGGREGATE_AND_COUNT(aggregate) \
+  ds->rangeQueryVisit(tid, key, key + RQSIZE - 1, aggregate)
+#define INIT_THREAD(tid) ds->initThread(tid)
+#define DEINIT_THREAD(tid) ds->deinitThread(tid);
+#define VALIDATE_BUNDLES                                  \
+  ((DS_DECLARATION *)glob.__ds)->validateBundles(0)       \
+      ? std::cout << "Bundle validation OK." << std::endl \
+      : std::cout << "Bundle validation failed." << std::endl;
+#define INIT_ALL
+#define DEINIT_ALL VALIDATE_BUNDLES
+
+#define BUNDLE_OBJ_SIZE \
+  (sizeof(BUNDLE_TYPE_DECL<unrolled_node_t<test_type, test_type>>))
+#define PRINT_OBJ_SIZES                                                       \
+  cout << "sizes: node="                                                      \
+       << ((sizeof(unrolled_node_t<test_type, test_type>)) + BUNDLE_OBJ_SIZE) \
+       << " including header=" << BUNDLE_OBJ_SIZE << endl;
+
 #elif defined(BUNDLE_CITRUS)
-#define BUNDLE_TYPE_DECL LinkedBundle
 #include "bundle_citrus_impl.h"
 #include "record_manager.h"
 
@@ -415,10 +525,16 @@ rlu_thread_data_t *rlu_tdata = NULL;
   ds->INSERT_FUNC(tid, key, VALUE) == ds->NO_VALUE
 #define DELETE_AND_CHECK_SUCCESS ds->ERASE_FUNC(tid, key).second
 #define FIND_AND_CHECK_SUCCESS ds->FIND_FUNC(tid, key)
+#define MULTIGET_AND_COUNT(keys, n, values) \
+  ds->multiGet(tid, keys, n, values)
 #define RQ_AND_CHECK_SUCCESS(rqcnt)                             \
   rqcnt = ds->RQ_FUNC(tid, key, key + RQSIZE - 1, rqResultKeys, \
                       (VALUE_TYPE *)rqResultValues)
 #define RQ_GARBAGE(rqcnt) rqResultKeys[0] + rqResultKeys[rqcnt - 1]
+#define RQ_VISIT_AND_COUNT(visitor) \
+  ds->rangeQueryVisit(tid, key, key + RQSIZE - 1, visitor)
+#define RQ_AGGREGATE_AND_COUNT(aggregate) \
+  ds->rangeQueryAggregate(tid, key, key + RQSIZE - 1, aggregate)
 #define INIT_THREAD(tid) \
   ds->initThread(tid);   \
   urcu::registerThread(tid);
@@ -441,7 +557,6 @@ rlu_thread_data_t *rlu_tdata = NULL;
        << " including header=" << BUNDLE_OBJ_SIZE << endl;
 
 #elif defined(BUNDLE_BST)
-#define BUNDLE_TYPE_DECL LinkedBundle
 #define BUNDLE_LOCKFREE
 #include "bundle_bst_impl.h"
 #include "record_manager.h"
@@ -458,10 +573,14 @@ using namespace bundle_bst_ns;
   ds->INSERT_FUNC(tid, key, VALUE) == ds->NO_VALUE
 #define DELETE_AND_CHECK_SUCCESS ds->ERASE_FUNC(tid, key).second
 #define FIND_AND_CHECK_SUCCESS ds->FIND_FUNC(tid, key)
+#define MULTIGET_AND_COUNT(keys, n, values) \
+  ds->multiGet(tid, keys, n, values)
 #define RQ_AND_CHECK_SUCCESS(rqcnt)                               \
   (rqcnt) = ds->RQ_FUNC(tid, key, key + RQSIZE - 1, rqResultKeys, \
                         (VALUE_TYPE *)rqResultValues)
 #define RQ_GARBAGE(rqcnt) rqResultKeys[0] + rqResultKeys[(rqcnt)-1]
+#define RQ_VISIT_AND_COUNT(visitor) \
+  ds->rangeQueryVisit(tid, key, key + RQSIZE - 1, visitor)
 #define INIT_THREAD(tid) ds->initThread(tid)
 #define DEINIT_THREAD(tid) ds->deinitThread(tid)
 #define INIT_ALL
@@ -472,6 +591,41 @@ using namespace bundle_bst_ns;
   cout << "sizes: node=" << (sizeof(Node<test_type, test_type>)) \
        << " descriptor=" << (sizeof(SCXRecord<test_type, test_type>)) << endl;
 
+#elif defined(BUNDLE_ABTREE)
+#define BUNDLE_LOCKFREE
+#define USE_SIMPLIFIED_ABTREE_REBALANCING
+#define ABTREE_DEGREE 16
+#include "bundle_bslack_impl.h"
+#include "record_manager.h"
+using namespace bundle_bslack_ns;
+
+#define DS_DECLARATION \
+  bundle_bslack<ABTREE_DEGREE, test_type, less<test_type>, MEMMGMT_T>
+#define MEMMGMT_T \
+  record_manager<RECLAIM, ALLOC, POOL, Node<ABTREE_DEGREE, test_type>>
+#define DS_CONSTRUCTOR \
+  new DS_DECLARATION(TOTAL_THREADS, ABTREE_DEGREE, KEY_MAX, SIGQUIT)
+
+#define INSERT_AND_CHECK_SUCCESS \
+  ds->INSERT_FUNC(tid, key, VALUE) == ds->NO_VALUE
+#define DELETE_AND_CHECK_SUCCESS ds->ERASE_FUNC(tid, key).second
+#define FIND_AND_CHECK_SUCCESS ds->FIND_FUNC(tid, key)
+#define RQ_AND_CHECK_SUCCESS(rqcnt)                               \
+  (rqcnt) = ds->RQ_FUNC(tid, key, key + RQSIZE - 1, rqResultKeys, \
+                        (VALUE_TYPE *)rqResultValues)
+#define RQ_GARBAGE(rqcnt) rqResultKeys[0] + rqResultKeys[(rqcnt)-1]
+#define RQ_AGGREGATE_AND_COUNT(aggregate) \
+  ds->rangeQueryAggregate(tid, key, key + RQSIZE - 1, aggregate)
+#define INIT_THREAD(tid) ds->initThread(tid)
+#define DEINIT_THREAD(tid) ds->deinitThread(tid)
+#define INIT_ALL
+#define DEINIT_ALL
+
+#define PRINT_OBJ_SIZES                                                   \
+  cout << "sizes: node=" << (sizeof(Node<ABTREE_DEGREE, test_type>))      \
+       << " descriptor=" << (sizeof(SCXRecord<ABTREE_DEGREE, test_type>)) \
+       << endl;
+
 #elif defined(UNSAFE_LIST)
 #include "unsafe_lazylist_impl.h"
 #include "record_manager.h"
@@ -482,6 +636,9 @@ using namespace bundle_bst_ns;
 #define DS_CONSTRUCTOR \
   new DS_DECLARATION(TOTAL_THREADS, KEY_MIN, KEY_MAX, NO_VALUE)
 
+// bulk prefilling inserts every key next to the head (see prefill_bulk)
+#define BULK_PREFILL_DESCENDING
+
 #define INSERT_AND_CHECK_SUCCESS \
   ds->INSERT_FUNC(tid, key, VALUE) == ds->NO_VALUE
 #define DELETE_AND_CHECK_SUCCESS ds->ERASE_FUNC(tid, key) != ds->NO_VALUE
@@ -572,6 +729,8 @@ using namespace vcas_bst_ns;
   ds->INSERT_FUNC(tid, key, VALUE) == ds->NO_VALUE
 #define DELETE_AND_CHECK_SUCCESS ds->ERASE_FUNC(tid, key).second
 #define FIND_AND_CHECK_SUCCESS ds->FIND_FUNC(tid, key)
+#define MULTIGET_AND_COUNT(keys, n, values) \
+  ds->multiGet(tid, keys, n, values)
 #define RQ_AND_CHECK_SUCCESS(rqcnt)                               \
   (rqcnt) = ds->RQ_FUNC(tid, key, key + RQSIZE - 1, rqResultKeys, \
                         (VALUE_TYPE *)rqResultValues)
@@ -585,6 +744,40 @@ using namespace vcas_bst_ns;
   cout << "sizes: node=" << (sizeof(Node<test_type, test_type>)) \
        << " descriptor=" << (sizeof(SCXRecord<test_type, test_type>)) << endl;
 
+#elif defined(VCAS_ABTREE)
+#define USE_SIMPLIFIED_ABTREE_REBALANCING
+#define ABTREE_DEGREE 16
+#include "record_manager.h"
+#include "vcas_bslack_impl.h"
+using namespace vcas_bslack_ns;
+
+#define DS_DECLARATION \
+  vcas_bslack<ABTREE_DEGREE, test_type, less<test_type>, MEMMGMT_T>
+#define MEMMGMT_T \
+  record_manager<RECLAIM, ALLOC, POOL, Node<ABTREE_DEGREE, test_type>>
+#define DS_CONSTRUCTOR \
+  new DS_DECLARATION(TOTAL_THREADS, ABTREE_DEGREE, KEY_MAX, SIGQUIT)
+
+#define INSERT_AND_CHECK_SUCCESS \
+  ds->INSERT_FUNC(tid, key, VALUE) == ds->NO_VALUE
+#define DELETE_AND_CHECK_SUCCESS ds->ERASE_FUNC(tid, key).second
+#define FIND_AND_CHECK_SUCCESS ds->FIND_FUNC(tid, key)
+#define RQ_AND_CHECK_SUCCESS(rqcnt)                               \
+  (rqcnt) = ds->RQ_FUNC(tid, key, key + RQSIZE - 1, rqResultKeys, \
+                        (VALUE_TYPE *)rqResultValues)
+#define RQ_GARBAGE(rqcnt) rqResultKeys[0] + rqResultKeys[(rqcnt)-1]
+#define RQ_AGGREGATE_AND_COUNT(aggregate) \
+  ds->rangeQueryAggregate(tid, key, key + RQSIZE - 1, aggregate)
+#define INIT_THREAD(tid) ds->initThread(tid)
+#define DEINIT_THREAD(tid) ds->deinitThread(tid)
+#define INIT_ALL
+#define DEINIT_ALL
+
+#define PRINT_OBJ_SIZES                                                   \
+  cout << "sizes: node=" << (sizeof(Node<ABTREE_DEGREE, test_type>))      \
+       << " descriptor=" << (sizeof(SCXRecord<ABTREE_DEGREE, test_type>)) \
+       << endl;
+
 #elif defined(VCAS_LAZYLIST)
 
 #define NVCAS_OPTIMIZATION
@@ -595,11 +788,16 @@ using namespace vcas_lazylist;
 
 #define DS_DECLARATION \
   lazylist<test_type, test_type, MEMMGMT_T>
-#define MEMMGMT_T \
-  record_manager<RECLAIM, ALLOC, POOL, node_t<test_type, test_type> >
+#define MEMMGMT_T                                                    \
+  record_manager<RECLAIM, ALLOC, POOL, node_t<test_type, test_type>, \
+                 vcas_obj_t<node_t<test_type, test_type>*>,          \
+                 vcas_obj_t<long long> >
 #define DS_CONSTRUCTOR \
   new DS_DECLARATION(TOTAL_THREADS, KEY_MIN, KEY_MAX, NO_VALUE)
 
+// bulk prefilling inserts every key next to the head (see prefill_bulk)
+#define BULK_PREFILL_DESCENDING
+
 #define INSERT_AND_CHECK_SUCCESS \
   ds->INSERT_FUNC(tid, key, VALUE) == ds->NO_VALUE
 #define DELETE_AND_CHECK_SUCCESS ds->ERASE_FUNC(tid, key) != ds->NO_VALUE
@@ -608,6 +806,10 @@ using namespace vcas_lazylist;
   (rqcnt = ds->RQ_FUNC(tid, key, key + RQSIZE - 1, rqResultKeys, \
                        (VALUE_TYPE *)rqResultValues))
 #define RQ_GARBAGE(rqcnt) rqResultKeys[0] + rqResultKeys[(rqcnt)-1]
+#define RQ_VISIT_AND_COUNT(visitor) \
+  ds->rangeQueryVisit(tid, key, key + RQSIZE - 1, visitor)
+#define RQ_AGGREGATE_AND_COUNT(aggregate) \
+  ds->rangeQueryVisit(tid, key, key + RQSIZE - 1, aggregate)
 #define INIT_THREAD(tid) ds->initThread(tid)
 #define DEINIT_THREAD(tid) ds->deinitThread(tid)
 #define INIT_ALL
@@ -626,9 +828,10 @@ using namespace vcas_lazylist;
 using namespace vcas_skiplist_lock;
 
 #define DS_DECLARATION skiplist<test_type, test_type, MEMMGMT_T>
-#define MEMMGMT_T                      \
-  record_manager<RECLAIM, ALLOC, POOL, \
-                 node_t<test_type, test_type> RQ_SNAPCOLLECTOR_OBJECT_TYPES>
+#define MEMMGMT_T                                                    \
+  record_manager<RECLAIM, ALLOC, POOL, node_t<test_type, test_type>, \
+                 vcas_obj_t<node_t<test_type, test_type>*>,          \
+                 vcas_obj_t<long long> RQ_SNAPCOLLECTOR_OBJECT_TYPES>
 #define DS_CONSTRUCTOR \
   new DS_DECLARATION(TOTAL_THREADS, KEY_MIN, KEY_MAX, NO_VALUE, glob.rngs)
 
@@ -636,10 +839,16 @@ using namespace vcas_skiplist_lock;
   ds->INSERT_FUNC(tid, key, VALUE) == ds->NO_VALUE
 #define DELETE_AND_CHECK_SUCCESS ds->ERASE_FUNC(tid, key) != ds->NO_VALUE
 #define FIND_AND_CHECK_SUCCESS ds->FIND_FUNC(tid, key)
+#define MULTIGET_AND_COUNT(keys, n, values) \
+  ds->multiGet(tid, keys, n, values)
 #define RQ_AND_CHECK_SUCCESS(rqcnt)                              \
   (rqcnt = ds->RQ_FUNC(tid, key, key + RQSIZE - 1, rqResultKeys, \
                        (VALUE_TYPE *)rqResultValues))
 #define RQ_GARBAGE(rqcnt) rqResultKeys[0] + rqResultKeys[rqcnt - 1]
+#define RQ_VISIT_AND_COUNT(visitor) \
+  ds->rangeQueryVisit(tid, key, key + RQSIZE - 1, visitor)
+#define RQ_AGGREGATE_AND_COUNT(aggregate) \
+  ds->rangeQueryVisit(tid, key, key + RQSIZE - 1, aggregate)
 #define INIT_THREAD(tid) ds->initThread(tid)
 #define DEINIT_THREAD(tid) ds->deinitThread(tid);
 #define INIT_ALL
@@ -660,18 +869,23 @@ using namespace vcas_skiplist_lock;
 using namespace vcas_citrus;
 
 #define DS_DECLARATION citrustree<test_type, test_type, MEMMGMT_T>
-#define MEMMGMT_T \
-  record_manager<RECLAIM, ALLOC, POOL, node_t<test_type, test_type>>
+#define MEMMGMT_T                                                    \
+  record_manager<RECLAIM, ALLOC, POOL, node_t<test_type, test_type>, \
+                 vcas_obj_t<node_t<test_type, test_type>*>>
 #define DS_CONSTRUCTOR new DS_DECLARATION(MAXKEY, NO_VALUE, TOTAL_THREADS)
 
 #define INSERT_AND_CHECK_SUCCESS \
   ds->INSERT_FUNC(tid, key, VALUE) == ds->NO_VALUE
 #define DELETE_AND_CHECK_SUCCESS ds->ERASE_FUNC(tid, key).second
 #define FIND_AND_CHECK_SUCCESS ds->FIND_FUNC(tid, key)
+#define MULTIGET_AND_COUNT(keys, n, values) \
+  ds->multiGet(tid, keys, n, values)
 #define RQ_AND_CHECK_SUCCESS(rqcnt)                             \
   rqcnt = ds->RQ_FUNC(tid, key, key + RQSIZE - 1, rqResultKeys, \
                       (VALUE_TYPE *)rqResultValues)
 #define RQ_GARBAGE(rqcnt) rqResultKeys[0] + rqResultKeys[rqcnt - 1]
+#define RQ_AGGREGATE_AND_COUNT(aggregate) \
+  ds->rangeQueryAggregate(tid, key, key + RQSIZE - 1, aggregate)
 #define INIT_THREAD(tid) \
   ds->initThread(tid);   \
   urcu::registerThread(tid);
@@ -26,6 +26,10 @@ int RQSIZE;
 int MAXKEY;
 int MILLIS_TO_RUN;
 bool PREFILL;
+bool PREFILL_BULK;
+int MULTIGET_SIZE;
+bool RQ_VISIT;
+bool RQ_AGGREGATE;
 int WORK_THREADS;
 int RQ_THREADS;
 int TOTAL_THREADS;
@@ -149,6 +153,33 @@ float ZIPF;
           C stat_output_item(PRINT_RAW, MIN, TOTAL) \
           C stat_output_item(PRINT_RAW, MAX, TOTAL) \
              }) \
+    handle_stat(LONG_LONG, timestamp_calls, 1, { \
+            stat_output_item(PRINT_RAW, SUM, TOTAL) \
+             }) \
+    handle_stat(LONG_LONG, timestamp_cas_skipped, 1, { \
+            stat_output_item(PRINT_RAW, SUM, TOTAL) \
+             }) \
+    handle_stat(LONG_LONG, timestamp_cas_lost, 1, { \
+            stat_output_item(PRINT_RAW, SUM, TOTAL) \
+             }) \
+    handle_stat(LONG_LONG, timestamp_backoff, 10000, { \
+            stat_output_item(PRINT_HISTOGRAM_LOG, NONE, FULL_DATA) \
+          C stat_output_item(PRINT_RAW, AVERAGE, TOTAL) \
+          C stat_output_item(PRINT_RAW, MAX, TOTAL) \
+             }) \
+    handle_stat(LONG_LONG, htm_commits, 1, { \
+            stat_output_item(PRINT_RAW, SUM, TOTAL) \
+             }) \
+    /* indexed by htm_abort_cause_t in rq_htm_rwlock.h */ \
+    handle_stat(LONG_LONG, htm_aborts, 5, { \
+            stat_output_item(PRINT_RAW, SUM, BY_INDEX) \
+             }) \
+    handle_stat(LONG_LONG, htm_fallbacks, 1, { \
+            stat_output_item(PRINT_RAW, SUM, TOTAL) \
+             }) \
+    handle_stat(LONG_LONG, htm_disabled, 1, { \
+            stat_output_item(PRINT_RAW, SUM, TOTAL) \
+             }) \
     handle_stat(LONG_LONG, bundle_traversals, 10000, { \
             stat_output_item(PRINT_HISTOGRAM_LOG, NONE, FULL_DATA) \
           /*C stat_output_item(PRINT_RAW, NONE, FULL_DATA)*/ \
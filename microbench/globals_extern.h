@@ -56,6 +56,10 @@ extern int RQSIZE;
 extern int MAXKEY;
 extern int MILLIS_TO_RUN;
 extern bool PREFILL;
+extern bool PREFILL_BULK;
+extern int MULTIGET_SIZE;
+extern bool RQ_VISIT;
+extern bool RQ_AGGREGATE;
 extern int WORK_THREADS;
 extern int RQ_THREADS;
 extern int TOTAL_THREADS;
@@ -78,9 +82,17 @@ extern int TOTAL_THREADS;
  * Configure record manager: reclaimer, allocator and pool
  */
 
+#if defined RQ_LOCKFREE || defined RQ_LOCKFREE_HW || defined RQ_RWLOCK || defined RQ_HTM_RWLOCK
+// EBR-based range queries find the nodes deleted during their traversal in the
+// reclaimer's limbo bags. reclaimer_none keeps none, and these range queries
+// would then miss keys, so they always use debra (as the macrobench does).
+#pragma message "Using reclaimer debra for EBR-based range queries"
+#define RECLAIM reclaimer_debra<test_type>
+#else
 #pragma message "Using reclaimer none vs debra"
 #define RECLAIM reclaimer_none<test_type>
 //#define RECLAIM reclaimer_debra<test_type>
+#endif
 #define ALLOC allocator_new_segregated<test_type>
 #define POOL pool_none<test_type>
 
@@ -17,11 +17,8 @@ typedef long long __syscall_slong_t;
 
 typedef long long test_type;
 
-// TODO: use system clock (chrono::) to precisely calibrate CPU_FREQ_GHZ in a
-// setup program (rather than having the user enter a specific GHZ number);
-// then, get rid of chrono:: usage.
-
 #include <pthread.h>
+#include <algorithm>
 #include <atomic>
 #include <cassert>
 #include <chrono>
@@ -34,7 +31,9 @@ typedef long long test_type;
 #include "papi_util_impl.h"
 #include "plaf.h"
 #include "random.h"
+#include "rq_aggregate.h"
 #include "rq_debugging.h"
+#include "timestamp_provider.h"
 #include "urcu_impl.h"
 #ifdef USE_DEBUGCOUNTERS
 #include "debugcounters.h"
@@ -108,6 +107,59 @@ const long long PREFILL_INTERVAL_MILLIS = 100;
 #define RQS_BETWEEN_TIME_CHECKS 10
 #endif
 
+// Data structures with a batched lookup (multiGet) define MULTIGET_AND_COUNT
+// in data_structures.h; -mget is rejected for the others.
+#ifdef MULTIGET_AND_COUNT
+#define MULTIGET_SUPPORTED true
+#else
+#define MULTIGET_SUPPORTED false
+#define MULTIGET_AND_COUNT(keys, n, values) 0
+#endif
+
+// Data structures with a streaming range query (rangeQueryVisit, see
+// rq/rq_cursor.h) define RQ_VISIT_AND_COUNT; -rqvisit is rejected for the
+// others.
+#ifdef RQ_VISIT_AND_COUNT
+#define RQ_VISIT_SUPPORTED true
+#else
+#define RQ_VISIT_SUPPORTED false
+#define RQ_VISIT_AND_COUNT(visitor) 0
+#endif
+
+// Data structures with an aggregate range query (rangeQueryAggregate, or
+// rangeQueryVisit with an RQAggregate as the visitor, see rq/rq_aggregate.h)
+// define RQ_AGGREGATE_AND_COUNT; -rqagg is rejected for the others.
+#ifdef RQ_AGGREGATE_AND_COUNT
+#define RQ_AGGREGATE_SUPPORTED true
+#else
+#define RQ_AGGREGATE_SUPPORTED false
+#define RQ_AGGREGATE_AND_COUNT(aggregate) 0
+#endif
+
+#ifndef RQ_CHECKS
+#define RQ_CHECKS 10000
+#endif
+
+// Visitor for -rqvisit. It copies the keys into the same arrays as
+// rangeQuery, and ends the range query once it has at least limit keys.
+struct rq_visit_copy_t {
+  test_type *keys;
+  VALUE_TYPE *values;
+  int limit;
+  int cnt;
+
+  rq_visit_copy_t(test_type *keys, VALUE_TYPE *values, int limit)
+      : keys(keys), values(values), limit(limit), cnt(0) {}
+
+  inline bool operator()(const test_type *batchKeys,
+                         const VALUE_TYPE *batchValues, const int n) {
+    memcpy(keys + cnt, batchKeys, n * sizeof(test_type));
+    memcpy(values + cnt, batchValues, n * sizeof(VALUE_TYPE));
+    cnt += n;
+    return cnt < limit;
+  }
+};
+
 #ifdef USE_DEBUGCOUNTERS
 #define GET_COUNTERS ds->debugGetCounters()
 #define CLEAR_COUNTERS ds->clearCounters();
@@ -196,7 +248,210 @@ void *thread_prefill(void *_id) {
   pthread_exit(NULL);
 }
 
+// Bulk prefilling (-pbulk) inserts exactly the expected number of distinct
+// keys, once each, instead of running random updates until the size is close
+// to the expected size. The keys are inserted in the pre-order of the balanced
+// binary search tree over them (each median before the keys on either side of
+// it), so unbalanced trees end up perfectly balanced. Every thread inserts its
+// own subtrees, below a "spine" of the top medians that thread 0 inserts first.
+// Lists define BULK_PREFILL_DESCENDING instead: thread 0 inserts all keys in
+// decreasing order, so that every insert stops next to the head. Since the keys
+// go through the data structure's insert, the result is correctly timestamped
+// for every range query technique.
+struct bulk_prefill_t {
+  int *keys;          // in insertion order
+  int numSpineKeys;   // keys[0, numSpineKeys) are inserted by thread 0 first
+  int numBlocks;      // then block b is keys[blockStart[b], blockStart[b+1])
+  int *blockStart;
+  volatile bool spineDone;
+};
+bulk_prefill_t bulk;
+
+// appends the keys of sorted[lo, hi) to bulk.keys in the pre-order of the
+// balanced binary search tree over them
+static void bulk_prefill_preorder(const int *sorted, const int lo, const int hi,
+                                  int *numKeys) {
+  if (lo >= hi) return;
+  const int mid = lo + (hi - lo) / 2;
+  bulk.keys[(*numKeys)++] = sorted[mid];
+  bulk_prefill_preorder(sorted, lo, mid, numKeys);
+  bulk_prefill_preorder(sorted, mid + 1, hi, numKeys);
+}
+
+// appends the medians of the top `levels` levels of that tree to bulk.keys (in
+// pre-order), and saves the ranges of the subtrees below them
+static void bulk_prefill_spine(const int *sorted, const int lo, const int hi,
+                               const int levels, int *numKeys, int *blockLo,
+                               int *blockHi) {
+  if (levels == 0) {
+    blockLo[bulk.numBlocks] = lo;
+    blockHi[bulk.numBlocks] = hi;
+    ++bulk.numBlocks;
+    return;
+  }
+  if (lo >= hi) return;
+  const int mid = lo + (hi - lo) / 2;
+  bulk.keys[(*numKeys)++] = sorted[mid];
+  bulk_prefill_spine(sorted, lo, mid, levels - 1, numKeys, blockLo, blockHi);
+  bulk_prefill_spine(sorted, mid + 1, hi, levels - 1, numKeys, blockLo,
+                     blockHi);
+}
+
+static void bulk_prefill_insert(DS_DECLARATION *ds, const int tid,
+                                const int start, const int end) {
+  for (int i = start; i < end; ++i) {
+    int key = bulk.keys[i];
+    if (INSERT_AND_CHECK_SUCCESS) {
+      GSTATS_ADD(tid, key_checksum, key);
+      GSTATS_ADD(tid, prefill_size, 1);
+#ifdef USE_DEBUGCOUNTERS
+      glob.keysum->add(tid, key);
+      glob.prefillSize->add(tid, 1);
+      GET_COUNTERS->insertSuccess->inc(tid);
+    } else {
+      GET_COUNTERS->insertFail->inc(tid);
+#endif
+    }
+    GSTATS_ADD(tid, num_updates, 1);
+    GSTATS_ADD(tid, num_operations, 1);
+  }
+}
+
+void *thread_prefill_bulk(void *_id) {
+  int tid = *((int *)_id);
+  binding_bindThread(tid, LOGICAL_PROCESSORS);
+  DS_DECLARATION *ds = (DS_DECLARATION *)glob.__ds;
+
+  INIT_THREAD(tid);
+  glob.running.fetch_add(1);
+  if (tid == 0) {
+    bulk_prefill_insert(ds, tid, 0, bulk.numSpineKeys);
+    __sync_synchronize();
+    bulk.spineDone = true;
+  }
+  while (!bulk.spineDone) {
+    // wait for thread 0 to insert the spine
+  }
+  for (int b = tid; b < bulk.numBlocks; b += TOTAL_THREADS) {
+    bulk_prefill_insert(ds, tid, bulk.blockStart[b], bulk.blockStart[b + 1]);
+  }
+
+  glob.running.fetch_add(-1);
+  while (glob.running.load()) {
+    // wait
+  }
+
+  DEINIT_THREAD(tid);
+  pthread_exit(NULL);
+}
+
+void prefill_bulk(DS_DECLARATION *ds) {
+  chrono::time_point<chrono::high_resolution_clock> startTime =
+      chrono::high_resolution_clock::now();
+  const double expectedFullness =
+      (INS + DEL ? INS / (double)(INS + DEL)
+                 : 0.5);  // percent full in expectation
+  const int expectedSize = (int)(MAXKEY * expectedFullness);
+  INIT_ALL;
+
+  // choose expectedSize keys uniformly from [0, MAXKEY), in increasing order
+  // (selection sampling)
+  int *sorted = new int[expectedSize];
+  Random rng(rand());
+  int numSorted = 0;
+  for (int k = 0; k < MAXKEY && numSorted < expectedSize; ++k) {
+    if (rng.nextNatural(MAXKEY - k) < expectedSize - numSorted) {
+      sorted[numSorted++] = k;
+    }
+  }
+
+#ifdef BULK_PREFILL_DESCENDING
+  bulk.keys = new int[numSorted];
+  bulk.blockStart = new int[1];
+  for (int i = 0; i < numSorted; ++i) bulk.keys[i] = sorted[numSorted - 1 - i];
+  bulk.numSpineKeys = numSorted;
+  bulk.numBlocks = 0;
+  bulk.blockStart[0] = numSorted;
+  bulk.spineDone = false;
+  int numKeys = numSorted;
+  delete[] sorted;
+#else
+  // enough spine levels for at least one subtree per thread
+  int levels = 0;
+  while ((1 << levels) < TOTAL_THREADS) ++levels;
+  int *blockLo = new int[1 << levels];
+  int *blockHi = new int[1 << levels];
+  bulk.keys = new int[numSorted];
+  bulk.blockStart = new int[(1 << levels) + 1];
+  bulk.numBlocks = 0;
+  bulk.spineDone = false;
+  int numKeys = 0;
+  bulk_prefill_spine(sorted, 0, numSorted, levels, &numKeys, blockLo, blockHi);
+  bulk.numSpineKeys = numKeys;
+  for (int b = 0; b < bulk.numBlocks; ++b) {
+    bulk.blockStart[b] = numKeys;
+    bulk_prefill_preorder(sorted, blockLo[b], blockHi[b], &numKeys);
+  }
+  bulk.blockStart[bulk.numBlocks] = numKeys;
+  assert(numKeys == numSorted);
+  delete[] blockLo;
+  delete[] blockHi;
+  delete[] sorted;
+#endif
+
+  pthread_t *threads = new pthread_t[TOTAL_THREADS];
+  int *ids = new int[TOTAL_THREADS];
+  for (int i = 0; i < TOTAL_THREADS; ++i) {
+    ids[i] = i;
+    if (pthread_create(&threads[i], NULL, thread_prefill_bulk, &ids[i])) {
+      cerr << "ERROR: could not create thread" << endl;
+      exit(-1);
+    }
+  }
+  for (int i = 0; i < TOTAL_THREADS; ++i) {
+    if (pthread_join(threads[i], NULL)) {
+      cerr << "ERROR: could not join prefilling thread" << endl;
+      exit(-1);
+    }
+  }
+  delete[] threads;
+  delete[] ids;
+  delete[] bulk.keys;
+  delete[] bulk.blockStart;
+
+  auto elapsed = chrono::duration_cast<chrono::milliseconds>(
+                     chrono::high_resolution_clock::now() - startTime)
+                     .count();
+
+#ifdef USE_DEBUGCOUNTERS
+  COUTATOMIC("finished bulk prefilling to size "
+             << glob.prefillSize->getTotal() << " for expected size "
+             << expectedSize << " keysum=" << glob.keysum->getTotal()
+             << " dskeysum=" << ds->debugKeySum() << " dssize=" << ds->getSize()
+             << ", inserting " << numKeys << " keys in " << (elapsed / 1000.)
+             << " seconds" << endl);
+  CLEAR_COUNTERS;
+#endif
+#ifdef USE_GSTATS
+  GSTATS_PRINT;
+  glob.prefillKeySum = GSTATS_GET_STAT_METRICS(key_checksum, TOTAL)[0].sum;
+  COUTATOMIC("finished bulk prefilling to size "
+             << GSTATS_OBJECT_NAME.get_sum<long long>(prefill_size)
+             << " for expected size " << expectedSize
+             << " keysum=" << glob.prefillKeySum
+             << " dskeysum=" << ds->debugKeySum() << " dssize=" << ds->getSize()
+             << ", inserting " << numKeys << " keys in " << (elapsed / 1000.)
+             << " seconds" << endl);
+  GSTATS_CLEAR_ALL;
+#endif
+}
+
 void prefill(DS_DECLARATION *ds) {
+  if (PREFILL_BULK) {
+    prefill_bulk(ds);
+    return;
+  }
+
   chrono::time_point<chrono::high_resolution_clock> prefillStartTime =
       chrono::high_resolution_clock::now();
 
@@ -374,6 +629,8 @@ void *thread_timed(void *_id) {
       new test_type[RQSIZE + RQ_DEBUGGING_MAX_KEYS_PER_NODE];
   VALUE_TYPE *rqResultValues =
       new VALUE_TYPE[RQSIZE + RQ_DEBUGGING_MAX_KEYS_PER_NODE];
+  test_type *mgetKeys = new test_type[MULTIGET_SIZE];
+  VALUE_TYPE *mgetValues = new VALUE_TYPE[MULTIGET_SIZE];
 
   INIT_THREAD(tid);
   papi_create_eventset(tid);
@@ -441,10 +698,18 @@ void *thread_timed(void *_id) {
 
       ++rq_cnt;
       int rqcnt;
+      rq_visit_copy_t visitor(rqResultKeys, rqResultValues, RQSIZE);
+      RQAggregate<test_type> aggregate;
       GSTATS_TIMER_RESET(tid, timer_latency);
-      if (RQ_AND_CHECK_SUCCESS(rqcnt)) {  // prevent rqResultKeys and count from
-                                          // being optimized out
-        garbage += RQ_GARBAGE(rqcnt);
+      if (RQ_AGGREGATE) {
+        rqcnt = RQ_AGGREGATE_AND_COUNT(aggregate);
+      } else if (RQ_VISIT) {
+        rqcnt = RQ_VISIT_AND_COUNT(visitor);
+      } else {
+        RQ_AND_CHECK_SUCCESS(rqcnt);
+      }
+      if (rqcnt) {  // prevent the results and count from being optimized out
+        garbage += RQ_AGGREGATE ? aggregate.sum : RQ_GARBAGE(rqcnt);
 #ifdef USE_DEBUGCOUNTERS
         GET_COUNTERS->rqSuccess->inc(tid);
       } else {
@@ -455,8 +720,24 @@ void *thread_timed(void *_id) {
       GSTATS_ADD(tid, num_rq, 1);
       GSTATS_ADD_IX(tid, length_rqs, rqcnt, GSTATS_GET(tid, num_rq));
     } else {
+      if (MULTIGET_SIZE > 1) {
+        // one batch of MULTIGET_SIZE searches, counted as that many searches
+        mgetKeys[0] = key;
+        for (int i = 1; i < MULTIGET_SIZE; ++i) {
+          mgetKeys[i] =
+              isnan(ZIPF) ? rng->nextNatural(MAXKEY) : rng->nextZipf(MAXKEY);
+        }
+      }
       GSTATS_TIMER_RESET(tid, timer_latency);
-      if (FIND_AND_CHECK_SUCCESS) {
+      if (MULTIGET_SIZE > 1) {
+        const int found =
+            MULTIGET_AND_COUNT(mgetKeys, MULTIGET_SIZE, mgetValues);
+        garbage += found;
+#ifdef USE_DEBUGCOUNTERS
+        GET_COUNTERS->findSuccess->add(tid, found);
+        GET_COUNTERS->findFail->add(tid, MULTIGET_SIZE - found);
+#endif
+      } else if (FIND_AND_CHECK_SUCCESS) {
 #ifdef USE_DEBUGCOUNTERS
         GET_COUNTERS->findSuccess->inc(tid);
       } else {
@@ -464,7 +745,7 @@ void *thread_timed(void *_id) {
 #endif
       }
       GSTATS_TIMER_APPEND_ELAPSED(tid, timer_latency, latency_searches);
-      GSTATS_ADD(tid, num_searches, 1);
+      GSTATS_ADD(tid, num_searches, MULTIGET_SIZE);
     }
     GSTATS_ADD(tid, num_operations, 1);
   }
@@ -476,6 +757,8 @@ void *thread_timed(void *_id) {
   DEINIT_THREAD(tid);
   delete[] rqResultKeys;
   delete[] rqResultValues;
+  delete[] mgetKeys;
+  delete[] mgetValues;
   glob.__garbage += garbage;
   pthread_exit(NULL);
 }
@@ -558,6 +841,67 @@ void *thread_rq(void *_id) {
   pthread_exit(NULL);
 }
 
+// -rqvisit and -rqagg: once the timed run is over and the data structure no
+// longer changes, compares the range query variant that was used with
+// rangeQuery on RQ_CHECKS random ranges. For -rqvisit, every other visitor ends
+// the range query early, after a random number of keys, and must then have
+// received a prefix of the range (in whole batches).
+void check_rq(DS_DECLARATION *ds) {
+  const int tid = 0;
+  Random *rng = &glob.rngs[0];
+  test_type *rqResultKeys =
+      new test_type[RQSIZE + RQ_DEBUGGING_MAX_KEYS_PER_NODE];
+  VALUE_TYPE *rqResultValues =
+      new VALUE_TYPE[RQSIZE + RQ_DEBUGGING_MAX_KEYS_PER_NODE];
+  test_type *visitKeys = new test_type[RQSIZE + RQ_DEBUGGING_MAX_KEYS_PER_NODE];
+  VALUE_TYPE *visitValues =
+      new VALUE_TYPE[RQSIZE + RQ_DEBUGGING_MAX_KEYS_PER_NODE];
+
+  INIT_THREAD(tid);
+  for (int i = 0; i < RQ_CHECKS; ++i) {
+    int key = rng->nextNatural() % max(1, MAXKEY - RQSIZE);
+    int rqcnt;
+    RQ_AND_CHECK_SUCCESS(rqcnt);
+    sort(rqResultKeys, rqResultKeys + rqcnt);
+    bool ok;
+    int cnt;
+    int limit = RQSIZE;
+    if (RQ_AGGREGATE) {
+      RQAggregate<test_type> expected;
+      for (int j = 0; j < rqcnt; ++j) expected.add(rqResultKeys[j]);
+      RQAggregate<test_type> aggregate;
+      cnt = RQ_AGGREGATE_AND_COUNT(aggregate);
+      ok = cnt == rqcnt && aggregate.count == expected.count &&
+           aggregate.sum == expected.sum &&
+           (rqcnt == 0 ||
+            (aggregate.min == expected.min && aggregate.max == expected.max));
+    } else {
+      if (i % 2) limit = 1 + rng->nextNatural(max(1, RQSIZE));
+      rq_visit_copy_t visitor(visitKeys, visitValues, limit);
+      cnt = RQ_VISIT_AND_COUNT(visitor);
+      ok = cnt == visitor.cnt && cnt <= rqcnt && cnt >= min(limit, rqcnt) &&
+           is_sorted(visitKeys, visitKeys + cnt);
+      for (int j = 0; ok && j < cnt; ++j) {
+        ok = (visitKeys[j] == rqResultKeys[j]);
+      }
+    }
+    if (!ok) {
+      cout << "RQ check FAILURE: range [" << key << ", " << (key + RQSIZE - 1)
+           << "] limit=" << limit << " rangeQuery=" << rqcnt << " keys "
+           << (RQ_AGGREGATE ? "rangeQueryAggregate=" : "rangeQueryVisit=")
+           << cnt << " keys" << endl;
+      exit(-1);
+    }
+  }
+  DEINIT_THREAD(tid);
+  cout << "RQ check OK: " << RQ_CHECKS << " range queries" << endl;
+
+  delete[] rqResultKeys;
+  delete[] rqResultValues;
+  delete[] visitKeys;
+  delete[] visitValues;
+}
+
 void trial() {
   INIT_ALL;
   papi_init_program(TOTAL_THREADS);
@@ -724,6 +1068,7 @@ void trial() {
              << "s" << endl);
 
   papi_deinit_program();
+  if (RQ_VISIT || RQ_AGGREGATE) check_rq(ds);
   DEINIT_ALL;
 
   for (int i = 0; i < TOTAL_THREADS; ++i) {
@@ -888,6 +1233,10 @@ int main(int argc, char **argv) {
   // setup default args
   PREFILL = false;  // must be false, or else there's no way to specify no
                     // prefilling on the command line...
+  PREFILL_BULK = false;
+  MULTIGET_SIZE = 1;
+  RQ_VISIT = false;
+  RQ_AGGREGATE = false;
   MILLIS_TO_RUN = 1000;
   RQ_THREADS = 0;
   WORK_THREADS = 4;
@@ -900,7 +1249,7 @@ int main(int argc, char **argv) {
 
   // read command line args
   // example args: -i 25 -d 25 -k 10000 -rq 0 -rqsize 1000 -p -t 1000 -nrq 0
-  // -nwork 8
+  // -nwork 8 -ts rdtscp
   for (int i = 1; i < argc; ++i) {
     if (strcmp(argv[i], "-i") == 0) {
       INS = atof(argv[++i]);
@@ -920,18 +1269,52 @@ int main(int argc, char **argv) {
       MILLIS_TO_RUN = atoi(argv[++i]);
     } else if (strcmp(argv[i], "-p") == 0) {
       PREFILL = true;
+    } else if (strcmp(argv[i], "-pbulk") == 0) {
+      PREFILL = true;
+      PREFILL_BULK = true;
+    } else if (strcmp(argv[i], "-mget") == 0) {
+      MULTIGET_SIZE = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-rqvisit") == 0) {
+      RQ_VISIT = true;
+    } else if (strcmp(argv[i], "-rqagg") == 0) {
+      RQ_AGGREGATE = true;
     } else if (strcmp(argv[i], "-bind") ==
                0) {                    // e.g., "-bind 1,2,3,8-11,4-7,0"
       binding_parseCustom(argv[++i]);  // e.g., "1,2,3,8-11,4-7,0"
       cout << "parsed custom binding: " << argv[i] << endl;
     } else if (strcmp(argv[i], "-z") == 0) { 
       ZIPF = atof(argv[++i]); 
+    } else if (strcmp(argv[i], "-ts") == 0) {  // logical (or ts), rdtsc, rdtscp, rdtscp_skew
+      if (!timestamp_select(argv[++i])) {
+        cout << "bad timestamp provider " << argv[i] << endl;
+        exit(1);
+      }
     } else {
       cout << "bad argument " << argv[i] << endl;
       exit(1);
     }
   }
   TOTAL_THREADS = WORK_THREADS + RQ_THREADS;
+  if (MULTIGET_SIZE < 1) {
+    cout << "bad -mget " << MULTIGET_SIZE << endl;
+    exit(1);
+  }
+  if (MULTIGET_SIZE > 1 && !MULTIGET_SUPPORTED) {
+    cout << "-mget is not supported by this data structure" << endl;
+    exit(1);
+  }
+  if (RQ_VISIT && !RQ_VISIT_SUPPORTED) {
+    cout << "-rqvisit is not supported by this data structure" << endl;
+    exit(1);
+  }
+  if (RQ_AGGREGATE && !RQ_AGGREGATE_SUPPORTED) {
+    cout << "-rqagg is not supported by this data structure" << endl;
+    exit(1);
+  }
+  if (RQ_VISIT && RQ_AGGREGATE) {
+    cout << "-rqvisit and -rqagg cannot be combined" << endl;
+    exit(1);
+  }
 
   // print used args
   PRINTS(FIND_FUNC);
@@ -942,6 +1325,10 @@ int main(int argc, char **argv) {
   PRINTS(ALLOC);
   PRINTS(POOL);
   PRINTI(PREFILL);
+  PRINTI(PREFILL_BULK);
+  PRINTI(MULTIGET_SIZE);
+  PRINTI(RQ_VISIT);
+  PRINTI(RQ_AGGREGATE);
   PRINTI(MILLIS_TO_RUN);
   PRINTI(INS);
   PRINTI(DEL);
@@ -951,6 +1338,15 @@ int main(int argc, char **argv) {
   PRINTI(WORK_THREADS);
   PRINTI(RQ_THREADS);
   PRINTI(ZIPF);
+  cout << "TS_PROVIDER=" << timestamp_kind_name(timestamp_selected_kind())
+       << endl;
+  // calibrate the TSC before anything is timed (see tsc_calibration.h)
+  cout << "TSC_HZ=" << tsc_calibration().hz << endl;
+  cout << "TSC_INVARIANT=" << tsc_calibration().invariant << endl;
+  if (timestamp_selected_kind() == TIMESTAMP_RDTSCP_SKEW) {
+    cout << "TSC_SKEW_EPSILON=" << tsc_skew().epsilon << endl;
+    cout << "TSC_SKEW_WORST_CPU=" << tsc_skew().worstCpu << endl;
+  }
 
 // TODO: Find a way to keep strategy specific code out of main.
 #ifdef RQ_BUNDLE
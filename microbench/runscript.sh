@@ -81,7 +81,10 @@ while read u rq rqsize k nrq nwork ds alg ts; do
 
     fname="${currdir}/${alg}/step$cnt1.$machine.${ds}.${alg}.${ts}.k$k.u$u.rq$rq.rqsize$rqsize.nrq$nrq.nwork$nwork.trial$trial.out"
     # echo "FNAME=$fname"
-    cmd="${preloads} ./${machine}.${ds}.rq_${alg}.${ts}.out -i $u -d $u -k $k -rq $rq -rqsize $rqsize ${prefill_and_time} -nrq $nrq -nwork $nwork ${pinning_policy}"
+    # The timestamp is selected at runtime; only EBR-RQ has a separate binary for hardware timestamps.
+    exe="${ds}.rq_${alg}"
+    if [ "${alg}" == "lockfree" ] && [ "${ts}" != "" ] && [ "${ts}" != "ts" ]; then exe="${ds}.rq_lockfree_hw"; fi
+    cmd="${preloads} ./${machine}.${exe}.out ${ts:+-ts ${ts}} -i $u -d $u -k $k -rq $rq -rqsize $rqsize ${prefill_and_time} -nrq $nrq -nwork $nwork ${pinning_policy}"
     if [[ "${allocator}" != "" ]]; then
       echo "env LD_PRELOAD=${allocator} TREE_MALLOC=${allocator} $cmd" >$fname
       env LD_PRELOAD=${allocator} TREE_MALLOC=${allocator} $cmd >>$fname
@@ -12,6 +12,7 @@
 #include "globals.h"
 #include "allocator_interface.h"
 #include <cstdlib>
+#include <new>
 #include <cassert>
 #include <iostream>
 #include <vector>
@@ -84,7 +85,12 @@ class allocator_bump : public allocator_interface<T> {
                     }
                 }
             }
-            return bump_memory_next(tid);
+            return new (bump_memory_next(tid)) T; // deallocate() destroys it
+        }
+        // records that end in a variable-length array never need more than
+        // sizeof(T), so this allocator ignores size and gives them a whole T
+        T* allocate(const int tid, const size_t size) {
+            return allocate(tid);
         }
         void static deallocate(const int tid, T * const p) {
             // no op for this allocator; memory is freed only by the destructor.
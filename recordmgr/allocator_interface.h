@@ -30,6 +30,9 @@ public:
     
     // allocate space for one object of type T
     T* allocate(const int tid);
+    // allocate size bytes for one object of type T that ends in a
+    // variable-length array (see record_size in pool_interface.h)
+    T* allocate(const int tid, const size_t size);
     void deallocate(const int tid, T * const p);
     void deallocateAndClear(const int tid, blockbag<T> * const bag);
     void initThread(const int tid);
@@ -43,6 +43,11 @@ public:
         }
         return new T; //(T*) malloc(sizeof(T));
     }
+    // records that end in a variable-length array never need more than
+    // sizeof(T), so this allocator ignores size and gives them a whole T
+    T* allocate(const int tid, const size_t size) {
+        return allocate(tid);
+    }
     void deallocate(const int tid, T * const p) {
         // note: allocators perform the actual freeing/deleting, since
         // only they know how memory was allocated.
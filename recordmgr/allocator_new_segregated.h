@@ -11,6 +11,7 @@
 #include "plaf.h"
 #include "pool_interface.h"
 #include <cstdlib>
+#include <new>
 #include <cassert>
 #include <iostream>
 #include <dlfcn.h>
@@ -49,7 +50,14 @@ public:
 //                maxAllocatedBytes = currentAllocatedBytes;
 //            }
         }
-        return (T*) allocfn(sizeof(T));
+        // construct the object, since deallocate() destroys it
+        return new (allocfn(sizeof(T))) T;
+    }
+    // reserve size bytes for ONE object of type T that ends in a
+    // variable-length array. it is freed by deallocate like any other object.
+    T* allocate(const int tid, const size_t size) {
+        MEMORY_STATS this->debug->addAllocated(tid, 1);
+        return new (allocfn(size)) T;
     }
     void deallocate(const int tid, T * const p) {
         // note: allocators perform the actual freeing/deleting, since
@@ -9,6 +9,7 @@
 #define	BLOCKLIST_H
 
 #include <cassert>
+#include <climits>
 #include <iostream>
 #include "blockpool.h"
 #include "plaf.h"
@@ -27,6 +28,23 @@ class block;
 
 // BLOCK_SIZE must be a power of two, or else the bitwise math is invalid.
 #define BLOCK_SIZE (1<<8)
+
+// Blocks keep the range of the deletion timestamps (dtime fields) of the
+// objects pushed into them, for types that have one, so that range queries
+// can skip whole blocks of limbo bags (see rq_lockfree.h).
+// An object pushed before its dtime is set (0) makes the range unbounded.
+#define BLOCK_STAMP_NOT_SET 0
+
+    template <typename T, typename = void>
+    struct block_stamp {
+        static const bool tracked = false;
+        static inline long long get(T * const obj) { return BLOCK_STAMP_NOT_SET; }
+    };
+    template <typename T>
+    struct block_stamp<T, decltype((void) ((T *) 0)->dtime)> {
+        static const bool tracked = true;
+        static inline long long get(T * const obj) { return obj->dtime; }
+    };
     
     template <typename T>
     class block { // stack implemented as an array
@@ -34,12 +52,16 @@ class block;
             volatile char padding0[PREFETCH_SIZE_BYTES];
             T * data[BLOCK_SIZE];
             int size;
+            volatile long long minStamp;
+            volatile long long maxStamp;
             volatile char padding1[PREFETCH_SIZE_BYTES];
         public:
             block<T> *next;
             
             block(block<T> * const _next) : next(_next) {
                 size = 0;
+                minStamp = LLONG_MAX;
+                maxStamp = LLONG_MIN;
             }
             ~block() {
                 assert(size == 0);
@@ -56,6 +78,19 @@ class block;
                 assert(size < BLOCK_SIZE);
                 const int sz = size;
                 //assert(interruptible[((long) ((int *) pthread_getspecific(pthreadkey)))*PREFETCH_SIZE_WORDS] == false);
+                if (block_stamp<T>::tracked) {
+                    // widen the range before the object becomes visible,
+                    // so it covers every object a concurrent reader can see
+                    const long long stamp = block_stamp<T>::get(obj);
+                    if (stamp == BLOCK_STAMP_NOT_SET) {
+                        minStamp = LLONG_MIN;
+                        maxStamp = LLONG_MAX;
+                    } else {
+                        if (stamp < minStamp) minStamp = stamp;
+                        if (stamp > maxStamp) maxStamp = stamp;
+                    }
+                    SOFTWARE_BARRIER;
+                }
                 data[size] = obj;
                 SOFTWARE_BARRIER;
                 size = sz+1;
@@ -118,6 +153,13 @@ class block;
             int computeSize() {
                 return size;
             }
+            // every object in the block has a stamp in [getMinStamp(), getMaxStamp()]
+            long long getMinStamp() {
+                return minStamp;
+            }
+            long long getMaxStamp() {
+                return maxStamp;
+            }
             // this function is occasionally useful if, for instance,
             // you use a bump allocator, which hands out objects from
             // a huge slab of memory.
@@ -149,6 +191,11 @@ class block;
     public:
         block<T> *getCurr() const { return curr; }
         int getIndex() const { return ix; }
+        // moves to the first item of the next block
+        inline void skipBlock() {
+            ix = 0;
+            (*this)++;
+        }
         
         blockbag_iterator(block<T> * const _head, blockbag<T> * const _bag) 
                 : bag(_bag), head(_head) {
@@ -15,6 +15,25 @@
 #include "blockbag.h"
 using namespace std;
 
+// Records that end in a variable-length array (such as the forward pointers of
+// a skip-list node) are allocated with get(tid, size), and define
+//     size_t recordSize() const
+// which returns the number of bytes they need. Pools that recycle records keep
+// one free bag per size class for such types, so a record is never reused for
+// a larger request.
+#define RECORD_SIZE_CLASS_BYTES (sizeof(void *))
+
+    template <typename T, typename = void>
+    struct record_size {
+        static const bool variable = false;
+        static inline size_t get(T * const obj) { return sizeof(T); }
+    };
+    template <typename T>
+    struct record_size<T, decltype((void) ((T *) 0)->recordSize())> {
+        static const bool variable = true;
+        static inline size_t get(T * const obj) { return obj->recordSize(); }
+    };
+
 template <typename T = void, class Alloc = allocator_interface<T> >
 class pool_interface {
 public:
@@ -44,6 +63,7 @@ public:
      * and return a pointer to it. otherwise, return NULL.
      */
     inline T* get(const int tid);
+    inline T* get(const int tid, const size_t size);
     inline void add(const int tid, T* ptr);
     inline void addMoveFullBlocks(const int tid, blockbag<T> *bag);
     inline void addMoveAll(const int tid, blockbag<T> *bag);
@@ -38,6 +38,10 @@ public:
         MEMORY_STATS2 this->alloc->debug->addFromPool(tid, 1);
         return this->alloc->allocate(tid);
     }
+    inline T* get(const int tid, const size_t size) {
+        MEMORY_STATS2 this->alloc->debug->addFromPool(tid, 1);
+        return this->alloc->allocate(tid, size);
+    }
     inline void add(const int tid, T* ptr) {
         this->alloc->deallocate(tid, ptr);
     }
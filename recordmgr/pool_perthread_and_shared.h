@@ -16,6 +16,7 @@
 #include "pool_interface.h"
 #include "plaf.h"
 #include "globals.h"
+#include <type_traits>
 using namespace std;
 
 #define POOL_THRESHOLD_IN_BLOCKS 10
@@ -23,16 +24,27 @@ using namespace std;
 template <typename T = void, class Alloc = allocator_interface<T> >
 class pool_perthread_and_shared : public pool_interface<T, Alloc> {
 private:
-    lockfreeblockbag<T> *sharedBag;       // shared bag that we offload blocks on when we have too many in our freeBag
-    blockbag<T> **freeBag;                // freeBag[tid] = bag of objects of type T that are ready to be reused by the thread with id tid
+    // records of a type with a recordSize() (see pool_interface.h) are kept in
+    // one bag per size class: class c holds records of at least
+    // c*RECORD_SIZE_CLASS_BYTES bytes. other types have a single class.
+    static const int NUM_SIZE_CLASSES = record_size<T>::variable ? (sizeof(T)+RECORD_SIZE_CLASS_BYTES-1)/RECORD_SIZE_CLASS_BYTES + 1 : 1;
+    lockfreeblockbag<T> **sharedBag;      // sharedBag[c] = shared bag that we offload blocks of size class c on when we have too many in our freeBag
+    blockbag<T> **freeBag;                // freeBag[tid*NUM_SIZE_CLASSES+c] = bag of objects of type T and size class c that are ready to be reused by the thread with id tid
+
+    inline static int sizeClass(const size_t size) {
+        return record_size<T>::variable ? (size+RECORD_SIZE_CLASS_BYTES-1)/RECORD_SIZE_CLASS_BYTES : 0;
+    }
+    inline blockbag<T> * getFreeBag(const int tid, const int c) {
+        return freeBag[tid*NUM_SIZE_CLASSES+c];
+    }
 
     // note: only does something if freeBag contains at least two full blocks
-    inline bool tryGiveFreeObjects(const int tid) {
-        if (freeBag[tid]->getSizeInBlocks() >= POOL_THRESHOLD_IN_BLOCKS) {
-            block<T> *b = freeBag[tid]->removeFullBlock(); // returns NULL if freeBag has < 2 full blocks
+    inline bool tryGiveFreeObjects(const int tid, const int c) {
+        if (getFreeBag(tid, c)->getSizeInBlocks() >= POOL_THRESHOLD_IN_BLOCKS) {
+            block<T> *b = getFreeBag(tid, c)->removeFullBlock(); // returns NULL if freeBag has < 2 full blocks
             assert(b);
 //            if (b) {
-                sharedBag->addBlock(b);
+                sharedBag[c]->addBlock(b);
                 MEMORY_STATS this->debug->addGiven(tid, 1);
                 //DEBUG2 COUTATOMIC("  thread "<<this->tid<<" sharedBag("<<(sizeof(T)==sizeof(Node<long,long>)?"Node":"SCXRecord")<<") now contains "<<sharedBag->size()<<" blocks"<<endl);
 //            }
@@ -40,6 +52,21 @@ private:
         }
         return false;
     }
+    
+    // moves every object in bag to the free bag of its size class
+    inline void addAllBySizeClass(const int tid, blockbag<T> *bag) {
+        while (!bag->isEmpty()) {
+            add(tid, bag->remove());
+        }
+    }
+    
+    // only records with a recordSize() are allocated with a size
+    inline T* allocateSized(const int tid, const size_t size, true_type) {
+        return this->alloc->allocate(tid, size);
+    }
+    inline T* allocateSized(const int tid, const size_t size, false_type) {
+        return this->alloc->allocate(tid);
+    }
 //    
 //    inline void tryTakeFreeObjects(const int tid) {
 //        block<T> *b = sharedBag->getBlock();
@@ -69,10 +96,13 @@ public:
 //    }
     string getSizeString() {
         stringstream ss;
-        long long insharedbag = sharedBag->size();
+        long long insharedbag = 0;
+        for (int c=0;c<NUM_SIZE_CLASSES;++c) {
+            insharedbag += sharedBag[c]->size();
+        }
         long long infreebags = 0;
         for (int tid=0;tid<this->NUM_PROCESSES;++tid) {
-            infreebags += freeBag[tid]->computeSize();
+            infreebags += computeSize(tid);
         }
         ss<<infreebags<<" in free bags and "<<insharedbag<<" in the shared bag";
         return ss.str();
@@ -84,32 +114,73 @@ public:
      * if not, then retrieve a new object from Alloc
      */
     inline T* get(const int tid) {
+        if (record_size<T>::variable) return get(tid, sizeof(T));
         MEMORY_STATS2 this->alloc->debug->addFromPool(tid, 1);
-        return freeBag[tid]->template remove<Alloc>(tid, sharedBag, this->alloc);
+        return freeBag[tid]->template remove<Alloc>(tid, sharedBag[0], this->alloc);
+    }
+    /**
+     * as above, for records with a recordSize(), but the object has room for
+     * at least size bytes. new objects are allocated one at a time, with the
+     * size rounded up to its size class.
+     */
+    inline T* get(const int tid, const size_t size) {
+        if (!record_size<T>::variable) return get(tid);
+        MEMORY_STATS2 this->alloc->debug->addFromPool(tid, 1);
+        const int c = sizeClass(size);
+        blockbag<T> * const bag = getFreeBag(tid, c);
+        if (bag->isEmpty()) {
+            block<T> *b = sharedBag[c]->getBlock();
+            if (b == NULL) {
+                return allocateSized(tid, c*RECORD_SIZE_CLASS_BYTES, integral_constant<bool, record_size<T>::variable>());
+            }
+            bag->addFullBlock(b);
+            MEMORY_STATS this->debug->addTaken(tid, 1);
+        }
+        return bag->remove();
     }
     inline void add(const int tid, T* ptr) {
         MEMORY_STATS2 this->debug->addToPool(tid, 1);
-        freeBag[tid]->add(tid, ptr, sharedBag, POOL_THRESHOLD_IN_BLOCKS, this->alloc);
+        const int c = sizeClass(record_size<T>::get(ptr));
+        assert(c < NUM_SIZE_CLASSES);
+        getFreeBag(tid, c)->add(tid, ptr, sharedBag[c], POOL_THRESHOLD_IN_BLOCKS, this->alloc);
     }
     inline void addMoveFullBlocks(const int tid, blockbag<T> *bag, block<T> * const predecessor) {
+        if (record_size<T>::variable) {
+            blockbag<T> moved (tid, this->blockpools[tid]);
+            moved.appendMoveFullBlocks(bag, predecessor);
+            addAllBySizeClass(tid, &moved);
+            return;
+        }
         // WARNING: THE FOLLOWING DEBUG COMPUTATION GETS THE WRONG NUMBER OF BLOCKS.
         MEMORY_STATS2 this->debug->addToPool(tid, (bag->getSizeInBlocks()-1)*BLOCK_SIZE);
         freeBag[tid]->appendMoveFullBlocks(bag, predecessor);
-        while (tryGiveFreeObjects(tid)) {}
+        while (tryGiveFreeObjects(tid, 0)) {}
     }
     inline void addMoveFullBlocks(const int tid, blockbag<T> *bag) {
+        if (record_size<T>::variable) {
+            addAllBySizeClass(tid, bag);
+            return;
+        }
         // WARNING: THE FOLLOWING DEBUG COMPUTATION GETS THE WRONG NUMBER OF BLOCKS.
         MEMORY_STATS2 this->debug->addToPool(tid, (bag->getSizeInBlocks()-1)*BLOCK_SIZE);
         freeBag[tid]->appendMoveFullBlocks(bag);
-        while (tryGiveFreeObjects(tid)) {}
+        while (tryGiveFreeObjects(tid, 0)) {}
     }
     inline void addMoveAll(const int tid, blockbag<T> *bag) {
+        if (record_size<T>::variable) {
+            addAllBySizeClass(tid, bag);
+            return;
+        }
         MEMORY_STATS2 this->debug->addToPool(tid, bag->computeSize());
         freeBag[tid]->appendMoveAll(bag);
-        while (tryGiveFreeObjects(tid)) {}
+        while (tryGiveFreeObjects(tid, 0)) {}
     }
     inline int computeSize(const int tid) {
-        return freeBag[tid]->computeSize();
+        int result = 0;
+        for (int c=0;c<NUM_SIZE_CLASSES;++c) {
+            result += getFreeBag(tid, c)->computeSize();
+        }
+        return result;
     }
     
     void debugPrintStatus(const int tid) {
@@ -121,31 +192,41 @@ public:
     pool_perthread_and_shared(const int numProcesses, Alloc * const _alloc, debugInfo * const _debug)
             : pool_interface<T, Alloc>(numProcesses, _alloc, _debug) {
         VERBOSE DEBUG COUTATOMIC("constructor pool_perthread_and_shared"<<endl);
-        freeBag = new blockbag<T>*[numProcesses];
+        freeBag = new blockbag<T>*[numProcesses*NUM_SIZE_CLASSES];
         for (int tid=0;tid<numProcesses;++tid) {
-            freeBag[tid] = new blockbag<T>(tid, this->blockpools[tid]);
+            for (int c=0;c<NUM_SIZE_CLASSES;++c) {
+                freeBag[tid*NUM_SIZE_CLASSES+c] = new blockbag<T>(tid, this->blockpools[tid]);
+            }
+        }
+        sharedBag = new lockfreeblockbag<T>*[NUM_SIZE_CLASSES];
+        for (int c=0;c<NUM_SIZE_CLASSES;++c) {
+            sharedBag[c] = new lockfreeblockbag<T>();
         }
-        sharedBag = new lockfreeblockbag<T>();
     }
     ~pool_perthread_and_shared() {
         VERBOSE DEBUG COUTATOMIC("destructor pool_perthread_and_shared"<<endl);
-        // clean up shared bag
+        // clean up shared bags
         const int dummyTid = 0;
-        block<T> *fullBlock;
-        while ((fullBlock = sharedBag->getBlock()) != NULL) {
-            while (!fullBlock->isEmpty()) {
-                T * const ptr = fullBlock->pop();
-                this->alloc->deallocate(dummyTid, ptr);
+        for (int c=0;c<NUM_SIZE_CLASSES;++c) {
+            block<T> *fullBlock;
+            while ((fullBlock = sharedBag[c]->getBlock()) != NULL) {
+                while (!fullBlock->isEmpty()) {
+                    T * const ptr = fullBlock->pop();
+                    this->alloc->deallocate(dummyTid, ptr);
+                }
+                this->blockpools[dummyTid]->deallocateBlock(fullBlock);
             }
-            this->blockpools[dummyTid]->deallocateBlock(fullBlock);
+            delete sharedBag[c];
         }
+        delete[] sharedBag;
         // clean up free bags
         for (int tid=0;tid<this->NUM_PROCESSES;++tid) {
-            this->alloc->deallocateAndClear(tid, freeBag[tid]);
-            delete freeBag[tid];
+            for (int c=0;c<NUM_SIZE_CLASSES;++c) {
+                this->alloc->deallocateAndClear(tid, getFreeBag(tid, c));
+                delete getFreeBag(tid, c);
+            }
         }
         delete[] freeBag;
-        delete sharedBag;
     }
 };
 
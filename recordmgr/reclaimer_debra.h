@@ -69,6 +69,14 @@ protected:
     // for epoch based reclamation
     volatile long epoch;
     volatile char padding2[PREFETCH_SIZE_BYTES];
+    
+    // the reclaimer of the first record type rotates the epoch bags of all
+    // record types. it calls them through this pointer, so each pool is given
+    // records of its own type (size-classed pools look inside the records).
+    void (*rotateEpochBagsFn)(void * const reclaimer, const int tid);
+    static void rotateEpochBagsOf(void * const reclaimer, const int tid) {
+        ((reclaimer_debra<T, Pool> * const) reclaimer)->rotateEpochBags(tid);
+    }
     //long *index;                        
     
 public:
@@ -260,7 +268,7 @@ public:
             // reclaim any objects retired two epochs ago.
             threadData[tid].checked = 0;
             for (int i=0;i<numReclaimers;++i) {
-                ((reclaimer_debra<T, Pool> * const) reclaimers[i])->rotateEpochBags(tid);
+                ((reclaimer_debra<T, Pool> * const) reclaimers[i])->rotateEpochBagsFn(reclaimers[i], tid);
             }
             result = true;
         }
@@ -315,6 +323,7 @@ public:
             : reclaimer_interface<T, Pool>(numProcesses, _pool, _debug, _recoveryMgr) {
         VERBOSE cout<<"constructor reclaimer_debra helping="<<this->shouldHelp()<<endl;// scanThreshold="<<scanThreshold<<endl;
         epoch = 0;
+        rotateEpochBagsFn = rotateEpochBagsOf;
         for (int tid=0;tid<numProcesses;++tid) {
             threadData[tid].index = 0;
             threadData[tid].localvar_announcedEpoch = GET_WITH_QUIESCENT(0);
@@ -46,6 +46,13 @@ private:
     blockbag<T> **currentBag;           // pointer to current epoch bag for each process
     long *index;                        // index of currentBag in epochbags for each process
     // note: oldest bag is number (index+1)%NUMBER_OF_EPOCH_BAGS_CR
+    
+    // the reclaimer of the first record type rotates the epoch bags of all
+    // record types through this pointer (see reclaimer_debra.h)
+    void (*rotateEpochBagsFn)(void * const reclaimer, const int tid);
+    static void rotateEpochBagsOf(void * const reclaimer, const int tid) {
+        ((reclaimer_debraplus<T, Pool> * const) reclaimer)->rotateEpochBags(tid);
+    }
 
     // for hazard pointer component of this scheme;
     // each thread has a single hazard pointer that it uses to prevent
@@ -266,7 +273,7 @@ public:
             checked[tid*PREFETCH_SIZE_WORDS] = 0;
             //rotateEpochBags(tid);
             for (int i=0;i<numReclaimers;++i) {
-                ((reclaimer_debraplus<T, Pool> * const) reclaimers[i])->rotateEpochBags(tid);
+                ((reclaimer_debraplus<T, Pool> * const) reclaimers[i])->rotateEpochBagsFn(reclaimers[i], tid);
             }
             result = true;
         }
@@ -330,6 +337,7 @@ public:
     reclaimer_debraplus(const int numProcesses, Pool *_pool, debugInfo * const _debug, RecoveryMgr<void *> * const _recoveryMgr = NULL)
             : reclaimer_interface<T, Pool>(numProcesses, _pool, _debug, _recoveryMgr) {
         VERBOSE DEBUG COUTATOMIC("constructor reclaimer_debraplus helping="<<this->shouldHelp()<<endl);// scanThreshold="<<scanThreshold<<endl;
+        rotateEpochBagsFn = rotateEpochBagsOf;
         if (_recoveryMgr) COUTATOMIC("SIGRTMIN="<<SIGRTMIN<<" neutralizeSignal="<<this->recoveryMgr->neutralizeSignal<<endl);
         // set up signal set for neutralize signal
         if (sigemptyset(&neutralizeSignalSet)) {
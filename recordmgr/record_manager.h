@@ -262,6 +262,14 @@ public:
         return rmset->get((T *) NULL)->allocate(tid);
     }
     
+    // for records that end in a variable-length array and define recordSize()
+    // (see pool_interface.h): allocates a record with room for size bytes
+    template <typename T>
+    inline T * allocate(const int tid, const size_t size) {
+        assert(!Reclaim::supportsCrashRecovery() || isQuiescent(tid));
+        return rmset->get((T *) NULL)->allocate(tid, size);
+    }
+    
     // optional function which can be used if it is safe to call free()
     template <typename T>
     inline void deallocate(const int tid, T * const p) {
@@ -120,6 +120,9 @@ public:
     volatile char padding0[PREFETCH_SIZE_BYTES];
     const int NUM_PROCESSES;
     const int neutralizeSignal;
+    // the setjmp buffers and pthread key are process-wide, so only the first
+    // of several coexisting instances creates (and later frees) them
+    const bool ownsGlobals;
     volatile char padding2[PREFETCH_SIZE_BYTES];
     
     inline int getTidInefficient(const pthread_t me) {
@@ -193,9 +196,12 @@ public:
     }
     
     RecoveryMgr(const int numProcesses, const int _neutralizeSignal, MasterRecordMgr * const masterRecordMgr)
-            : NUM_PROCESSES(numProcesses) , neutralizeSignal(_neutralizeSignal){
-        setjmpbuffers = new sigjmp_buf[numProcesses];
-        pthread_key_create(&pthreadkey, NULL);
+            : NUM_PROCESSES(numProcesses) , neutralizeSignal(_neutralizeSignal)
+            , ownsGlobals(setjmpbuffers == NULL) {
+        if (ownsGlobals) {
+            setjmpbuffers = new sigjmp_buf[numProcesses];
+            pthread_key_create(&pthreadkey, NULL);
+        }
         
 #ifndef __CYGWIN__
         if (MasterRecordMgr::supportsCrashRecovery()) {
@@ -214,10 +220,15 @@ public:
         }
 #endif
         // set up shared pointer to this class instance for the signal handler
-        ___singleton = (void *) masterRecordMgr;
+        if (ownsGlobals || MasterRecordMgr::supportsCrashRecovery()) {
+            ___singleton = (void *) masterRecordMgr;
+        }
     }
     ~RecoveryMgr() {
-        delete[] setjmpbuffers;
+        if (ownsGlobals) {
+            delete[] setjmpbuffers;
+            setjmpbuffers = NULL;
+        }
     }
 };
 
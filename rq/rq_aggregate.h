@@ -0,0 +1,136 @@
+// Aggregate range queries.
+//
+// Many callers only need the number, sum, minimum or maximum of the keys in
+// [lo, hi]. An RQAggregate<K> collects these while the range query traverses
+// its snapshot, so no result arrays are filled and no second pass is made over
+// them. The (a,b)-trees (EBR-RQ lock-free, Bundling and vCAS versions) and the
+// bundled and vCAS Citrus trees provide
+//
+//   int rangeQueryAggregate(const int tid, const K& lo, const K& hi,
+//                           RQAggregate<K>& aggregate);
+//
+// on top of the traversal_try_add(tid, node, aggregate, lo, hi) overloads of
+// rq_bundle.h, rq_vcas.h and rq_lockfree.h (which use the same snapshot rules
+// as the array versions), and return the number of keys added. Data structures
+// with rangeQueryVisit (rq_cursor.h) can pass an RQAggregate as the visitor.
+//
+// rq_bundle.h and rq_vcas.h filter the keys of a node with rq_range_mask()
+// (rq_lockfree.h keeps the filter of its array version). For the (a,b)-trees,
+// whose 64-bit integer keys are ordered by std::less, it compares four keys per
+// instruction when compiled with AVX2 (-mavx2), which pays off for their fat
+// leaves. For other data structures it calls ds->isInRange for every key.
+//
+// The microbenchmark uses these for its range queries with -rqagg, and then
+// compares them with rangeQuery once the run is over.
+
+#ifndef RQ_AGGREGATE_H
+#define RQ_AGGREGATE_H
+
+#include <cassert>
+#include <functional>
+#include <stdint.h>
+#include <type_traits>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#include "rq_debugging.h"
+
+// Whether rq_range_mask may compare the keys of DS itself, with <, instead of
+// calling ds->isInRange. This holds for 64-bit integer keys of data structures
+// that order keys with std::less and filter them with nothing else, which they
+// declare with a public key_compare typedef (the (a,b)-trees). Others, such as
+// the BST and Citrus, whose isInRange also excludes NO_KEY, are never compared
+// directly.
+template <typename DS, typename K, typename = void>
+struct rq_range_mask_direct : std::false_type {};
+
+template <typename DS, typename K>
+struct rq_range_mask_direct<
+    DS, K,
+    typename std::enable_if<
+        std::is_same<typename DS::key_compare, std::less<K>>::value>::type>
+    : std::integral_constant<bool, std::is_integral<K>::value &&
+                                       sizeof(K) == 8> {};
+
+// Returns a bitmask with bit i set iff keys[i] is in [lo, hi], for n <= 64.
+template <typename DS, typename K>
+inline typename std::enable_if<!rq_range_mask_direct<DS, K>::value,
+                               uint64_t>::type
+rq_range_mask(DS* const ds, const K* const keys, const int n, const K& lo,
+              const K& hi) {
+  assert(n <= 64);
+  uint64_t mask = 0;
+  for (int i = 0; i < n; ++i) {
+    if (ds->isInRange(keys[i], lo, hi)) mask |= (1ULL << i);
+  }
+  return mask;
+}
+
+// Compiled with AVX2 (-mavx2), this compares four keys per instruction.
+template <typename DS, typename K>
+inline typename std::enable_if<rq_range_mask_direct<DS, K>::value,
+                               uint64_t>::type
+rq_range_mask(DS* const ds, const K* const keys, const int n, const K& lo,
+              const K& hi) {
+  assert(n <= 64);
+  uint64_t mask = 0;
+  int i = 0;
+#ifdef __AVX2__
+  // AVX2 only compares signed integers, so unsigned keys have their sign bit
+  // flipped first, which preserves their order.
+  const __m256i bias = _mm256_set1_epi64x(
+      std::is_signed<K>::value ? 0 : (long long)(1ULL << 63));
+  const __m256i vlo = _mm256_xor_si256(_mm256_set1_epi64x((long long)lo), bias);
+  const __m256i vhi = _mm256_xor_si256(_mm256_set1_epi64x((long long)hi), bias);
+  for (; i + 4 <= n; i += 4) {
+    const __m256i v = _mm256_xor_si256(
+        _mm256_loadu_si256((const __m256i*)(keys + i)), bias);
+    const __m256i out = _mm256_or_si256(_mm256_cmpgt_epi64(vlo, v),
+                                        _mm256_cmpgt_epi64(v, vhi));
+    const uint64_t outMask =
+        (uint64_t)_mm256_movemask_pd(_mm256_castsi256_pd(out));
+    mask |= ((~outMask) & 0xf) << i;
+  }
+#endif
+  for (; i < n; ++i) {
+    if (!(keys[i] < lo) && !(hi < keys[i])) mask |= (1ULL << i);
+  }
+  return mask;
+}
+
+template <typename K>
+class RQAggregate {
+ public:
+  long long count;
+  K sum;
+  K min;  // valid only if count > 0
+  K max;  // valid only if count > 0
+
+  RQAggregate() : count(0), sum(0), min(), max() {}
+
+  inline void add(const K& key) {
+    if (count == 0 || key < min) min = key;
+    if (count == 0 || max < key) max = key;
+    sum += key;
+    ++count;
+  }
+
+  // Adds keys[i] for every bit i set in mask.
+  inline void addMasked(const K* const keys, uint64_t mask) {
+    while (mask) {
+      add(keys[__builtin_ctzll(mask)]);
+      mask &= mask - 1;
+    }
+  }
+
+  // Lets an RQAggregate be the visitor of rangeQueryVisit.
+  template <typename V>
+  inline bool operator()(const K* const keys, const V* const values,
+                         const int n) {
+    for (int i = 0; i < n; ++i) add(keys[i]);
+    return true;
+  }
+};
+
+#endif /* RQ_AGGREGATE_H */
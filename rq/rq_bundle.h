@@ -17,8 +17,11 @@
 #endif
 
 #if defined BUNDLE_CIRCULAR_BUNDLE
+#define BUNDLE_TYPE_DECL CircularBundle
 #include "circular_bundle.h"
-#error Not implemented
+// Replaced buffers are the only records, and updates to locked nodes never
+// leave the quiescent state, so reads must advance the entry manager's epoch.
+#define BUNDLE_READ_ONLY false
 #elif defined BUNDLE_LINKED_BUNDLE
 #define BUNDLE_TYPE_DECL LinkedBundle
 #include "linked_bundle.h"
@@ -29,12 +32,22 @@
 #else
 #error NO BUNDLE TYPE DEFINED
 #endif
+#ifndef BUNDLE_READ_ONLY
+#define BUNDLE_READ_ONLY true
+#endif
 
+// The clock is chosen at startup (-ts); TS_LOGICAL_PROVIDER is the software
+// timestamp used when the logical clock is selected (LeasedTimestamp avoids a
+// shared write per update; range queries close its epoch in start_traversal()).
+#if not defined(TS_LOGICAL_PROVIDER)
+#define TS_LOGICAL_PROVIDER BundlingTimestamp
+#endif
 #if not defined(TS_PROVIDER)
-#define TS_PROVIDER BundlingTimestamp
+#define TS_PROVIDER SelectableTimestamp<TS_LOGICAL_PROVIDER>
 #endif
 
 #include "common_bundle.h"
+#include "rq_aggregate.h"
 #include "timestamp_provider.h"
 
 #define __THREAD_DATA_SIZE 1024
@@ -72,6 +85,9 @@ class RQProvider {
 
   DataStructure *ds_;
   RecordManager *const recmgr_;
+  // Allocates bundle entries from per-thread pools and recycles reclaimed ones
+  // once no range query can still be reading them.
+  BundleEntryManager<NodeType> *const entry_mgr_;
   TS_PROVIDER ts_provider;
 
   int init_[MAX_TID_POW2] = {
@@ -83,6 +99,7 @@ class RQProvider {
   struct cleanup_args {
     std::atomic<bool> *const stop;
     DataStructure *const ds;
+    BundleEntryManager<NodeType> *const entry_mgr;
     int tid;
   };
 
@@ -93,7 +110,11 @@ class RQProvider {
 
  public:
   RQProvider(const int num_processes, DataStructure *ds, RecordManager *recmgr)
-      : num_processes_(num_processes), ds_(ds), recmgr_(recmgr) {
+      : num_processes_(num_processes),
+        ds_(ds),
+        recmgr_(recmgr),
+        entry_mgr_(
+            new BundleEntryManager<NodeType>(num_processes, SIGQUIT)) {
     if (num_processes > MAX_TID_POW2) {
       cerr << "num_processes (" << num_processes << ") > maxthreads_pow2 ("
            << MAX_TID_POW2 << "): Please increase maxthreads_pow2 in config.mk";
@@ -104,10 +125,12 @@ class RQProvider {
       rq_thread_data_[i].data.rq_lin_time = BUNDLE_NULL_TIMESTAMP;
       rq_thread_data_[i].data.rq_flag = false;
     }
+    DEBUG_INIT_RQPROVIDER(num_processes);
 
   // Launches a background thread to handle bundle entry cleanup.
   #ifdef BUNDLE_CLEANUP_BACKGROUND
-    cleanup_args_ = new cleanup_args{&stop_cleanup_, ds_, num_processes_ - 1};
+    cleanup_args_ =
+        new cleanup_args{&stop_cleanup_, ds_, entry_mgr_, num_processes_ - 1};
     if (pthread_create(&cleanup_thread_, nullptr, cleanup_run,
                        (void *)cleanup_args_)) {
       cerr << "ERROR: could not create thread" << endl;
@@ -130,6 +153,8 @@ class RQProvider {
     delete cleanup_args_;
   #endif
     delete[] rq_thread_data_;
+    delete entry_mgr_;
+    DEBUG_DEINIT_RQPROVIDER(num_processes_);
   }
 
   void initThread(const int tid) {
@@ -137,6 +162,7 @@ class RQProvider {
       return;
     else
       init_[tid] = !init_[tid];
+    entry_mgr_->initThread(tid);
   }
 
   void deinitThread(const int tid) {
@@ -144,6 +170,7 @@ class RQProvider {
       return;
     else
       init_[tid] = !init_[tid];
+    entry_mgr_->deinitThread(tid);
   }
 
   inline void init_node(int tid, NodeType *const node) {}
@@ -164,9 +191,25 @@ class RQProvider {
     return *addr;
   }
 
-#define BUNDLE_INIT_CLEANUP(provider) \
-  const timestamp_t ts = provider->get_oldest_active_rq();
-#define BUNDLE_CLEAN_BUNDLE(bundle) bundle.reclaimEntries(ts)
+// A cleanup pass runs between BUNDLE_INIT_CLEANUP and BUNDLE_FINISH_CLEANUP,
+// in a function with the thread's tid in scope.
+#define BUNDLE_INIT_CLEANUP(provider)                  \
+  const timestamp_t ts = provider->start_cleanup(tid); \
+  auto *const bundle_entry_mgr = provider->get_entry_manager();
+#define BUNDLE_CLEAN_BUNDLE(bundle) \
+  bundle.reclaimEntries(tid, ts, bundle_entry_mgr)
+#define BUNDLE_FINISH_CLEANUP(provider) provider->end_cleanup(tid)
+
+  inline BundleEntryManager<NodeType> *get_entry_manager() { return entry_mgr_; }
+
+  // Reclaimed entries are retired, so the cleaning thread must not be
+  // quiescent in the entry manager until end_cleanup().
+  inline timestamp_t start_cleanup(const int tid) {
+    entry_mgr_->leaveQuiescentState(tid);
+    return get_oldest_active_rq();
+  }
+
+  inline void end_cleanup(const int tid) { entry_mgr_->enterQuiescentState(tid); }
 
   // Creates a snapshot of the current state of active RQs.
   inline timestamp_t get_oldest_active_rq() {
@@ -187,6 +230,7 @@ class RQProvider {
   static void *cleanup_run(void *args) {
     std::cout << "Starting cleanup" << std::endl << std::flush;
     struct cleanup_args *c = (struct cleanup_args *)args;
+    c->entry_mgr->initThread(c->tid);
     long i = 0;
     while (!(*(c->stop))) {
       usleep(BUNDLE_CLEANUP_SLEEP);
@@ -204,24 +248,26 @@ class RQProvider {
   #elif defined(BUNDLE_UNSAFE_BUNDLE)
     return BUNDLE_MIN_TIMESTAMP;
   #else
-    return ts_provider.Advance();
+    return ts_provider.Advance(tid);
   #endif
   }
 
   // Write the range query linearization time so updates do not recycle any
   // edges needed by this range query.
   inline timestamp_t start_traversal(int tid) {
+    // Protects the bundle entries this range query visits until end_traversal.
+    entry_mgr_->leaveQuiescentState(tid, BUNDLE_READ_ONLY);
   #if defined(BUNDLE_RQTS)
   // Reads drive timestamp.
     rq_thread_data_[tid].data.rq_flag.store(true, std::memory_order_acquire);
-    rq_thread_data_[tid].data.rq_lin_time = ts_provider.Advance() - 1; // TODO: this is for the original logical timestamp impl, not nec. clean (bc of epoch based things)
+    rq_thread_data_[tid].data.rq_lin_time = ts_provider.Advance(tid) - 1; // TODO: this is for the original logical timestamp impl, not nec. clean (bc of epoch based things)
     rq_thread_data_[tid].data.rq_flag.store(false, std::memory_order_release);
     return rq_thread_data_[tid].data.rq_lin_time;
   #elif defined(BUNDLE_UNSAFE_BUNDLE)
     return BUNDLE_MIN_TIMESTAMP;
   #else
     rq_thread_data_[tid].data.rq_flag.store(true, std::memory_order_acquire);
-    rq_thread_data_[tid].data.rq_lin_time = ts_provider.Read();
+    rq_thread_data_[tid].data.rq_lin_time = ts_provider.Snapshot();
     rq_thread_data_[tid].data.rq_flag.store(false, std::memory_order_release);
     return rq_thread_data_[tid].data.rq_lin_time;
   #endif
@@ -253,33 +299,64 @@ class RQProvider {
   #endif
   }
 
+  // as above, but folds the node's keys into aggregate (see rq_aggregate.h)
+  inline void traversal_try_add(const int tid, NodeType *const node,
+                                RQAggregate<K> &aggregate, const K &lo,
+                                const K &hi) {
+    K keys[RQ_DEBUGGING_MAX_KEYS_PER_NODE];
+    V values[RQ_DEBUGGING_MAX_KEYS_PER_NODE];
+    int keysInNode = ds_->getKeys(tid, node, keys, values);
+    assert(keysInNode < RQ_DEBUGGING_MAX_KEYS_PER_NODE);
+    if (keysInNode == 0) return;
+    aggregate.addMasked(keys, rq_range_mask(ds_, keys, keysInNode, lo, hi));
+  }
+
+  // Brackets a read of bundles outside of a range query (e.g., contains), so
+  // that the entries and buffers it visits are not reclaimed under it.
+  inline void start_read(const int tid) {
+    entry_mgr_->leaveQuiescentState(tid, BUNDLE_READ_ONLY);
+  }
+
+  inline void end_read(const int tid) { entry_mgr_->enterQuiescentState(tid); }
+
   // Reset the range query linearization time so that updates may recycle an
   // edge we needed.
   inline void end_traversal(int tid) {
   #ifndef BUNDLE_UNSAFE_BUNDLE
     rq_thread_data_[tid].data.rq_lin_time = BUNDLE_NULL_TIMESTAMP;
   #endif
+    entry_mgr_->enterQuiescentState(tid);
   }
 
   // Prepares bundles by calling prepare on each provided bundle-pointer pair.
-  inline void prepare_bundles(BUNDLE_TYPE_DECL<NodeType> *bundles[],
+  inline void prepare_bundles(const int tid,
+                              BUNDLE_TYPE_DECL<NodeType> *bundles[],
                               NodeType *const *const ptrs) {
     // PENDING_TIMESTAMP blocks all RQs that might see the update, ensuring that
     // the update is visible (i.e., get and RQ have the same linearization
     // point).
     SOFTWARE_BARRIER;
+    // With BUNDLE_LOCKFREE, prepare() spins on the ts_ of a pending head that
+    // a concurrent abort may retire, so the entry must not be recycled under
+    // it. This costs the insert path a fence.
+  #if defined BUNDLE_CLEANUP_UPDATE || defined BUNDLE_LOCKFREE
+    entry_mgr_->leaveQuiescentState(tid);
+  #endif
     int i = 0;
     BUNDLE_TYPE_DECL<NodeType> *curr_bundle = bundles[0];
     NodeType *curr_ptr = ptrs[0];
     while (curr_bundle != nullptr) {
-      curr_bundle->prepare(curr_ptr);
+      curr_bundle->prepare(tid, curr_ptr, entry_mgr_);
   #ifdef BUNDLE_CLEANUP_UPDATE
-      curr_bundle->reclaimEntries(get_oldest_active_rq());
+      curr_bundle->reclaimEntries(tid, get_oldest_active_rq(), entry_mgr_);
   #endif
       ++i;
       curr_bundle = bundles[i];
       curr_ptr = ptrs[i];
     }
+  #if defined BUNDLE_CLEANUP_UPDATE || defined BUNDLE_LOCKFREE
+    entry_mgr_->enterQuiescentState(tid);
+  #endif
   }
 
   inline void finalize_bundles(BUNDLE_TYPE_DECL<NodeType> **bundles,
@@ -294,6 +371,21 @@ class RQProvider {
     SOFTWARE_BARRIER;
   }
 
+  // Withdraws the entries added by prepare_bundles if the update failed.
+  inline void abort_bundles(const int tid,
+                            BUNDLE_TYPE_DECL<NodeType> **bundles) {
+    entry_mgr_->leaveQuiescentState(tid);
+    int i = 0;
+    BUNDLE_TYPE_DECL<NodeType> *curr_bundle = bundles[0];
+    while (curr_bundle != nullptr) {
+      curr_bundle->abort(tid, entry_mgr_);
+      ++i;
+      curr_bundle = bundles[i];
+    }
+    entry_mgr_->enterQuiescentState(tid);
+    SOFTWARE_BARRIER;
+  }
+
   // Find and update the newest reference in the predecesor's bundle. If this
   // operation is an insert, then the new nodes bundle must also be
   // initialized. Any node whose bundle is passed here must be locked.
@@ -352,9 +444,8 @@ class RQProvider {
         // physical deletion will happen at the same time as logical deletion
         physical_deletion_succeeded(tid, deletedNodes);
       }
-  #if defined USE_RQ_DEBUGGING
-      DEBUG_RECORD_UPDATE_CHECKSUM<K, V>(tid, ts, insertedNodes, deletedNodes, ds);
-  #endif
+      // The timestamp of a bundled update is only known to the data
+      // structure, which records it with DEBUG_RECORD_UPDATE_KEY.
     } else {
       if (!logicalDeletion) {
         // physical deletion will happen at the same time as logical deletion
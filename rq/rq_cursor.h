@@ -0,0 +1,144 @@
+// Streaming range queries.
+//
+// rangeQuery() writes every key in [lo, hi] into arrays supplied by the caller,
+// which must be sized for the largest range. Data structures that visit keys
+// in increasing order under a single snapshot also provide
+//
+//   template <typename Visitor>
+//   int rangeQueryVisit(const int tid, const K& lo, const K& hi,
+//                       Visitor& visitor);
+//
+// which passes the keys of the same snapshot to
+//
+//   bool visitor(const K* keys, const V* values, const int n);
+//
+// in increasing key order, in batches of at most RQ_CURSOR_BATCH_SIZE keys.
+// The batch lives in a buffer on the stack of the range query that is reused
+// for the next batch, so a visitor that keeps keys must copy them. Returning
+// false ends the range query early (e.g., for LIMIT). rangeQueryVisit returns
+// the number of keys passed to the visitor. A range query can restart (with a
+// new snapshot) only until its first batch has been passed to the visitor.
+// After that, a failed bundle lookup makes it resume the same snapshot from
+// the head (or root), and the cursor drops the keys it has already added.
+//
+// It is implemented by the bundled lazylist, lock-free list, skiplist,
+// unrolled skiplist, BST and Citrus tree, and by the vCAS lazylist and
+// skiplist. The trees walk their snapshot in order. The (a,b)-trees do not
+// have it yet. Nor do the EBR-RQ versions (rq_lockfree, rq_rwlock): their
+// results only become final in traversal_end, which adds keys found in
+// announcements and limbo bags, so they cannot be passed on before the
+// traversal is over.
+//
+// The microbenchmark uses it for its range queries with -rqvisit, and then
+// compares it with rangeQuery once the run is over.
+
+#ifndef RQ_CURSOR_H
+#define RQ_CURSOR_H
+
+#include <cstdlib>
+#include <iostream>
+
+#include "rq_debugging.h"
+
+#ifndef RQ_CURSOR_BATCH_SIZE
+#define RQ_CURSOR_BATCH_SIZE 64
+#endif
+
+template <typename K, typename V, typename Visitor>
+class RQCursor {
+ private:
+  Visitor& visitor_;
+  int size_;
+  int visited_;
+  bool stopped_;
+  bool resumed_;
+  bool skipping_;  // dropping keys up to last_ after resume()
+  K last_;         // the largest key added so far
+  // room for a full batch plus the keys of one more node
+  K keys_[RQ_CURSOR_BATCH_SIZE + RQ_DEBUGGING_MAX_KEYS_PER_NODE];
+  V values_[RQ_CURSOR_BATCH_SIZE + RQ_DEBUGGING_MAX_KEYS_PER_NODE];
+
+  // Removes the keys up to last_ from the n keys written at keys(), and
+  // returns how many are left. The keys of later nodes are larger, so
+  // skipping stops at the first node with a key left.
+  inline int dropUpToLast(const int n) {
+    int kept = 0;
+    for (int i = size_; i < size_ + n; ++i) {
+      if (last_ < keys_[i]) {
+        keys_[size_ + kept] = keys_[i];
+        values_[size_ + kept] = values_[i];
+        ++kept;
+      }
+    }
+    skipping_ = (kept == 0);
+    return kept;
+  }
+
+ public:
+  explicit RQCursor(Visitor& visitor)
+      : visitor_(visitor),
+        size_(0),
+        visited_(0),
+        stopped_(false),
+        resumed_(false),
+        skipping_(false),
+        last_() {}
+
+  // Where the next node's keys and values (at most
+  // RQ_DEBUGGING_MAX_KEYS_PER_NODE) should be written.
+  inline K* keys() { return keys_ + size_; }
+  inline V* values() { return values_ + size_; }
+
+  // Appends the n keys that were written at keys() and values(). Returns false
+  // once the visitor has ended the range query.
+  inline bool add(int n) {
+    if (skipping_) n = dropUpToLast(n);
+    for (int i = size_; i < size_ + n; ++i) {
+      if ((visited_ == 0 && i == 0) || last_ < keys_[i]) last_ = keys_[i];
+    }
+    size_ += n;
+    if (size_ >= RQ_CURSOR_BATCH_SIZE) return flush();
+    return true;
+  }
+
+  // Passes any buffered keys to the visitor. Returns false once the visitor
+  // has ended the range query.
+  inline bool flush() {
+    if (size_ > 0 && !stopped_) {
+      visited_ += size_;
+      stopped_ = !visitor_(keys_, values_, size_);
+    }
+    size_ = 0;
+    return !stopped_;
+  }
+
+  // Drops the buffered keys so that the range query can start over with a new
+  // snapshot. Once keys have been passed to the visitor, the range query must
+  // finish with the snapshot it has, so it was resumed (see resume()). Failing
+  // again then means the snapshot is lost, which is reported as an error.
+  inline bool restart() {
+    if (visited_ > 0 || stopped_) {
+      std::cout << "ERROR: a range query lost its snapshot after passing "
+                << visited_ << " keys to the visitor" << std::endl;
+      exit(-1);
+    }
+    size_ = 0;
+    return true;
+  }
+
+  // Returns true, once, if a failed bundle lookup should make the range query
+  // walk its snapshot again from the head instead of restarting, because keys
+  // have been passed to the visitor. Keys up to last() are then dropped.
+  inline bool resume() {
+    if (visited_ == 0 || stopped_ || resumed_) return false;
+    resumed_ = true;
+    skipping_ = true;
+    return true;
+  }
+
+  inline const K& last() const { return last_; }
+
+  inline int visited() const { return visited_; }
+};
+
+#endif /* RQ_CURSOR_H */
@@ -22,6 +22,8 @@
     #define DEBUG_RECORD_RQ_VISITED //
     #define DEBUG_RECORD_RQ_SIZE //
     #define DEBUG_RECORD_RQ_CHECKSUM //
+    #define DEBUG_RECORD_RQ_RESULT //
+    #define DEBUG_RECORD_UPDATE_KEY //
 
 #else
 
@@ -82,6 +84,222 @@
         long long ** threadRQChecksum; //[MAX_TID_POW2][MAX_NUM_RQ_IN_EXECUTION];
     #endif
 
+    #ifdef RQ_LINEARIZABILITY
+        /**
+         * Linearizability recording mode.
+         *
+         * Unlike RQ_VALIDATION, which buckets checksums by timestamp and therefore
+         * only works with small logical timestamps and RQs over the whole key
+         * range, this logs every update (key, +1 insert / -1 delete, linearization
+         * timestamp) and every RQ (lo, hi, snapshot timestamps, keys returned)
+         * into per-thread single-producer single-consumer ring buffers. A
+         * background thread drains the rings into per-thread logs while the
+         * experiment runs. At the end, the logs are merged and replayed in
+         * timestamp order, and each RQ result is compared with the key set in
+         * [lo, hi] reconstructed at its timestamp. This works with any clock,
+         * including the TSC-based ones.
+         *
+         * Some clocks let an RQ share its timestamp with updates it may or may
+         * not see, so an RQ gives two bounds: it must reflect every update with
+         * timestamp < visibleBelow and no update with timestamp > invisibleAbove.
+         * For each key, updates in between may or may not be reflected.
+         */
+        #include <unistd.h>
+        #include <algorithm>
+        #include <atomic>
+        #include <map>
+        #include <thread>
+        #include <vector>
+        #include "plaf.h"
+
+        #ifndef RQ_LIN_RING_SIZE
+            #define RQ_LIN_RING_SIZE (1<<16) // events per thread; must be a power of two
+        #endif
+        #define RQ_LIN_DRAIN_SLEEP_US 100
+        #define RQ_LIN_EVENT_UPDATE 0
+        #define RQ_LIN_EVENT_RQ 1
+        #define RQ_LIN_EVENT_RQ_KEY 2   // one per key returned, right after its RQ_LIN_EVENT_RQ
+
+        struct rq_lin_event_t {
+            long long ts;       // update: timestamp; RQ: visibleBelow
+            long long ts2;      // RQ: invisibleAbove
+            long long key;      // update and RQ_KEY: key; RQ: lo
+            long long arg;      // update: +1 or -1; RQ: hi
+            long long size;     // RQ: number of keys returned
+            int type;
+        };
+
+        struct rq_lin_ring_t {
+            volatile char padding0[PREFETCH_SIZE_BYTES];
+            std::atomic<long long> head;    // written by the owner thread
+            volatile char padding1[PREFETCH_SIZE_BYTES];
+            std::atomic<long long> tail;    // written by the drainer
+            volatile char padding2[PREFETCH_SIZE_BYTES];
+            long long stalls;               // pushes that waited for the drainer
+            rq_lin_event_t events[RQ_LIN_RING_SIZE];
+        };
+
+        struct rq_lin_rq_t {
+            rq_lin_event_t header;
+            std::vector<long long> keys;
+        };
+
+        int rqLinNumProcesses = 0;
+        rq_lin_ring_t * rqLinRings;
+        std::vector<rq_lin_event_t> * rqLinLogs;
+        std::atomic<bool> rqLinStop;
+        std::thread * rqLinDrainer = NULL;
+        bool rqLinVerified = false;
+
+        // The owner thread waits (rather than dropping the event) if the drainer
+        // is a full ring behind, since a lost update would invalidate every later RQ.
+        inline void rq_lin_push(const int tid, const rq_lin_event_t& e) {
+            rq_lin_ring_t& ring = rqLinRings[tid];
+            const long long h = ring.head.load(std::memory_order_relaxed);
+            if (h - ring.tail.load(std::memory_order_acquire) >= RQ_LIN_RING_SIZE) {
+                ++ring.stalls;
+                while (h - ring.tail.load(std::memory_order_acquire) >= RQ_LIN_RING_SIZE) {}
+            }
+            ring.events[h & (RQ_LIN_RING_SIZE-1)] = e;
+            ring.head.store(h+1, std::memory_order_release);
+        }
+
+        inline bool rq_lin_drain() {
+            bool drained = false;
+            for (int tid=0;tid<rqLinNumProcesses;++tid) {
+                rq_lin_ring_t& ring = rqLinRings[tid];
+                const long long h = ring.head.load(std::memory_order_acquire);
+                long long t = ring.tail.load(std::memory_order_relaxed);
+                if (t == h) continue;
+                for (;t<h;++t) {
+                    rqLinLogs[tid].push_back(ring.events[t & (RQ_LIN_RING_SIZE-1)]);
+                }
+                ring.tail.store(h, std::memory_order_release);
+                drained = true;
+            }
+            return drained;
+        }
+
+        void rq_lin_drainer_run() {
+            while (!rqLinStop.load(std::memory_order_acquire)) {
+                if (!rq_lin_drain()) usleep(RQ_LIN_DRAIN_SLEEP_US);
+            }
+            rq_lin_drain();
+        }
+
+        inline bool rq_lin_update_less(const rq_lin_event_t& a, const rq_lin_event_t& b) {
+            return a.ts < b.ts;
+        }
+
+        inline bool rq_lin_rq_less(const rq_lin_rq_t& a, const rq_lin_rq_t& b) {
+            return a.header.ts < b.header.ts;
+        }
+
+        // Returns the number of keys whose presence in rq cannot be explained by
+        // any state between its two timestamps. Updates before updatesBegin have
+        // been applied to keys; [updatesBegin, updatesEnd) are in rq's window.
+        long long rq_lin_check(const rq_lin_rq_t& rq, const std::map<long long, long long>& keys, const std::vector<rq_lin_event_t>& updates, const size_t updatesBegin, const size_t updatesEnd) {
+            const long long lo = rq.header.key;
+            const long long hi = rq.header.arg;
+            // key -> (may be present, may be absent)
+            std::map<long long, std::pair<bool, bool> > allowed;
+            for (std::map<long long, long long>::const_iterator it = keys.lower_bound(lo); it != keys.end() && it->first <= hi; ++it) {
+                allowed[it->first] = std::make_pair(it->second > 0, it->second <= 0);
+            }
+            std::map<long long, long long> window; // key -> count as window updates are applied
+            for (size_t i=updatesBegin;i<updatesEnd;++i) {
+                const long long key = updates[i].key;
+                if (key < lo || key > hi) continue;
+                std::map<long long, long long>::iterator w = window.find(key);
+                if (w == window.end()) {
+                    std::map<long long, long long>::const_iterator k = keys.find(key);
+                    w = window.insert(std::make_pair(key, k == keys.end() ? 0LL : k->second)).first;
+                    if (k == keys.end()) allowed[key] = std::make_pair(false, true);
+                }
+                w->second += updates[i].arg;
+                std::pair<bool, bool>& a = allowed[key];
+                if (w->second > 0) a.first = true; else a.second = true;
+            }
+            long long errors = 0;
+            std::vector<long long> result = rq.keys;
+            std::sort(result.begin(), result.end());
+            for (size_t i=0;i<result.size();++i) {
+                if (result[i] < lo || result[i] > hi || (i > 0 && result[i] == result[i-1])) {
+                    ++errors;   // out of range or duplicate
+                    continue;
+                }
+                std::map<long long, std::pair<bool, bool> >::iterator a = allowed.find(result[i]);
+                if (a == allowed.end() || !a->second.first) ++errors;
+                if (a != allowed.end()) a->second.second = true; // checked
+            }
+            for (std::map<long long, std::pair<bool, bool> >::iterator a = allowed.begin(); a != allowed.end(); ++a) {
+                if (!a->second.second) ++errors;    // must be present, but was not returned
+            }
+            return errors;
+        }
+
+        // Replays the merged logs in timestamp order and checks every RQ against
+        // the key set in [lo, hi] between its two timestamps.
+        void rq_lin_verify() {
+            if (rqLinVerified) return;
+            rqLinVerified = true;
+            rqLinStop.store(true, std::memory_order_release);
+            rqLinDrainer->join();
+
+            std::vector<rq_lin_event_t> updates;
+            std::vector<rq_lin_rq_t> rqs;
+            long long stalls = 0;
+            for (int tid=0;tid<rqLinNumProcesses;++tid) {
+                for (size_t i=0;i<rqLinLogs[tid].size();++i) {
+                    const rq_lin_event_t& e = rqLinLogs[tid][i];
+                    if (e.type == RQ_LIN_EVENT_UPDATE) {
+                        updates.push_back(e);
+                    } else if (e.type == RQ_LIN_EVENT_RQ) {
+                        rqs.push_back(rq_lin_rq_t());
+                        rqs.back().header = e;
+                    } else {
+                        rqs.back().keys.push_back(e.key);
+                    }
+                }
+                stalls += rqLinRings[tid].stalls;
+            }
+            std::stable_sort(updates.begin(), updates.end(), rq_lin_update_less);
+            std::stable_sort(rqs.begin(), rqs.end(), rq_lin_rq_less);
+
+            std::map<long long, long long> keys; // key -> number of nodes containing it
+            size_t u = 0;
+            long long numberFailed = 0;
+            for (size_t r=0;r<rqs.size();++r) {
+                const rq_lin_event_t& rq = rqs[r].header;
+                for (;u<updates.size() && updates[u].ts < rq.ts;++u) {
+                    long long& cnt = keys[updates[u].key];
+                    cnt += updates[u].arg;
+                    if (cnt == 0) keys.erase(updates[u].key);
+                }
+                size_t w = u;
+                while (w < updates.size() && updates[w].ts <= rq.ts2) ++w;
+                const long long errors = rq_lin_check(rqs[r], keys, updates, u, w);
+                if (errors) {
+                    ++numberFailed;
+                    if (numberFailed < 100) {
+                        cout<<"RQ LINEARIZABILITY ERROR: rq [lo="<<rq.key<<", hi="<<rq.arg<<"] at timestamps ["<<rq.ts<<", "<<rq.ts2<<"] returned "<<rq.size<<" keys, "<<errors<<" of which (or missing keys) match no state in between"<<endl;
+                    } else if (numberFailed == 100) {
+                        cout<<"RQ LINEARIZABILITY: too many errors to list..."<<endl;
+                    }
+                }
+            }
+            cout<<"RQ LINEARIZABILITY UPDATES RECORDED: "<<updates.size()<<endl;
+            cout<<"RQ LINEARIZABILITY RQS CHECKED: "<<rqs.size()<<endl;
+            cout<<"RQ LINEARIZABILITY RING STALLS: "<<stalls<<endl;
+            if (numberFailed > 0) {
+                cout<<"RQ LINEARIZABILITY TOTAL FAILURES: "<<numberFailed<<endl;
+            } else {
+                cout<<"RQ Linearizability OK"<<endl;
+            }
+            cout<<endl;
+        }
+    #endif
+
     #ifdef RQ_HISTOGRAM
         #include <fstream>
         #define CSV_OUTPUT_FILE "data.csv"
@@ -105,8 +323,39 @@
     #endif
         }
 
+        // For data structures whose RQ provider does not see the inserted and
+        // deleted nodes (rq_bundle): records that key was inserted (delta = 1) or
+        // deleted (delta = -1) at timestamp.
+        template <typename K>
+        inline void DEBUG_RECORD_UPDATE_KEY(const int tid, const long long timestamp, const K& key, const int delta) {
+    #ifdef RQ_LINEARIZABILITY
+            rq_lin_event_t e;
+            e.type = RQ_LIN_EVENT_UPDATE;
+            e.ts = timestamp;
+            e.key = (long long) key;
+            e.ts2 = timestamp;
+            e.arg = delta;
+            e.size = 0;
+            rq_lin_push(tid, e);
+    #endif
+        }
+
         template <typename K, typename V, typename Node, class DataStructure>
         inline void DEBUG_RECORD_UPDATE_CHECKSUM(const int tid, const long long timestamp, Node * const * const insertedNodes, Node * const * const deletedNodes, DataStructure * const ds) {
+    #ifdef RQ_LINEARIZABILITY
+            for (int i=0;insertedNodes[i];++i) {
+                K outputKeys[RQ_DEBUGGING_MAX_KEYS_PER_NODE];
+                V outputValues[RQ_DEBUGGING_MAX_KEYS_PER_NODE];
+                int cnt = ds->getKeys(tid, insertedNodes[i], outputKeys, outputValues);
+                for (int j=0;j<cnt;++j) DEBUG_RECORD_UPDATE_KEY(tid, timestamp, outputKeys[j], 1);
+            }
+            for (int i=0;deletedNodes[i];++i) {
+                K outputKeys[RQ_DEBUGGING_MAX_KEYS_PER_NODE];
+                V outputValues[RQ_DEBUGGING_MAX_KEYS_PER_NODE];
+                int cnt = ds->getKeys(tid, deletedNodes[i], outputKeys, outputValues);
+                for (int j=0;j<cnt;++j) DEBUG_RECORD_UPDATE_KEY(tid, timestamp, outputKeys[j], -1);
+            }
+    #endif
     #ifdef RQ_VALIDATION
             if (timestamp >= MAX_NUM_RQ_IN_EXECUTION) {
                 return;
@@ -154,7 +403,43 @@
     #endif
         }
 
+        // Records the result of an RQ over [lo, hi] that reflects every update with
+        // timestamp < visibleBelow and none with timestamp > invisibleAbove.
+        template <typename K>
+        inline void DEBUG_RECORD_RQ_RESULT(const int tid, const long long visibleBelow, const long long invisibleAbove, const K& lo, const K& hi, K const * const rqResult, const int len) {
+    #ifdef RQ_LINEARIZABILITY
+            rq_lin_event_t e;
+            e.type = RQ_LIN_EVENT_RQ;
+            e.ts = visibleBelow;
+            e.ts2 = invisibleAbove;
+            e.key = (long long) lo;
+            e.arg = (long long) hi;
+            e.size = len;
+            rq_lin_push(tid, e);
+            e.type = RQ_LIN_EVENT_RQ_KEY;
+            for (int i=0;i<len;++i) {
+                e.key = (long long) rqResult[i];
+                rq_lin_push(tid, e);
+            }
+    #endif
+        }
+
         void DEBUG_INIT_RQPROVIDER(const int numProcesses) {
+    #ifdef RQ_LINEARIZABILITY
+            if (rqLinDrainer == NULL) {
+                rqLinNumProcesses = numProcesses;
+                rqLinRings = new rq_lin_ring_t[numProcesses];
+                rqLinLogs = new std::vector<rq_lin_event_t>[numProcesses];
+                for (int tid=0;tid<numProcesses;++tid) {
+                    rqLinRings[tid].head.store(0);
+                    rqLinRings[tid].tail.store(0);
+                    rqLinRings[tid].stalls = 0;
+                }
+                rqLinStop.store(false);
+                rqLinVerified = false;
+                rqLinDrainer = new std::thread(rq_lin_drainer_run);
+            }
+    #endif
     #ifdef RQ_HISTOGRAM
             ofs.open(CSV_OUTPUT_FILE, std::ofstream::out);
             for (int size=0;size<=MAX_RQ_SIZE;++size) {
@@ -183,6 +468,9 @@
         }
 
         void DEBUG_VALIDATE_RQ(const int numProcesses) {
+    #ifdef RQ_LINEARIZABILITY
+            rq_lin_verify();
+    #endif
     #ifdef RQ_VALIDATION
             long long * updateChecksum = new long long[MAX_NUM_RQ_IN_EXECUTION];
             long long * rqChecksum = new long long[MAX_NUM_RQ_IN_EXECUTION];
@@ -280,6 +568,15 @@
         }
 
         void DEBUG_DEINIT_RQPROVIDER(const int numProcesses) {
+    #ifdef RQ_LINEARIZABILITY
+            if (rqLinDrainer != NULL) {
+                rq_lin_verify();
+                delete rqLinDrainer;
+                rqLinDrainer = NULL;
+                delete[] rqLinRings;
+                delete[] rqLinLogs;
+            }
+    #endif
     #ifdef RQ_HISTOGRAM
             ofs<<"x,y"<<endl;
             for (int size=0;size<=MAX_RQ_SIZE;++size) {
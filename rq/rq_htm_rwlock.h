@@ -23,10 +23,46 @@
 #include <hashlist.h>
 #include <rwlock.h>
 #include <rtm.h>
+#include <htm_support.h>
 #include <pthread.h>
 #include <cassert>
 
+/**
+ * Retry policy for the htm path of updates.
+ * Each thread has a budget of attempts, starting at MAX_HTM_ATTEMPTS.
+ * It grows by one when a transaction commits after using more than half of it,
+ * and halves when it runs out, so threads whose transactions rarely commit
+ * fall back sooner. Capacity aborts and aborts without a retry hint go to the
+ * fallback path at once, except explicit aborts (a range query held the lock),
+ * which are retried. After HTM_CAPACITY_STREAK consecutive capacity aborts a
+ * thread skips the htm path for its next HTM_DISABLE_OPS updates.
+ * If the machine has no usable RTM, the htm path is never taken.
+ */
 #define MAX_HTM_ATTEMPTS 30
+#define HTM_MIN_ATTEMPTS 1
+#define HTM_MAX_ATTEMPTS 128
+#define HTM_CAPACITY_STREAK 4
+#define HTM_DISABLE_OPS 1000
+
+// indices of the htm_aborts statistic
+enum htm_abort_cause_t {
+    HTM_ABORT_EXPLICIT,     // a range query held the lock
+    HTM_ABORT_CONFLICT,
+    HTM_ABORT_CAPACITY,
+    HTM_ABORT_RETRY,        // retry hint without any other cause
+    HTM_ABORT_OTHER,        // e.g., interrupts, page faults, unsupported instructions
+    HTM_ABORT_NUM_CAUSES
+};
+
+// The abort telemetry is only recorded when the including program has set up
+// GSTATS (see microbench/globals.h) before including this header.
+#ifdef GSTATS_ADD
+#define HTM_GSTATS_ADD(tid, stat, val) GSTATS_ADD(tid, stat, val)
+#define HTM_GSTATS_ADD_IX(tid, stat, val, index) GSTATS_ADD_IX(tid, stat, val, index)
+#else
+#define HTM_GSTATS_ADD(tid, stat, val)
+#define HTM_GSTATS_ADD_IX(tid, stat, val, index)
+#endif
 
 #define dosum(src) ({ \
     long long __sum = 0; \
@@ -56,6 +92,11 @@ private:
                 int commitReader;
                 int abortReader;
                 int fallback;
+
+                // htm retry policy
+                int htmBudget;
+                int htmCapacityStreak;
+                int htmDisabledOps;
             };
             char bytes[__RQ_THREAD_DATA_SIZE]; // avoid false sharing
         };
@@ -74,16 +115,66 @@ private:
     
     DataStructure * ds;
     RecordManager * const recmgr;
+    const bool useHTM;
 
     int init[MAX_TID_POW2] = {0,};
 
+    inline bool htmAllowed(const int tid) {
+        if (!useHTM) return false;
+        if (threadData[tid].htmDisabledOps > 0) {
+            --threadData[tid].htmDisabledOps;
+            return false;
+        }
+        return true;
+    }
+
+    inline void htmCommitted(const int tid, const int attempts) {
+        ++threadData[tid].commitReader;
+        HTM_GSTATS_ADD(tid, htm_commits, 1);
+        threadData[tid].htmCapacityStreak = 0;
+        if (2*attempts > threadData[tid].htmBudget && threadData[tid].htmBudget < HTM_MAX_ATTEMPTS) {
+            ++threadData[tid].htmBudget;
+        }
+    }
+
+    // returns true if the transaction is worth retrying
+    inline bool htmAborted(const int tid, const unsigned int status) {
+        ++threadData[tid].abortReader;
+        htm_abort_cause_t cause;
+        if (status & _XABORT_EXPLICIT) cause = HTM_ABORT_EXPLICIT;
+        else if (status & _XABORT_CAPACITY) cause = HTM_ABORT_CAPACITY;
+        else if (status & _XABORT_CONFLICT) cause = HTM_ABORT_CONFLICT;
+        else if (status & _XABORT_RETRY) cause = HTM_ABORT_RETRY;
+        else cause = HTM_ABORT_OTHER;
+        HTM_GSTATS_ADD_IX(tid, htm_aborts, 1, cause);
+
+        if (cause == HTM_ABORT_CAPACITY) {
+            if (++threadData[tid].htmCapacityStreak >= HTM_CAPACITY_STREAK) {
+                threadData[tid].htmCapacityStreak = 0;
+                threadData[tid].htmDisabledOps = HTM_DISABLE_OPS;
+                HTM_GSTATS_ADD(tid, htm_disabled, 1);
+            }
+            return false;
+        }
+        // an explicit abort never carries the retry hint; it is retried since
+        // the range query that held the lock will release it
+        return cause == HTM_ABORT_EXPLICIT || (status & _XABORT_RETRY);
+    }
+
+    inline void htmGaveUp(const int tid, const int attempts) {
+        if (attempts >= threadData[tid].htmBudget) {
+            threadData[tid].htmBudget = std::max(HTM_MIN_ATTEMPTS, threadData[tid].htmBudget / 2);
+        }
+    }
+
 public:
-    RQProvider(const int numProcesses, DataStructure * ds, RecordManager * recmgr) : NUM_PROCESSES(numProcesses), ds(ds), recmgr(recmgr) {
+    RQProvider(const int numProcesses, DataStructure * ds, RecordManager * recmgr) : NUM_PROCESSES(numProcesses), ds(ds), recmgr(recmgr), useHTM(htm_supported()) {
         threadData = new __rq_thread_data[numProcesses];
         DEBUG_INIT_RQPROVIDER(numProcesses);
     }
 
     ~RQProvider() {
+        cout<<"htm path       : "<<(useHTM ? "enabled" : "disabled (no usable RTM)")<<endl;
         cout<<"writer commits : "<<dosum(commitWriter)<<endl;
         cout<<"writer aborts  : "<<dosum(abortWriter)<<endl;
         cout<<"reader commits : "<<dosum(commitReader)<<endl;
@@ -117,6 +208,9 @@ public:
         threadData[tid].commitReader = 0;
         threadData[tid].abortReader = 0;
         threadData[tid].fallback = 0;
+        threadData[tid].htmBudget = MAX_HTM_ATTEMPTS;
+        threadData[tid].htmCapacityStreak = 0;
+        threadData[tid].htmDisabledOps = 0;
         DEBUG_INIT_THREAD(tid);
     }
 
@@ -235,22 +329,28 @@ public:
 
         // htm path
         long long ts;
-        int limit = MAX_HTM_ATTEMPTS;
-        while (limit--) {
-            while (rwlock.isWriteLocked()) {}
-            if (XBEGIN() == _XBEGIN_STARTED) {
-                if (rwlock.isWriteLocked()) XABORT(1);
-                ts = timestamp;
-                *lin_addr = lin_newval; // original linearization point
-                XEND();
-                ++threadData[tid].commitReader;
-                goto committed;
-            } else ++threadData[tid].abortReader;
-
+        if (htmAllowed(tid)) {
+            int attempts = 0;
+            while (attempts < threadData[tid].htmBudget) {
+                ++attempts;
+                while (rwlock.isWriteLocked()) {}
+                const unsigned int status = XBEGIN();
+                if (status == _XBEGIN_STARTED) {
+                    if (rwlock.isWriteLocked()) XABORT(1);
+                    ts = timestamp;
+                    *lin_addr = lin_newval; // original linearization point
+                    XEND();
+                    htmCommitted(tid, attempts);
+                    goto committed;
+                }
+                if (!htmAborted(tid, status)) break;
+            }
+            htmGaveUp(tid, attempts);
         }
         
         // fallback path
         ++threadData[tid].fallback;
+        HTM_GSTATS_ADD(tid, htm_fallbacks, 1);
         rwlock.readLock();
         ts = timestamp;
         *lin_addr = lin_newval; // original linearization point
@@ -290,23 +390,30 @@ committed:
         // htm path
         long long ts;
         T res;
-        int limit = MAX_HTM_ATTEMPTS;
-        while (limit--) {
-            while (rwlock.isWriteLocked()) {}
-            if (XBEGIN() == _XBEGIN_STARTED) {
-                if (rwlock.isWriteLocked()) XABORT(1);
-                ts = timestamp;
-                res = __sync_val_compare_and_swap(lin_addr, lin_oldval, lin_newval); // original linearization point
-//                res = *lin_addr; // manually implement CAS
-//                if (res == lin_oldval) *lin_addr = lin_newval;
-                XEND();
-                ++threadData[tid].commitReader;
-                goto committed;
-            } else ++threadData[tid].abortReader;
+        if (htmAllowed(tid)) {
+            int attempts = 0;
+            while (attempts < threadData[tid].htmBudget) {
+                ++attempts;
+                while (rwlock.isWriteLocked()) {}
+                const unsigned int status = XBEGIN();
+                if (status == _XBEGIN_STARTED) {
+                    if (rwlock.isWriteLocked()) XABORT(1);
+                    ts = timestamp;
+                    res = __sync_val_compare_and_swap(lin_addr, lin_oldval, lin_newval); // original linearization point
+//                    res = *lin_addr; // manually implement CAS
+//                    if (res == lin_oldval) *lin_addr = lin_newval;
+                    XEND();
+                    htmCommitted(tid, attempts);
+                    goto committed;
+                }
+                if (!htmAborted(tid, status)) break;
+            }
+            htmGaveUp(tid, attempts);
         }
         
         // fallback path
         ++threadData[tid].fallback;
+        HTM_GSTATS_ADD(tid, htm_fallbacks, 1);
         rwlock.readLock();
         ts = timestamp;
         res = __sync_val_compare_and_swap(lin_addr, lin_oldval, lin_newval);
@@ -563,6 +670,7 @@ public:
         DEBUG_RECORD_RQ_VISITED(tid, threadData[tid].rq_lin_time, numVisitedInEpochBags);
         DEBUG_RECORD_RQ_SIZE(*startIndex);
         DEBUG_RECORD_RQ_CHECKSUM(tid, threadData[tid].rq_lin_time, rqResultKeys, *startIndex);
+        DEBUG_RECORD_RQ_RESULT(tid, threadData[tid].rq_lin_time, threadData[tid].rq_lin_time - 1, lo, hi, rqResultKeys, *startIndex);
     }
 };
 
@@ -45,6 +45,7 @@ extern Random rngs[MAX_TID_POW2 * PREFETCH_SIZE_WORDS];
 
 #include <pthread.h>
 #include <hashlist.h>
+#include "rq_aggregate.h"
 #include "rq_debugging.h"
 #include "dcss_plus_impl.h"
 
@@ -87,6 +88,7 @@ private:
             { // anonymous struct inside anonymous union means we don't need to type anything special to access these variables
                 long long rq_lin_time;
                 HashList<K> *hashlist;
+                blockbag<NodeType> **bags; // scratch space for traversal_end
 #ifdef COUNT_CODE_PATH_EXECUTIONS
                 long long codePathExecutions[CODE_COVERAGE_MAX_PATHS];
 #endif
@@ -189,6 +191,7 @@ public:
         prov->initThread(tid);
         threadData[tid].hashlist = new HashList<K>();
         threadData[tid].hashlist->init(HASHLIST_INIT_CAPACITY_POW2);
+        threadData[tid].bags = new blockbag<NodeType> *[NUM_PROCESSES * NUMBER_OF_EPOCH_BAGS + 1];
         threadData[tid].numAnnouncements = 0;
         for (int i = 0; i < MAX_NODES_INSERTED_OR_DELETED_ATOMICALLY; ++i)
         {
@@ -214,6 +217,7 @@ public:
         prov->deinitThread(tid);
         threadData[tid].hashlist->destroy();
         delete threadData[tid].hashlist;
+        delete[] threadData[tid].bags;
 #ifdef COUNT_CODE_PATH_EXECUTIONS
         for (int i = 0; i < CODE_COVERAGE_MAX_PATHS; ++i)
         {
@@ -734,20 +738,55 @@ private:
 #endif
     }
 
+    inline void traversal_try_add(const int tid, NodeType *const node, RQAggregate<K> &aggregate, const K &lo, const K &hi, bool foundDuringTraversal)
+    {
+        K keys[RQ_DEBUGGING_MAX_KEYS_PER_NODE];
+        V values[RQ_DEBUGGING_MAX_KEYS_PER_NODE];
+        int numNewKeys = __traversal_try_add(tid, node, keys, values, lo, hi, foundDuringTraversal);
+        for (int i = 0; i < numNewKeys; ++i)
+        {
+            threadData[tid].hashlist->insert(keys[i]);
+            aggregate.add(keys[i]);
+        }
+    }
+
+    // the result arrays of traversal_end
+    struct array_result_t
+    {
+        K *keys;
+        V *values;
+        int *startIndex;
+    };
+
+    inline void traversal_try_add_missed(const int tid, NodeType *const node, array_result_t &result, const K &lo, const K &hi)
+    {
+        traversal_try_add(tid, node, result.keys, result.values, result.startIndex, lo, hi, false);
+    }
+
+    inline void traversal_try_add_missed(const int tid, NodeType *const node, RQAggregate<K> &aggregate, const K &lo, const K &hi)
+    {
+        traversal_try_add(tid, node, aggregate, lo, hi, false);
+    }
+
 public:
     inline void traversal_try_add(const int tid, NodeType *const node, K *const rqResultKeys, V *const rqResultValues, int *const startIndex, const K &lo, const K &hi)
     {
         traversal_try_add(tid, node, rqResultKeys, rqResultValues, startIndex, lo, hi, true);
     }
 
-    // invoke at the end of each traversal:
+    // as above, but folds the node's keys into aggregate (see rq_aggregate.h)
+    inline void traversal_try_add(const int tid, NodeType *const node, RQAggregate<K> &aggregate, const K &lo, const K &hi)
+    {
+        traversal_try_add(tid, node, aggregate, lo, hi, true);
+    }
+
+private:
     // any nodes that were deleted during the traversal,
     // and were consequently missed during the traversal,
-    // are placed in rqResult[index]
-    void traversal_end(const int tid, K *const rqResultKeys, V *const rqResultValues, int *const startIndex, const K &lo, const K &hi)
+    // are added to result
+    template <typename Result>
+    void traversal_add_missed(const int tid, Result &result, const K &lo, const K &hi)
     {
-        // todo: possibly optimize by skipping entire blocks if there are many keys to skip (does not seem to be justifiable for 4 work threads and 4 range query threads)
-
         SOFTWARE_BARRIER;
         long long end_timestamp = timestamp;
         SOFTWARE_BARRIER;
@@ -826,34 +865,47 @@ public:
                 {
                     NodeType *node = (NodeType *)threadData[otherTid].announcements[i];
                     assert(node);
-                    traversal_try_add(tid, node, rqResultKeys, rqResultValues, startIndex, lo, hi, false);
+                    traversal_try_add_missed(tid, node, result, lo, hi);
                 }
                 numVisitedInAnnouncements += sz;
             }
         SOFTWARE_BARRIER;
 
         // collect epoch bags of other processes (MUST be after checking announcements!)
-        blockbag<NodeType> *all_bags[NUM_PROCESSES * NUMBER_OF_EPOCH_BAGS + 1];
-        vector<blockbag_iterator<NodeType>> all_iterators;
-        int numIterators = 0;
+        blockbag<NodeType> **const all_bags = threadData[tid].bags;
+        int numBags = 0;
         for (int otherTid = 0; otherTid < NUM_PROCESSES; ++otherTid)
             if (otherTid != tid)
             {
-                blockbag<NodeType> *thread_bags[NUMBER_OF_EPOCH_BAGS + 1];
-                recmgr->get((NodeType *)NULL)->reclaim->getSafeBlockbags(otherTid, thread_bags);
-                for (int i = 0; thread_bags[i]; ++i)
-                {
-                    all_bags[numIterators] = thread_bags[i];
-                    all_iterators.push_back(thread_bags[i]->begin());
-                    ++numIterators;
-                }
+                // fills in the safe bags of otherTid, followed by NULL
+                recmgr->get((NodeType *)NULL)->reclaim->getSafeBlockbags(otherTid, all_bags + numBags);
+                while (all_bags[numBags])
+                    ++numBags;
             }
 
-        for (int ix = 0; ix < numIterators; ++ix)
+        for (int ix = 0; ix < numBags; ++ix)
         {
-            for (; all_iterators[ix] != all_bags[ix]->end(); all_iterators[ix]++)
+            const blockbag_iterator<NodeType> end = all_bags[ix]->end();
+            blockbag_iterator<NodeType> it = all_bags[ix]->begin();
+            block<NodeType> *summarized = NULL;
+            while (it != end)
             {
-                NodeType *node = (*all_iterators[ix]);
+                // skip blocks whose nodes were all deleted before the RQ,
+                // or all deleted after end_timestamp (see below)
+                if (it.getCurr() != summarized)
+                {
+                    summarized = it.getCurr();
+                    if (summarized->getMaxStamp() < threadData[tid].rq_lin_time || summarized->getMinStamp() > end_timestamp)
+                    {
+                        numVisitedInEpochBags += it.getIndex() + 1;
+                        numSkippedInEpochBags += it.getIndex() + 1;
+                        it.skipBlock();
+                        continue;
+                    }
+                }
+
+                NodeType *node = (*it);
+                it++;
                 assert(node);
 
                 ++numVisitedInEpochBags;
@@ -878,12 +930,30 @@ public:
                         break;
                 }
 
-                traversal_try_add(tid, node, rqResultKeys, rqResultValues, startIndex, lo, hi, false);
+                traversal_try_add_missed(tid, node, result, lo, hi);
             }
         }
 
 #endif
 
+#ifdef __HANDLE_STATS
+        GSTATS_APPEND(tid, skipped_in_bags, numSkippedInEpochBags);
+        GSTATS_APPEND(tid, visited_in_bags, numVisitedInEpochBags);
+        GSTATS_APPEND(tid, visited_in_announcements, numVisitedInAnnouncements);
+#endif
+        DEBUG_RECORD_RQ_VISITED(tid, threadData[tid].rq_lin_time, numVisitedInEpochBags);
+    }
+
+public:
+    // invoke at the end of each traversal:
+    // any nodes that were deleted during the traversal,
+    // and were consequently missed during the traversal,
+    // are placed in rqResult[index]
+    void traversal_end(const int tid, K *const rqResultKeys, V *const rqResultValues, int *const startIndex, const K &lo, const K &hi)
+    {
+        array_result_t result = {rqResultKeys, rqResultValues, startIndex};
+        traversal_add_missed(tid, result, lo, hi);
+
 #if defined MICROBENCH && !defined NDEBUG
         if (*startIndex > RQSIZE)
         {
@@ -898,14 +968,15 @@ public:
         }
 #endif
 
-#ifdef __HANDLE_STATS
-        GSTATS_APPEND(tid, skipped_in_bags, numSkippedInEpochBags);
-        GSTATS_APPEND(tid, visited_in_bags, numVisitedInEpochBags);
-        GSTATS_APPEND(tid, visited_in_announcements, numVisitedInAnnouncements);
-#endif
-        DEBUG_RECORD_RQ_VISITED(tid, threadData[tid].rq_lin_time, numVisitedInEpochBags);
         DEBUG_RECORD_RQ_SIZE(*startIndex);
         DEBUG_RECORD_RQ_CHECKSUM(tid, threadData[tid].rq_lin_time, rqResultKeys, *startIndex);
+        DEBUG_RECORD_RQ_RESULT(tid, threadData[tid].rq_lin_time, threadData[tid].rq_lin_time - 1, lo, hi, rqResultKeys, *startIndex);
+    }
+
+    // as above, but folds the keys of missed nodes into aggregate
+    void traversal_end(const int tid, RQAggregate<K> &aggregate, const K &lo, const K &hi)
+    {
+        traversal_add_missed(tid, aggregate, lo, hi);
     }
 };
 
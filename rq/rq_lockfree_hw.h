@@ -43,8 +43,11 @@ extern Random rngs[MAX_TID_POW2 * PREFETCH_SIZE_WORDS];
 #define WAIT_FOR_DTIME(node) ({ false; })
 #endif
 
+// Only the hardware clocks are meaningful here (the logical variant is
+// rq_lockfree.h), so the selectable provider rejects -ts logical at startup.
 #if not defined(TS_PROVIDER)
-#define TS_PROVIDER RdtscpTimestamp
+#define TS_PROVIDER SelectableTimestamp<RdtscpTimestamp>
+#define RQ_LOCKFREE_HW_SELECTABLE_TS
 #endif
 
 #include <pthread.h>
@@ -92,6 +95,7 @@ private:
             { // anonymous struct inside anonymous union means we don't need to type anything special to access these variables
                 long long rq_lin_time;
                 HashList<K> *hashlist;
+                blockbag<NodeType> **bags; // scratch space for traversal_end
 #ifdef COUNT_CODE_PATH_EXECUTIONS
                 long long codePathExecutions[CODE_COVERAGE_MAX_PATHS];
 #endif
@@ -139,6 +143,13 @@ private:
 public:
     RQProvider(const int numProcesses, DataStructure *ds, RecordManager *recmgr) : NUM_PROCESSES(numProcesses), ds(ds), recmgr(recmgr)
     {
+#ifdef RQ_LOCKFREE_HW_SELECTABLE_TS
+        if (ts_provider.Kind() == TIMESTAMP_LOGICAL)
+        {
+            cerr << "ERROR: rq_lockfree_hw requires a hardware timestamp (-ts rdtsc or -ts rdtscp)" << endl;
+            exit(1);
+        }
+#endif
         prov = new dcsspProvider<void *>(numProcesses);
         threadData = new __rq_thread_data[numProcesses];
         DEBUG_INIT_RQPROVIDER(numProcesses);
@@ -195,6 +206,7 @@ public:
         prov->initThread(tid);
         threadData[tid].hashlist = new HashList<K>();
         threadData[tid].hashlist->init(HASHLIST_INIT_CAPACITY_POW2);
+        threadData[tid].bags = new blockbag<NodeType> *[NUM_PROCESSES * NUMBER_OF_EPOCH_BAGS + 1];
         threadData[tid].numAnnouncements = 0;
         for (int i = 0; i < MAX_NODES_INSERTED_OR_DELETED_ATOMICALLY; ++i)
         {
@@ -220,6 +232,7 @@ public:
         prov->deinitThread(tid);
         threadData[tid].hashlist->destroy();
         delete threadData[tid].hashlist;
+        delete[] threadData[tid].bags;
 #ifdef COUNT_CODE_PATH_EXECUTIONS
         for (int i = 0; i < CODE_COVERAGE_MAX_PATHS; ++i)
         {
@@ -476,10 +489,10 @@ public:
     inline void traversal_start(const int tid)
     {
         threadData[tid].hashlist->clear();
-        threadData[tid].rq_lin_time = RQ_start(); // linearization point
+        threadData[tid].rq_lin_time = RQ_start(tid); // linearization point
     }
 
-    inline timestamp_t RQ_start() {
+    inline timestamp_t RQ_start(const int tid) {
         // need to atomically read the hardware ts and assign it as the global timestamp,
         // and set the threadData's rq_lin_time as this new value (even if another RQ increments it between
         // CAS-ing and setting it)
@@ -488,7 +501,7 @@ public:
     
         while (true) {
             long long curr_ts = timestamp;
-            long long ts = ts_provider.Advance(); // just returns what is read from rdtsc/p
+            long long ts = ts_provider.Advance(tid); // just returns what is read from rdtsc/p
             
             if (curr_ts == timestamp) {
                 res = __sync_bool_compare_and_swap(&timestamp, curr_ts, ts);
@@ -772,8 +785,6 @@ public:
     // are placed in rqResult[index]
     void traversal_end(const int tid, K *const rqResultKeys, V *const rqResultValues, int *const startIndex, const K &lo, const K &hi)
     {
-        // todo: possibly optimize by skipping entire blocks if there are many keys to skip (does not seem to be justifiable for 4 work threads and 4 range query threads)
-
         SOFTWARE_BARRIER;
         long long end_timestamp = timestamp;
         SOFTWARE_BARRIER;
@@ -859,27 +870,40 @@ public:
         SOFTWARE_BARRIER;
 
         // collect epoch bags of other processes (MUST be after checking announcements!)
-        blockbag<NodeType> *all_bags[NUM_PROCESSES * NUMBER_OF_EPOCH_BAGS + 1];
-        vector<blockbag_iterator<NodeType>> all_iterators;
-        int numIterators = 0;
+        blockbag<NodeType> **const all_bags = threadData[tid].bags;
+        int numBags = 0;
         for (int otherTid = 0; otherTid < NUM_PROCESSES; ++otherTid)
             if (otherTid != tid)
             {
-                blockbag<NodeType> *thread_bags[NUMBER_OF_EPOCH_BAGS + 1];
-                recmgr->get((NodeType *)NULL)->reclaim->getSafeBlockbags(otherTid, thread_bags);
-                for (int i = 0; thread_bags[i]; ++i)
-                {
-                    all_bags[numIterators] = thread_bags[i];
-                    all_iterators.push_back(thread_bags[i]->begin());
-                    ++numIterators;
-                }
+                // fills in the safe bags of otherTid, followed by NULL
+                recmgr->get((NodeType *)NULL)->reclaim->getSafeBlockbags(otherTid, all_bags + numBags);
+                while (all_bags[numBags])
+                    ++numBags;
             }
 
-        for (int ix = 0; ix < numIterators; ++ix)
+        for (int ix = 0; ix < numBags; ++ix)
         {
-            for (; all_iterators[ix] != all_bags[ix]->end(); all_iterators[ix]++)
+            const blockbag_iterator<NodeType> end = all_bags[ix]->end();
+            blockbag_iterator<NodeType> it = all_bags[ix]->begin();
+            block<NodeType> *summarized = NULL;
+            while (it != end)
             {
-                NodeType *node = (*all_iterators[ix]);
+                // skip blocks whose nodes were all deleted before the RQ,
+                // or all deleted after end_timestamp (see below)
+                if (it.getCurr() != summarized)
+                {
+                    summarized = it.getCurr();
+                    if (summarized->getMaxStamp() < threadData[tid].rq_lin_time || summarized->getMinStamp() > end_timestamp)
+                    {
+                        numVisitedInEpochBags += it.getIndex() + 1;
+                        numSkippedInEpochBags += it.getIndex() + 1;
+                        it.skipBlock();
+                        continue;
+                    }
+                }
+
+                NodeType *node = (*it);
+                it++;
                 assert(node);
 
                 ++numVisitedInEpochBags;
@@ -932,6 +956,7 @@ public:
         DEBUG_RECORD_RQ_VISITED(tid, threadData[tid].rq_lin_time, numVisitedInEpochBags);
         DEBUG_RECORD_RQ_SIZE(*startIndex);
         DEBUG_RECORD_RQ_CHECKSUM(tid, threadData[tid].rq_lin_time, rqResultKeys, *startIndex);
+        DEBUG_RECORD_RQ_RESULT(tid, threadData[tid].rq_lin_time, threadData[tid].rq_lin_time - 1, lo, hi, rqResultKeys, *startIndex);
     }
 };
 
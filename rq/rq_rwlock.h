@@ -17,8 +17,11 @@
 #ifndef RQ_RWLOCK_H
 #define RQ_RWLOCK_H
 
+#if not defined(TS_LOGICAL_PROVIDER)
+#define TS_LOGICAL_PROVIDER EbrTimestamp
+#endif
 #if not defined(TS_PROVIDER)
-#define TS_PROVIDER EbrTimestamp
+#define TS_PROVIDER SelectableTimestamp<TS_LOGICAL_PROVIDER>
 #endif
 
 #include "rq_debugging.h"
@@ -335,7 +338,7 @@ public:
     {
         threadData[tid].hashlist->clear();
         rwlock.writeLock();
-        threadData[tid].rq_lin_time = ts_provider.Advance(); // linearization point of range query (at the write to timestamp)
+        threadData[tid].rq_lin_time = ts_provider.Advance(tid); // linearization point of range query (at the write to timestamp)
         rwlock.writeUnlock();
 
 #ifdef DEBUG_RQ_PROVIDER_METRICS
@@ -690,6 +693,7 @@ public:
         DEBUG_RECORD_RQ_VISITED(tid, threadData[tid].rq_lin_time, numVisitedInEpochBags);
         DEBUG_RECORD_RQ_SIZE(*startIndex);
         DEBUG_RECORD_RQ_CHECKSUM(tid, threadData[tid].rq_lin_time, rqResultKeys, *startIndex);
+        DEBUG_RECORD_RQ_RESULT(tid, threadData[tid].rq_lin_time, threadData[tid].rq_lin_time - 1, lo, hi, rqResultKeys, *startIndex);
     }
 };
 
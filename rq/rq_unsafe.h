@@ -237,6 +237,7 @@ public:
     inline void traversal_end(const int tid, K * const rqResultKeys, V * const rqResultValues, int * const startIndex, const K& lo, const K& hi) {
         DEBUG_RECORD_RQ_SIZE(*startIndex);
         DEBUG_RECORD_RQ_CHECKSUM(tid, threadData[tid].rq_lin_time, rqResultKeys, *startIndex);
+        DEBUG_RECORD_RQ_RESULT(tid, threadData[tid].rq_lin_time, threadData[tid].rq_lin_time - 1, lo, hi, rqResultKeys, *startIndex);
     }
 };
 
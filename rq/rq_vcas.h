@@ -2,8 +2,10 @@
 #ifndef RQ_VCAS_H
 #define RQ_VCAS_H
 
+#include "rq_aggregate.h"
 #include "rq_debugging.h"
 #include "timestamp_provider.h"
+#include "vcas_camera.h"
 #include <pthread.h>
 #include <atomic>
 #include <unordered_set>
@@ -12,23 +14,37 @@
 #define casword_t uintptr_t
 #endif
 
+#if not defined(TS_LOGICAL_PROVIDER)
+#define TS_LOGICAL_PROVIDER BackoffTimestamp
+#endif
 #if not defined(TS_PROVIDER)
-#define TS_PROVIDER BackoffTimestamp
+#define TS_PROVIDER SelectableTimestamp<TS_LOGICAL_PROVIDER>
 #endif
 
 #define CAS(addr, expected_value, new_value) \
   __sync_bool_compare_and_swap((addr), (expected_value), (new_value))
 
+// Number of successful vCAS updates after which a thread rescans the
+// announced range query timestamps to find the oldest one it must preserve.
+#ifndef VCAS_PRUNE_REFRESH
+#define VCAS_PRUNE_REFRESH 64
+#endif
+
 #ifdef NVCAS_OPTIMIZATION
-// Encodes a vCAS object
+// Encodes a vCAS object. The timestamp is full width so that cycle-counter
+// providers (rdtsc, rdtscp) never wrap; val and ts share the first 16 bytes
+// and a version occupies 24 bytes, the same as with a 32-bit timestamp.
 template <typename T>
 struct vcas_obj_t {
   T val;
-  int ts;
+  volatile timestamp_t ts;
   vcas_obj_t<T>* nextv;
+  vcas_obj_t() {}
   vcas_obj_t(T val, vcas_obj_t<T>* nextv)
-      : val(val), nextv(nextv), ts(-1) {}  // TBD=-1
+      : val(val), ts(-1), nextv(nextv) {}  // TBD=-1
 };
+static_assert(sizeof(vcas_obj_t<void*>) == 24,
+              "a vCAS version should not grow past 24 bytes");
 #endif
 
 template <typename K, typename V, typename NodeType, typename DataStructure,
@@ -41,7 +57,9 @@ class RQProvider {
     union {
       struct {  // anonymous struct inside anonymous union means we don't need
                 // to type anything special to access these variables
-        long long rq_lin_time;
+        // oldest range query timestamp seen by this thread's last scan
+        timestamp_t prune_ts;
+        int prune_countdown;
       };
       char bytes[__RQ_THREAD_DATA_SIZE];  // avoid false sharing
     };
@@ -57,18 +75,17 @@ class RQProvider {
 
   DataStructure* ds;
   RecordManager* const recmgr;
-  TS_PROVIDER ts_provider;
+  // labels versions and tracks the snapshots of active range queries
+  Camera<TS_PROVIDER> camera_;
 
   int init[MAX_TID_POW2] = {
       0,
   };
 
-  // Camera S;
-
   template <class T>
   inline void initTS(T node) {
     if (node->ts == TBD) {
-      long long curTS = ts_provider.Read();
+      long long curTS = camera_.Read();
       CAS(&(node->ts), TBD, curTS);
     }
   }
@@ -80,12 +97,80 @@ class RQProvider {
     }
   }
 
+  // Returns a timestamp no newer than that of any range query that is active
+  // or starts later.
+  inline timestamp_t get_oldest_active_rq() { return camera_.oldestActive(); }
+
+#ifdef NVCAS_OPTIMIZATION
+  // A stale result is still safe to prune with, since it can only be older
+  // than the true oldest active range query, so the scan is amortized.
+  inline timestamp_t get_prune_ts(const int tid) {
+    if (--threadData[tid].prune_countdown <= 0) {
+      threadData[tid].prune_ts = get_oldest_active_rq();
+      threadData[tid].prune_countdown = VCAS_PRUNE_REFRESH;
+    }
+    return threadData[tid].prune_ts;
+  }
+
+  // Cuts the version list below the newest version visible at the oldest
+  // active range query's timestamp, and retires the versions that were cut.
+  // Pruners may race on the same list, so each version is retired by the
+  // thread whose CAS nulled the link into it.
+  template <typename T>
+  inline void prune_versions(const int tid, vcas_obj_t<T>* const head) {
+    const timestamp_t prune_ts = get_prune_ts(tid);
+    vcas_obj_t<T>* keep = head;
+    while (keep != nullptr && (keep->ts == TBD || keep->ts > prune_ts)) {
+      keep = keep->nextv;
+    }
+    if (keep == nullptr) return;
+    vcas_obj_t<T>* cut = keep->nextv;
+    if (cut == nullptr || !CAS(&keep->nextv, cut, nullptr)) return;
+    while (cut != nullptr) {
+      vcas_obj_t<T>* next = cut->nextv;
+      if (next != nullptr && !CAS(&cut->nextv, next, nullptr)) next = nullptr;
+      recmgr->retire(tid, cut);
+      cut = next;
+    }
+  }
+#endif
+
+#if defined USE_RQ_DEBUGGING
+  // vCAS data structures read the keys of a node as of a timestamp, so the
+  // generic DEBUG_RECORD_UPDATE_CHECKSUM cannot be used.
+  inline void debug_record_update(const int tid, const long long ts,
+                                  NodeType* const* const insertedNodes,
+                                  NodeType* const* const deletedNodes) {
+    K keys[RQ_DEBUGGING_MAX_KEYS_PER_NODE];
+    V values[RQ_DEBUGGING_MAX_KEYS_PER_NODE];
+    // the nodes are read as a snapshot taken at the update would see them
+    const camera_snapshot_t at_update = {ts};
+    for (int i = 0; insertedNodes[i]; ++i) {
+      const int cnt =
+          ds->getKeys(tid, insertedNodes[i], keys, values, at_update);
+      for (int j = 0; j < cnt; ++j) DEBUG_RECORD_UPDATE_KEY(tid, ts, keys[j], 1);
+    }
+    for (int i = 0; deletedNodes[i]; ++i) {
+      const int cnt =
+          ds->getKeys(tid, deletedNodes[i], keys, values, at_update);
+      for (int j = 0; j < cnt; ++j) DEBUG_RECORD_UPDATE_KEY(tid, ts, keys[j], -1);
+    }
+  }
+#endif
+
  public:
   static const int TBD = -1;
 
   RQProvider(const int numProcesses, DataStructure* ds, RecordManager* recmgr)
-      : NUM_PROCESSES(numProcesses), ds(ds), recmgr(recmgr) {
+      : NUM_PROCESSES(numProcesses),
+        ds(ds),
+        recmgr(recmgr),
+        camera_(numProcesses) {
     threadData = new __rq_thread_data[numProcesses];
+    for (int i = 0; i < numProcesses; ++i) {
+      threadData[i].prune_ts = TIMESTAMP_NOT_SET;
+      threadData[i].prune_countdown = 0;
+    }
     DEBUG_INIT_RQPROVIDER(numProcesses);
   }
 
@@ -118,6 +203,15 @@ class RQProvider {
   // invoke whenever a new node is created/initialized
   inline void init_node(const int tid, NodeType* const node) {}
 
+  // allocates a vCAS object from the data structure's record manager, which
+  // must therefore manage vcas_obj_t<T>; it is later retired by pruning
+  template <typename T>
+  inline vcas_obj_t<T>* new_vcas(const int tid, const T& val,
+                                 vcas_obj_t<T>* const nextv) {
+    vcas_obj_t<T>* const obj = recmgr->template allocate<vcas_obj_t<T> >(tid);
+    return new (obj) vcas_obj_t<T>(val, nextv);
+  }
+
   // for each address addr that is modified by rq_linearize_update_at_write
   // or rq_linearize_update_at_cas, you must replace any initialization of addr
   // with invocations of rq_write_addr
@@ -150,33 +244,9 @@ class RQProvider {
   // invocations of rq_read_addr
   template <typename T>
   inline T read_vcas(const int tid, vcas_obj_t<T> volatile* const vcas_obj,
-                     const int ts) {
-    vcas_obj_t<T> volatile* head = vcas_obj;
-    initTS(head);
-    while (head != nullptr && head->ts > ts) {
-#if defined(VCAS_STATS)
-      versionNodesTraversed[tid * PADDING]++;
-      // if(nodesSeen.find(head) == nodesSeen.end())
-      {
-        // nodesSeen.insert(head);
-        distinctNodesVisited[tid * PADDING]++;
-      }
-#endif
-      // count++;
-      // std::cout << "ts: " << ts << ", node ts: " << head->ts << ", count: "
-      // << count << endl;
-      head = head->nextv;
-    }
-#if defined(VCAS_STATS)
-    if (head != NULL) {
-      // if(nodesSeen.find(head) == nodesSeen.end())
-      {
-        // nodesSeen.insert(head);
-        // distinctNodesVisited[tid*PADDING]++;
-      }
-    }
-#endif
-    // if(head != NULL) assert(head->ts != TBD);
+                     const camera_snapshot_t& snapshot) {
+    initTS(vcas_obj);
+    vcas_obj_t<T> volatile* head = camera_.readVersion(vcas_obj, snapshot);
     assert(head != nullptr);
     return head->val;
   }
@@ -200,10 +270,23 @@ class RQProvider {
                                           NodeType* const* const deletedNodes) {
     int i;
     for (i = 0; deletedNodes[i]; ++i) {
+      ds->retireVersions(tid, deletedNodes[i]);
       recmgr->retire(tid, deletedNodes[i]);
     }
   }
 
+  // retires every version of a vCAS object that belongs to a node being
+  // retired; no update can still modify it
+  template <typename T>
+  inline void retire_vcas(const int tid, vcas_obj_t<T>* const vcas_obj) {
+    vcas_obj_t<T>* curr = vcas_obj;
+    while (curr != nullptr) {
+      vcas_obj_t<T>* const next = curr->nextv;
+      recmgr->retire(tid, curr);
+      curr = next;
+    }
+  }
+
   // replace the linearization point of an update that inserts or deletes nodes
   // with an invocation of this function if the linearization point is a WRITE
   template <typename T>
@@ -226,8 +309,8 @@ class RQProvider {
     }
 
 #if defined USE_RQ_DEBUGGING
-    DEBUG_RECORD_UPDATE_CHECKSUM<K, V>(tid, ts, insertedNodes, deletedNodes,
-                                       ds);
+    const long long ts = (*lin_addr)->ts;
+    debug_record_update(tid, ts, insertedNodes, deletedNodes);
 #endif
     return lin_newval;
   }
@@ -245,12 +328,13 @@ class RQProvider {
     else if (lin_newval == lin_oldval)
       res = true;
     else {
-      vcas_obj_t<T>* new_head = new vcas_obj_t<T>(lin_newval, head);
+      vcas_obj_t<T>* new_head = new_vcas(tid, lin_newval, head);
       res = CAS(lin_vcas_obj, head, new_head);
       if (res) {
         initTS(new_head);
+        prune_versions(tid, new_head);
       } else {
-        delete new_head;
+        recmgr->deallocate(tid, new_head);
         initTS(*lin_vcas_obj);
       }
     }
@@ -271,7 +355,7 @@ class RQProvider {
       announce_physical_deletion(tid, deletedNodes);
     }
 
-    long long ts = 1;
+    long long ts = TBD;
     bool res;
     vcas_obj_t<T>* head = *(lin_vcas_obj);
     initTS(head);
@@ -280,12 +364,14 @@ class RQProvider {
     else if (lin_newval == lin_oldval)
       res = true;
     else {
-      vcas_obj_t<T>* new_head = new vcas_obj_t<T>(lin_newval, head);
+      vcas_obj_t<T>* new_head = new_vcas(tid, lin_newval, head);
       res = CAS(lin_vcas_obj, head, new_head);
       if (res) {
         initTS(new_head);
+        ts = new_head->ts;
+        prune_versions(tid, new_head);
       } else {
-        delete new_head;
+        recmgr->deallocate(tid, new_head);
         initTS(*lin_vcas_obj);
       }
     }
@@ -295,6 +381,11 @@ class RQProvider {
         // physical deletion will happen at the same time as logical deletion
         physical_deletion_succeeded(tid, deletedNodes);
       }
+#if defined USE_RQ_DEBUGGING
+      if (ts != TBD) {
+        debug_record_update(tid, ts, insertedNodes, deletedNodes);
+      }
+#endif
     } else {
       if (!logicalDeletion) {
         // physical deletion will happen at the same time as logical deletion
@@ -305,9 +396,11 @@ class RQProvider {
     return NULL;
   }
 
-  // invoke at the start of each traversal
-  inline int traversal_start(const int tid) {
-    return ts_provider.Advance();
+  // invoke at the start of each traversal. the traversal reads versions
+  // through the returned snapshot and hands it back to traversal_end, which
+  // releases it; until then, the versions it can see are not pruned.
+  inline camera_snapshot_t traversal_start(const int tid) {
+    return camera_.takeSnapshot(tid);
   }
 
   // invoke each time a traversal visits a node with a key in the desired range:
@@ -316,10 +409,10 @@ class RQProvider {
   inline void traversal_try_add(const int tid, NodeType* const node,
                                 K* const rqResultKeys, V* const rqResultValues,
                                 int* const startIndex, const K& lo, const K& hi,
-                                const int ts) {
+                                const camera_snapshot_t& snapshot) {
     int start = (*startIndex);
     int keysInNode = ds->getKeys(tid, node, rqResultKeys + start,
-                                 rqResultValues + start, ts);
+                                 rqResultValues + start, snapshot);
     assert(keysInNode < RQ_DEBUGGING_MAX_KEYS_PER_NODE);
     if (keysInNode == 0) return;
     int location = start;
@@ -336,6 +429,19 @@ class RQProvider {
 #endif
   }
 
+  // as above, but folds the node's keys into aggregate (see rq_aggregate.h)
+  inline void traversal_try_add(const int tid, NodeType* const node,
+                                RQAggregate<K>& aggregate, const K& lo,
+                                const K& hi,
+                                const camera_snapshot_t& snapshot) {
+    K keys[RQ_DEBUGGING_MAX_KEYS_PER_NODE];
+    V values[RQ_DEBUGGING_MAX_KEYS_PER_NODE];
+    int keysInNode = ds->getKeys(tid, node, keys, values, snapshot);
+    assert(keysInNode < RQ_DEBUGGING_MAX_KEYS_PER_NODE);
+    if (keysInNode == 0) return;
+    aggregate.addMasked(keys, rq_range_mask(ds, keys, keysInNode, lo, hi));
+  }
+
 #else
   // invoke whenever a new node is created/initialized
   inline void init_node(const int tid, NodeType* const node) {
@@ -368,37 +474,12 @@ class RQProvider {
   // or rq_linearize_update_at_cas, you must replace any reads of addr with
   // invocations of rq_read_addr
   template <typename T>
-  inline T read_addr(const int tid, T volatile* const addr, const int ts) {
+  inline T read_addr(const int tid, T volatile* const addr,
+                     const camera_snapshot_t& snapshot) {
     T head = *addr;
-    // if(head != NULL)
-    //     std::cout << "ts: " << ts << ", node ts: " << head->ts << endl;
-    if (head != NULL) initTS(head);
-    // int count = 0;
-    while (head != NULL && head->ts > ts) {
-#if defined(VCAS_STATS)
-      versionNodesTraversed[tid * PADDING]++;
-      // if(nodesSeen.find(head) == nodesSeen.end())
-      {
-        // nodesSeen.insert(head);
-        distinctNodesVisited[tid * PADDING]++;
-      }
-#endif
-      // count++;
-      // std::cout << "ts: " << ts << ", node ts: " << head->ts << ", count: "
-      // << count << endl;
-      head = head->nextv;
-    }
-#if defined(VCAS_STATS)
-    if (head != NULL) {
-      // if(nodesSeen.find(head) == nodesSeen.end())
-      {
-        // nodesSeen.insert(head);
-        // distinctNodesVisited[tid*PADDING]++;
-      }
-    }
-#endif
-    // if(head != NULL) assert(head->ts != TBD);
-    return head;
+    if (head == NULL) return head;
+    initTS(head);
+    return camera_.readVersion(head, snapshot);
   }
 
   // IF DATA STRUCTURE PERFORMS LOGICAL DELETION
@@ -444,8 +525,8 @@ class RQProvider {
     }
 
 #if defined USE_RQ_DEBUGGING
-    DEBUG_RECORD_UPDATE_CHECKSUM<K, V>(tid, ts, insertedNodes, deletedNodes,
-                                       ds);
+    const long long ts = (lin_newval != NULL) ? lin_newval->ts : 0;
+    debug_record_update(tid, ts, insertedNodes, deletedNodes);
 #endif
     return lin_newval;
   }
@@ -462,7 +543,7 @@ class RQProvider {
       announce_physical_deletion(tid, deletedNodes);
     }
 
-    long long ts = 1;
+    long long ts = TBD;
     bool res;
     T head = *lin_addr;
     if (head != NULL) initTS(head);
@@ -475,6 +556,7 @@ class RQProvider {
       res = CAS(lin_addr, lin_oldval, lin_newval);
       if (res) {
         initTS(lin_newval);
+        ts = lin_newval->ts;
       } else {
         initTS(*lin_addr);
       }
@@ -485,6 +567,11 @@ class RQProvider {
         // physical deletion will happen at the same time as logical deletion
         physical_deletion_succeeded(tid, deletedNodes);
       }
+#if defined USE_RQ_DEBUGGING
+      if (ts != TBD) {
+        debug_record_update(tid, ts, insertedNodes, deletedNodes);
+      }
+#endif
     } else {
       if (!logicalDeletion) {
         // physical deletion will happen at the same time as logical deletion
@@ -495,9 +582,11 @@ class RQProvider {
     return NULL;
   }
 
-  // invoke at the start of each traversal
-  inline int traversal_start(const int tid) {
-    return ts_provider.Advance();
+  // invoke at the start of each traversal. the traversal reads versions
+  // through the returned snapshot and hands it back to traversal_end, which
+  // releases it; until then, the versions it can see are not pruned.
+  inline camera_snapshot_t traversal_start(const int tid) {
+    return camera_.takeSnapshot(tid);
   }
 
   // invoke each time a traversal visits a node with a key in the desired range:
@@ -506,10 +595,10 @@ class RQProvider {
   inline void traversal_try_add(const int tid, NodeType* const node,
                                 K* const rqResultKeys, V* const rqResultValues,
                                 int* const startIndex, const K& lo, const K& hi,
-                                const int ts) {
+                                const camera_snapshot_t& snapshot) {
     int start = (*startIndex);
     int keysInNode = ds->getKeys(tid, node, rqResultKeys + start,
-                                 rqResultValues + start, ts);
+                                 rqResultValues + start, snapshot);
     assert(keysInNode < RQ_DEBUGGING_MAX_KEYS_PER_NODE);
     if (keysInNode == 0) return;
     int location = start;
@@ -525,19 +614,41 @@ class RQProvider {
     assert(*startIndex <= RQSIZE);
 #endif
   }
+
+  // as above, but folds the node's keys into aggregate (see rq_aggregate.h)
+  inline void traversal_try_add(const int tid, NodeType* const node,
+                                RQAggregate<K>& aggregate, const K& lo,
+                                const K& hi,
+                                const camera_snapshot_t& snapshot) {
+    K keys[RQ_DEBUGGING_MAX_KEYS_PER_NODE];
+    V values[RQ_DEBUGGING_MAX_KEYS_PER_NODE];
+    int keysInNode = ds->getKeys(tid, node, keys, values, snapshot);
+    assert(keysInNode < RQ_DEBUGGING_MAX_KEYS_PER_NODE);
+    if (keysInNode == 0) return;
+    aggregate.addMasked(keys, rq_range_mask(ds, keys, keysInNode, lo, hi));
+  }
 #endif
 
   // invoke at the end of each traversal:
   // any nodes that were deleted during the traversal,
   // and were consequently missed during the traversal,
   // are placed in rqResult[index]
-  inline void traversal_end(const int tid, K* const rqResultKeys,
-                            V* const rqResultValues, int* const startIndex,
-                            const K& lo, const K& hi) {
+  inline void traversal_end(const int tid, const camera_snapshot_t& snapshot,
+                            K* const rqResultKeys, V* const rqResultValues,
+                            int* const startIndex, const K& lo, const K& hi) {
     // cout << versionNodesTraversed << endl;
     DEBUG_RECORD_RQ_SIZE(*startIndex);
-    DEBUG_RECORD_RQ_CHECKSUM(tid, threadData[tid].rq_lin_time, rqResultKeys,
-                             *startIndex);
+    DEBUG_RECORD_RQ_CHECKSUM(tid, snapshot.ts, rqResultKeys, *startIndex);
+    // versions with ts <= snapshot.ts are visible
+    DEBUG_RECORD_RQ_RESULT(tid, snapshot.ts + 1, snapshot.ts, lo, hi,
+                           rqResultKeys, *startIndex);
+    camera_.releaseSnapshot(tid, snapshot);
+  }
+
+  // ends a traversal whose keys were streamed to a visitor (see rq_cursor.h)
+  // or folded into an aggregate (see rq_aggregate.h) instead of being collected
+  inline void traversal_end(const int tid, const camera_snapshot_t& snapshot) {
+    camera_.releaseSnapshot(tid, snapshot);
   }
 };
 
@@ -5,26 +5,76 @@
 // Timestamp provider
 // Timestamp interface for atomic global timestamping (Bundling, Vcas), RDTSC and RDTSCP
 // implementations of various data structures
+//
+// Each provider is a policy class exposing Read(), Advance(tid) and Snapshot().
+// Read() returns the current time, Advance(tid) moves the clock forward on behalf
+// of thread tid, and Snapshot() is what a range query linearizes at when the clock
+// is advanced by updates (rq_bundle); it is a plain Read() except for clocks that
+// must be closed by readers (LeasedTimestamp). The RQ providers
+// hold their provider by value (TS_PROVIDER), so calls are resolved statically and
+// inlined. SelectableTimestamp wraps one logical policy together with both hardware
+// policies and picks the clock once at startup (see timestamp_select()), which
+// lets a single binary run with any clock.
 
 #pragma once
 
 #include <atomic>
+#include <cstring>
+#include <stdint.h>
+#include "plaf.h"
+#include "tsc_calibration.h"
+#include "tsc_skew.h"
 #define MIN_TIMESTAMP 1LL
 
 typedef long long timestamp_t;
 
-// for the BackoffTimestamp
-static thread_local int backoff_amt = 0;
 
-class TimestampProvider {
-    public:
-        virtual inline timestamp_t Read() = 0;
-        virtual inline timestamp_t Advance() = 0;
+enum timestamp_kind_t {
+    TIMESTAMP_LOGICAL,
+    TIMESTAMP_RDTSC,
+    TIMESTAMP_RDTSCP,
+    TIMESTAMP_RDTSCP_SKEW
 };
 
-class RdtscTimestamp: public TimestampProvider {
-    private:
-        inline timestamp_t readRdtsc() {
+// The clock used by every SelectableTimestamp constructed after this is set.
+// Function-local static so the header can be included in several translation units.
+inline timestamp_kind_t &timestamp_selected_kind() {
+    static timestamp_kind_t kind = TIMESTAMP_LOGICAL;
+    return kind;
+}
+
+inline const char *timestamp_kind_name(const timestamp_kind_t kind) {
+    switch (kind) {
+        case TIMESTAMP_RDTSC: return "rdtsc";
+        case TIMESTAMP_RDTSCP: return "rdtscp";
+        case TIMESTAMP_RDTSCP_SKEW: return "rdtscp_skew";
+        default: return "logical";
+    }
+}
+
+// Parses a clock name ("logical" or "ts", "rdtsc", "rdtscp", "rdtscp_skew") and selects it.
+// Returns false if the name is not recognized. Must be called before the data
+// structure (and therefore its RQProvider) is constructed.
+inline bool timestamp_select(const char *name) {
+    if (strcmp(name, "logical") == 0 || strcmp(name, "ts") == 0) {
+        timestamp_selected_kind() = TIMESTAMP_LOGICAL;
+    } else if (strcmp(name, "rdtsc") == 0) {
+        timestamp_selected_kind() = TIMESTAMP_RDTSC;
+    } else if (strcmp(name, "rdtscp") == 0) {
+        timestamp_selected_kind() = TIMESTAMP_RDTSCP;
+    } else if (strcmp(name, "rdtscp_skew") == 0) {
+        timestamp_selected_kind() = TIMESTAMP_RDTSCP_SKEW;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// The hardware providers exit at construction if the TSC is not invariant
+// (see tsc_require_safe()), since their timestamps would not be comparable.
+class RdtscTimestamp {
+    public:
+        static inline timestamp_t readRdtsc() {
             unsigned long long cycles_low, cycles_high;
             asm volatile (
                 "CPUID\n\t" // waits for previous code to finish executing 
@@ -34,20 +84,27 @@ class RdtscTimestamp: public TimestampProvider {
                 "%rax", "%rdx", "%rbx", "%rcx");
             return (((uint64_t)cycles_high << 32) | cycles_low);
         }
-    
-    public:
+
+        RdtscTimestamp() {
+            tsc_require_safe("RdtscTimestamp", false);
+        }
+
         inline timestamp_t Read() {
             return readRdtsc();
         }
 
-        inline timestamp_t Advance() {
+        inline timestamp_t Advance(const int tid) {
             return readRdtsc();
         }
+
+        inline timestamp_t Snapshot() {
+            return Read();
+        }
 };
 
-class RdtscpTimestamp: public TimestampProvider {
-    private:
-        inline timestamp_t readRdtscp() {
+class RdtscpTimestamp {
+    public:
+        static inline timestamp_t readRdtscp() {
             unsigned long long cycles_low, cycles_high;
             asm volatile (
                 "RDTSCP\n\t"
@@ -58,41 +115,207 @@ class RdtscpTimestamp: public TimestampProvider {
                 );
             return (((uint64_t)cycles_high << 32) | cycles_low);
         }
-    
-    public:
+
+        RdtscpTimestamp() {
+            tsc_require_safe("RdtscpTimestamp", true);
+        }
+
         inline timestamp_t Read() {
             return readRdtscp();
         }
 
-        inline timestamp_t Advance() {
+        inline timestamp_t Advance(const int tid) {
             return readRdtscp();
         }
+
+        inline timestamp_t Snapshot() {
+            return Read();
+        }
 };
 
-// used for vCAS
-class BackoffTimestamp: public TimestampProvider {
+// RDTSCP made safe under cross-core TSC skew. With epsilon a strict bound on the
+// skew between any two cores (see tsc_skew.h):
+//  - Read() (range queries) returns now - epsilon, so any update that takes its
+//    timestamp after the read, on any core, gets a larger timestamp;
+//  - Advance() (updates) returns now, but first waits until the local TSC has
+//    moved 2 * epsilon past it, so any range query that starts after the update
+//    returns reads a timestamp that is not smaller.
+// The skew probe runs once, the first time one of these is constructed.
+class SkewBoundedRdtscpTimestamp {
     private:
-        volatile timestamp_t curr_timestamp;
+        const timestamp_t epsilon_;
+
+    public:
+        SkewBoundedRdtscpTimestamp() : epsilon_(Epsilon()) {}
 
-        inline void backoff(int amount) {
-            if (amount == 0) return;
+        static timestamp_t Epsilon() {
+            tsc_require_safe("SkewBoundedRdtscpTimestamp", true);
+            return tsc_skew().epsilon;
+        }
+
+        static inline timestamp_t read(const timestamp_t epsilon) {
+            return RdtscpTimestamp::readRdtscp() - epsilon;
+        }
+
+        static inline timestamp_t advance(const timestamp_t epsilon) {
+            const timestamp_t ts = RdtscpTimestamp::readRdtscp();
+            while (RdtscpTimestamp::readRdtscp() - ts < 2 * epsilon) {}
+            return ts;
+        }
+
+        inline timestamp_t Read() {
+            return read(epsilon_);
+        }
+
+        inline timestamp_t Advance(const int tid) {
+            return advance(epsilon_);
+        }
+
+        inline timestamp_t Snapshot() {
+            return Read();
+        }
+};
+
+// The contention counters are only recorded when the including program has
+// set up GSTATS (see microbench/globals.h) or the macrobench statistics (see
+// macrobench/system/helper.h) before including this header. The macrobench
+// only keeps totals, not the history of backoff amounts.
+#ifdef GSTATS_ADD
+#define TS_STATS_ADD(tid, stat, val) GSTATS_ADD(tid, stat, val)
+#define TS_STATS_APPEND(tid, stat, val) GSTATS_APPEND(tid, stat, val)
+#elif defined INC_STATS_IF_READY
+#define TS_STATS_ADD(tid, stat, val) INC_STATS_IF_READY(tid, stat, val)
+#define TS_STATS_APPEND(tid, stat, val)
+#else
+#define TS_STATS_ADD(tid, stat, val)
+#define TS_STATS_APPEND(tid, stat, val)
+#endif
+
+#ifndef TS_BACKOFF_MIN
+#define TS_BACKOFF_MIN 1
+#endif
+#ifndef TS_BACKOFF_MAX
+#define TS_BACKOFF_MAX 512         // the cap of the original per-clock backoff
+#endif
+#ifndef TS_BACKOFF_WINDOW
+#define TS_BACKOFF_WINDOW 64        // calls between two adaptations
+#endif
+
+// Adaptive backoff for the logical clocks that increment one shared counter.
+// Each clock owns one of these, with a padded slot per thread, so neither
+// different clocks (e.g., the indexes of one macrobench run) nor different
+// threads share contention state.
+//
+// A call either skips the fetch_add, because another thread advanced the clock
+// during the backoff, or performs it, and then may lose the race (someone else
+// incremented after we read). Every TS_BACKOFF_WINDOW calls, a thread looks at
+// these counts and at the average cycles a call took, backoff included:
+//  - more than 1/4 of the fetch_adds lost: the counter is hot, double the
+//    backoff;
+//  - less than 1/16 of the calls lost or skipped: contention is low, halve it
+//    (a skipped call was served by another thread's increment, which is what
+//    the backoff is for, so it is no reason to shorten it);
+//  - in between: keep moving in the last direction while the average latency
+//    improves, and reverse direction once it gets worse.
+class TimestampBackoff {
+    private:
+        union slot_t {
+            struct {
+                int amount;         // iterations of the backoff loop
+                int direction;      // +1 or -1, last change in the middle band
+                int calls;          // in the current window
+                int skipped;        // in the current window
+                int lost;           // in the current window
+                uint64_t cycles;    // in the current window
+                uint64_t lastAverage;
+            } data;
+            volatile char bytes[PREFETCH_SIZE_BYTES];
+        } __attribute__((aligned(BYTES_IN_CACHE_LINE)));
+
+        slot_t slots_[MAX_TID_POW2];
+
+        inline void adapt(const int tid, slot_t &slot) {
+            const int calls = slot.data.calls;
+            const int skipped = slot.data.skipped;
+            const int lost = slot.data.lost;
+            const uint64_t average = slot.data.cycles / calls;
+            int amount = slot.data.amount;
+            if (lost * 4 > calls - skipped) {
+                amount *= 2;
+            } else if ((lost + skipped) * 16 < calls) {
+                amount /= 2;
+            } else {
+                if (slot.data.lastAverage && average > slot.data.lastAverage) {
+                    slot.data.direction = -slot.data.direction;
+                }
+                amount = (slot.data.direction > 0) ? amount + amount / 2 + 1 : amount - amount / 4;
+            }
+            if (amount < TS_BACKOFF_MIN) amount = TS_BACKOFF_MIN;
+            if (amount > TS_BACKOFF_MAX) amount = TS_BACKOFF_MAX;
+            slot.data.amount = amount;
+            slot.data.lastAverage = average;
+            slot.data.calls = 0;
+            slot.data.skipped = 0;
+            slot.data.lost = 0;
+            slot.data.cycles = 0;
+            TS_STATS_ADD(tid, timestamp_calls, calls);
+            TS_STATS_ADD(tid, timestamp_cas_skipped, skipped);
+            TS_STATS_ADD(tid, timestamp_cas_lost, lost);
+            TS_STATS_APPEND(tid, timestamp_backoff, amount);
+        }
+
+    public:
+        TimestampBackoff() {
+            for (int i = 0; i < MAX_TID_POW2; ++i) {
+                slots_[i].data.amount = TS_BACKOFF_MIN;
+                slots_[i].data.direction = 1;
+                slots_[i].data.calls = 0;
+                slots_[i].data.skipped = 0;
+                slots_[i].data.lost = 0;
+                slots_[i].data.cycles = 0;
+                slots_[i].data.lastAverage = 0;
+            }
+        }
+
+        inline uint64_t begin(const int tid) {
+            const int amount = slots_[tid].data.amount;
+            const uint64_t start = __rdtsc();
             volatile long long sum = 0;
-            int limit = amount;
-            for (int i = 0; i < limit; i++) sum += i;
+            for (int i = 0; i < amount; i++) sum += i;
+            return start;
+        }
+
+        // skipped: the clock advanced during the backoff, so no increment was
+        // attempted. lost: the increment was attempted and another thread's
+        // got there first
+        inline void end(const int tid, const uint64_t start, const bool skipped,
+                        const bool lost) {
+            slot_t &slot = slots_[tid];
+            slot.data.cycles += __rdtsc() - start;
+            slot.data.skipped += skipped;
+            slot.data.lost += lost;
+            if (++slot.data.calls == TS_BACKOFF_WINDOW) adapt(tid, slot);
         }
+};
 
-        inline timestamp_t getNextTS() {
+// used for vCAS
+class BackoffTimestamp {
+    private:
+        volatile char padding0[PREFETCH_SIZE_BYTES];
+        volatile timestamp_t curr_timestamp;
+        volatile char padding1[PREFETCH_SIZE_BYTES];
+        TimestampBackoff backoff_;
+
+        inline timestamp_t getNextTS(const int tid) {
             timestamp_t ts = curr_timestamp;
-            backoff(backoff_amt);
+            const uint64_t start = backoff_.begin(tid);
             std::atomic_thread_fence(std::memory_order_seq_cst);
-            if (ts == curr_timestamp) {
-                if (__sync_fetch_and_add(&curr_timestamp, 1) == ts)
-                    backoff_amt /= 2;
-                else
-                    backoff_amt *= 2;
+            const bool skipped = (ts != curr_timestamp);
+            bool lost = false;
+            if (!skipped) {
+                lost = (__sync_fetch_and_add(&curr_timestamp, 1) != ts);
             }
-            if (backoff_amt < 1) backoff_amt = 1;
-            if (backoff_amt > 512) backoff_amt = 512;
+            backoff_.end(tid, start, skipped, lost);
             return ts;
         }
 
@@ -105,34 +328,33 @@ class BackoffTimestamp: public TimestampProvider {
             return curr_timestamp;
         }
 
-        inline timestamp_t Advance() {
-            return getNextTS();
+        inline timestamp_t Advance(const int tid) {
+            return getNextTS(tid);
+        }
+
+        inline timestamp_t Snapshot() {
+            return Read();
         }
 };
 
 // used for bundling
-class BundlingTimestamp: public TimestampProvider {
+class BundlingTimestamp {
     private:
+        volatile char padding0[PREFETCH_SIZE_BYTES];
         std::atomic<timestamp_t> curr_timestamp_;
+        volatile char padding1[PREFETCH_SIZE_BYTES];
+        TimestampBackoff backoff_;
 
-        inline void backoff(int amount) {
-            if (amount == 0) return;
-            volatile long long sum = 0;
-            int limit = amount;
-            for (int i = 0; i < limit; i++) sum += i;
-        }
-
-        inline timestamp_t getNextTS() {
+        inline timestamp_t getNextTS(const int tid) {
             timestamp_t ts = curr_timestamp_.load(std::memory_order_seq_cst);
-            backoff(backoff_amt);
-            if (ts == curr_timestamp_.load(std::memory_order_seq_cst)) {
-                if (curr_timestamp_.fetch_add(1, std::memory_order_release) == ts)
-                backoff_amt /= 2;
-                else
-                    backoff_amt *= 2;
+            const uint64_t start = backoff_.begin(tid);
+            const bool skipped =
+                    (ts != curr_timestamp_.load(std::memory_order_seq_cst));
+            bool lost = false;
+            if (!skipped) {
+                lost = (curr_timestamp_.fetch_add(1, std::memory_order_release) != ts);
             }
-            if (backoff_amt < 1) backoff_amt = 1;
-            if (backoff_amt > 512) backoff_amt = 512;
+            backoff_.end(tid, start, skipped, lost);
             return ts + 1;
         }
 
@@ -145,13 +367,17 @@ class BundlingTimestamp: public TimestampProvider {
             return curr_timestamp_.load();
         }
 
-        inline timestamp_t Advance() {
-            return getNextTS();
+        inline timestamp_t Advance(const int tid) {
+            return getNextTS(tid);
+        }
+
+        inline timestamp_t Snapshot() {
+            return Read();
         }
 };
 
 // lock-based implementation of ebr timestamp
-class EbrTimestamp: public TimestampProvider {
+class EbrTimestamp {
     private:
         volatile long long timestamp;
 
@@ -164,7 +390,139 @@ class EbrTimestamp: public TimestampProvider {
             return timestamp;
         }
 
-        inline timestamp_t Advance() {
+        inline timestamp_t Advance(const int tid) {
             return ++timestamp;
         }
-};
\ No newline at end of file
+
+        inline timestamp_t Snapshot() {
+            return Read();
+        }
+};
+
+#ifndef LEASED_TS_BLOCK_SIZE
+#define LEASED_TS_BLOCK_SIZE 64     // timestamps leased by a thread at a time
+#endif
+#ifndef LEASED_TS_OFFSET_BITS
+#define LEASED_TS_OFFSET_BITS 24    // timestamps per epoch: 2^LEASED_TS_OFFSET_BITS
+#endif
+
+// Logical clock for update-driven techniques (rq_bundle) in which updates do
+// not write a shared cache line. A timestamp is (epoch << LEASED_TS_OFFSET_BITS)
+// + offset. Each thread leases LEASED_TS_BLOCK_SIZE consecutive timestamps of
+// the current epoch with one fetch_add (in the spirit of TS_BATCH_ALLOC in
+// macrobench/system/manager.cpp) and then hands them out locally, until the
+// block runs out or the epoch changes.
+//
+// Range queries close the current epoch (Snapshot()) and linearize at its last
+// timestamp. Since every range query time is an epoch boundary, the order of
+// timestamps within an epoch is irrelevant: an update that read the epoch before
+// it was closed gets a timestamp <= the range query's (and, as its bundle entries
+// were already pending, the range query waits for it), and an update that reads
+// it afterwards gets a larger one. Running out of offsets just carries into the
+// next epoch, which closes it early.
+class LeasedTimestamp {
+    private:
+        union slot_t {
+            struct {
+                timestamp_t next;   // next timestamp to hand out
+                timestamp_t end;    // end of the leased block (exclusive)
+            } data;
+            volatile char bytes[PREFETCH_SIZE_BYTES];
+        } __attribute__((aligned(BYTES_IN_CACHE_LINE)));
+
+        static const timestamp_t EPOCH = 1LL << LEASED_TS_OFFSET_BITS;
+
+        volatile char padding0[PREFETCH_SIZE_BYTES];
+        std::atomic<timestamp_t> curr_;     // epoch and next free offset
+        volatile char padding1[PREFETCH_SIZE_BYTES];
+        slot_t slots_[MAX_TID_POW2];
+
+        static inline timestamp_t epochOf(const timestamp_t ts) {
+            return ts & ~(EPOCH - 1);
+        }
+
+    public:
+        LeasedTimestamp() {
+            curr_ = EPOCH;
+            for (int i = 0; i < MAX_TID_POW2; ++i) {
+                slots_[i].data.next = 0;
+                slots_[i].data.end = 0;
+            }
+        }
+
+        // Last timestamp of the most recently closed epoch: no future range
+        // query linearizes before it.
+        inline timestamp_t Read() {
+            return epochOf(curr_.load(std::memory_order_acquire)) - 1;
+        }
+
+        inline timestamp_t Advance(const int tid) {
+            slot_t &slot = slots_[tid];
+            // order the caller's pending bundle entries before the epoch read
+            // (a fetch_add used to do this implicitly)
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            const timestamp_t epoch = epochOf(curr_.load(std::memory_order_acquire));
+            if (epochOf(slot.data.next) != epoch || slot.data.next == slot.data.end) {
+                const timestamp_t block = curr_.fetch_add(LEASED_TS_BLOCK_SIZE);
+                slot.data.next = block;
+                slot.data.end = block + LEASED_TS_BLOCK_SIZE;
+            }
+            return slot.data.next++;
+        }
+
+        inline timestamp_t Snapshot() {
+            const timestamp_t closed = epochOf(curr_.fetch_add(EPOCH));
+            return closed + EPOCH - 1;
+        }
+};
+
+// Runtime-selected clock. The kind is latched at construction, so the switch below
+// is a perfectly predicted branch on a member rather than an indirect call, and
+// each arm inlines the corresponding policy. The hardware policies are stateless,
+// so only the TSC safety check is done, and only when one of them is selected.
+template <typename LogicalTimestamp>
+class SelectableTimestamp {
+    private:
+        const timestamp_kind_t kind_;
+        const timestamp_t epsilon_;     // only used by TIMESTAMP_RDTSCP_SKEW
+        LogicalTimestamp logical_;
+
+    public:
+        SelectableTimestamp()
+                : kind_(timestamp_selected_kind())
+                , epsilon_(kind_ == TIMESTAMP_RDTSCP_SKEW ? SkewBoundedRdtscpTimestamp::Epsilon() : 0) {
+            if (kind_ == TIMESTAMP_RDTSC) tsc_require_safe("RdtscTimestamp", false);
+            if (kind_ == TIMESTAMP_RDTSCP) tsc_require_safe("RdtscpTimestamp", true);
+        }
+
+        inline timestamp_kind_t Kind() const {
+            return kind_;
+        }
+
+        inline timestamp_t Read() {
+            switch (kind_) {
+                case TIMESTAMP_RDTSCP: return RdtscpTimestamp::readRdtscp();
+                case TIMESTAMP_RDTSC: return RdtscTimestamp::readRdtsc();
+                case TIMESTAMP_RDTSCP_SKEW: return SkewBoundedRdtscpTimestamp::read(epsilon_);
+                default: return logical_.Read();
+            }
+        }
+
+        inline timestamp_t Advance(const int tid) {
+            switch (kind_) {
+                case TIMESTAMP_RDTSCP: return RdtscpTimestamp::readRdtscp();
+                case TIMESTAMP_RDTSC: return RdtscTimestamp::readRdtsc();
+                case TIMESTAMP_RDTSCP_SKEW: return SkewBoundedRdtscpTimestamp::advance(epsilon_);
+                default: return logical_.Advance(tid);
+            }
+        }
+
+        inline timestamp_t Snapshot() {
+            switch (kind_) {
+                case TIMESTAMP_RDTSCP: return RdtscpTimestamp::readRdtscp();
+                case TIMESTAMP_RDTSC: return RdtscTimestamp::readRdtsc();
+                case TIMESTAMP_RDTSCP_SKEW: return SkewBoundedRdtscpTimestamp::read(epsilon_);
+                default: return logical_.Snapshot();
+            }
+        }
+};
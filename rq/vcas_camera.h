@@ -0,0 +1,104 @@
+// The camera object of vCAS (Wei et al., "Constant-Time Snapshots with
+// Applications to Concurrent Data Structures", PPoPP 2021).
+//
+// A Camera owns the clock that labels vCAS versions and the announcements of
+// the snapshots in use. takeSnapshot() returns a handle that a range query
+// keeps for its whole traversal (RQProvider::traversal_start hands it to the
+// data structure, which passes it to every versioned read and finally to
+// traversal_end). Versions are read relative to a handle with readVersion(),
+// releaseSnapshot() retires the handle, and oldestActive() bounds the handles
+// that are still held, which is what version pruning needs.
+//
+// The clock is a template parameter: any policy of timestamp_provider.h. With a
+// logical clock, a snapshot reads the counter and increments it only if no
+// other snapshot did so in the meantime (BackoffTimestamp backs off between the
+// two, so concurrent range queries share one increment). With a hardware clock
+// (-ts rdtsc / rdtscp through SelectableTimestamp) no shared line is written at
+// all. Announcements live in per-thread cache lines.
+
+#ifndef VCAS_CAMERA_H
+#define VCAS_CAMERA_H
+
+#include <cassert>
+
+#include "plaf.h"
+#include "timestamp_provider.h"
+
+// Announced by threads that hold no snapshot. Clocks start at MIN_TIMESTAMP.
+#define CAMERA_NO_SNAPSHOT 0LL
+
+struct camera_snapshot_t {
+  timestamp_t ts;
+};
+
+template <typename Clock>
+class Camera {
+ private:
+  union announcement_t {
+    volatile timestamp_t ts;
+    volatile char bytes[PREFETCH_SIZE_BYTES];
+  } __attribute__((aligned(BYTES_IN_CACHE_LINE)));
+
+  const int num_processes_;
+  announcement_t *const announcements_;
+  Clock clock_;
+
+ public:
+  explicit Camera(const int num_processes)
+      : num_processes_(num_processes),
+        announcements_(new announcement_t[num_processes]) {
+    for (int i = 0; i < num_processes; ++i) {
+      announcements_[i].ts = CAMERA_NO_SNAPSHOT;
+    }
+  }
+
+  ~Camera() { delete[] announcements_; }
+
+  // The label of a version whose timestamp is set now.
+  inline timestamp_t Read() { return clock_.Read(); }
+
+  // A lower bound is announced before the clock is advanced, so that a
+  // concurrent oldestActive() cannot miss this snapshot while its timestamp is
+  // being taken. The bound is left in place rather than replaced by the
+  // snapshot's timestamp: it only keeps a few more versions from pruning, and
+  // it saves a second write to the announcement.
+  inline camera_snapshot_t takeSnapshot(const int tid) {
+    announcements_[tid].ts = clock_.Read();
+    __sync_synchronize();
+    camera_snapshot_t snapshot;
+    snapshot.ts = clock_.Advance(tid);
+    return snapshot;
+  }
+
+  // Ends the use of a snapshot taken by thread tid; versions that only it could
+  // see may then be pruned.
+  inline void releaseSnapshot(const int tid,
+                              const camera_snapshot_t &snapshot) {
+    assert(announcements_[tid].ts != CAMERA_NO_SNAPSHOT);
+    assert(announcements_[tid].ts <= snapshot.ts);
+    announcements_[tid].ts = CAMERA_NO_SNAPSHOT;
+  }
+
+  // Returns a timestamp no newer than any snapshot that is announced now or
+  // taken later.
+  inline timestamp_t oldestActive() {
+    timestamp_t oldest = clock_.Read();
+    for (int i = 0; i < num_processes_; ++i) {
+      const timestamp_t ts = announcements_[i].ts;
+      if (ts != CAMERA_NO_SNAPSHOT && ts < oldest) oldest = ts;
+    }
+    return oldest;
+  }
+
+  // Returns the newest version of the list starting at head that is visible to
+  // snapshot (the first one labelled at or before it), or nullptr. The head
+  // must already be labelled.
+  template <typename Version>
+  inline Version *readVersion(Version *head,
+                              const camera_snapshot_t &snapshot) {
+    while (head != nullptr && head->ts > snapshot.ts) head = head->nextv;
+    return head;
+  }
+};
+
+#endif /* VCAS_CAMERA_H */
@@ -8,6 +8,7 @@
 #include "rq_provider.h"
 #include "random.h"
 #include "plaf.h"
+#include "multiget.h"
 
 using namespace std;
 
@@ -36,10 +37,20 @@ public:
             volatile long long fullyLinked;                                     // stored as long long simply so it is large enough to be used with the lock-free RQProvider (which requires all fields that are modified at linearization points of operations to occupy a machine word)
             volatile long long itime;
             volatile long long dtime;
-            node_t<K,V> * volatile p_next[SKIPLIST_MAX_LEVEL];
+            node_t<K,V> * volatile p_next[SKIPLIST_MAX_LEVEL];                  // must be last: a node only has room for p_next[0..topLevel]
         };
     };
     
+    // size of a node with p_next[0..topLevel]; about half of all nodes have
+    // topLevel 0, so this is much less than sizeof(node_t)
+    static size_t sizeOf(const int topLevel) {
+        return sizeof(node_t<K,V>) - (SKIPLIST_MAX_LEVEL - 1 - topLevel) * sizeof(p_next[0]);
+    }
+    // lets recordmgr pools recycle nodes by size class (see pool_interface.h)
+    size_t recordSize() const {
+        return sizeOf(topLevel);
+    }
+    
     template <typename RQProvider>
     bool isMarked(const int tid, RQProvider * const prov){
         return (prov->read_addr(tid, &marked) == 1);
@@ -65,7 +76,7 @@ private:
     debugCounters * const counters;
 #endif
 
-    nodeptr allocateNode(const int tid);
+    nodeptr allocateNode(const int tid, const int height);
     
     void initNode(const int tid, nodeptr p_node, K key, V value, int height);
     int find_impl(const int tid, K key, nodeptr* p_preds, nodeptr* p_succs, nodeptr* p_found);
@@ -84,6 +95,9 @@ public:
 
     bool contains(const int tid, K key);
     const pair<V,bool> find(const int tid, const K& key);
+    // looks up keys[0..n-1] with interleaved traversals (see multiget.h);
+    // values[i] is NO_VALUE if keys[i] is absent. returns the number of keys found.
+    int multiGet(const int tid, const K * const keys, const int n, V * const values);
     V insert(const int tid, const K& key, const V& value) {
         return doInsert(tid, key, value, false);
     }
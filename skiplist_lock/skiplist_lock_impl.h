@@ -80,8 +80,10 @@ void skiplist<K, V, RecordMgr>::initNode(const int tid, nodeptr p_node, K key,
 }
 
 template <typename K, typename V, class RecordMgr>
-nodeptr skiplist<K, V, RecordMgr>::allocateNode(const int tid) {
-  nodeptr nnode = recmgr->template allocate<node_t<K, V> >(tid);
+nodeptr skiplist<K, V, RecordMgr>::allocateNode(const int tid,
+                                                const int height) {
+  nodeptr nnode = recmgr->template allocate<node_t<K, V> >(
+      tid, node_t<K, V>::sizeOf(height));
   if (nnode == NULL) {
     cout << "ERROR: out of memory" << endl;
     exit(-1);
@@ -140,10 +142,10 @@ skiplist<K, V, RecManager>::skiplist(const int numProcesses, const K _KEY_MIN,
   const int dummyTid = 0;
   recmgr->initThread(dummyTid);
 
-  p_head = allocateNode(dummyTid);
+  p_head = allocateNode(dummyTid, SKIPLIST_MAX_LEVEL - 1);
   initNode(dummyTid, p_head, KEY_MIN, NO_VALUE, SKIPLIST_MAX_LEVEL - 1);
 
-  p_tail = allocateNode(dummyTid);
+  p_tail = allocateNode(dummyTid, SKIPLIST_MAX_LEVEL - 1);
   initNode(dummyTid, p_tail, KEY_MAX, NO_VALUE, SKIPLIST_MAX_LEVEL - 1);
 
   for (i = 0; i < SKIPLIST_MAX_LEVEL; i++) {
@@ -242,6 +244,54 @@ const pair<V, bool> skiplist<K, V, RecManager>::find(const int tid,
   }
 }
 
+template <typename K, typename V, class RecManager>
+int skiplist<K, V, RecManager>::multiGet(const int tid, const K* const keys,
+                                         const int n, V* const values) {
+  int idx[MULTIGET_GROUP_SIZE];
+  int level[MULTIGET_GROUP_SIZE];
+  nodeptr p_pred[MULTIGET_GROUP_SIZE];
+  nodeptr p_curr[MULTIGET_GROUP_SIZE];
+  int found = 0;
+  auto start = [&](const int s, const int i) {
+    idx[s] = i;
+    level[s] = SKIPLIST_MAX_LEVEL - 1;
+    p_pred[s] = p_head;
+    p_curr[s] = p_head->p_next[level[s]];
+    MULTIGET_PREFETCH(p_curr[s]);
+  };
+  // Same path as find_impl, but a lookup stops at the highest level where it
+  // sees its key, which is the node find() checks.
+  auto step = [&](const int s) {
+    const K& key = keys[idx[s]];
+    nodeptr p_node = p_curr[s];
+    if (key > p_node->key) {
+      p_pred[s] = p_node;
+      p_curr[s] = p_node->p_next[level[s]];
+    } else if (key == p_node->key) {
+      const bool res = rqProvider->read_addr(tid, &p_node->fullyLinked) &&
+                       !rqProvider->read_addr(tid, &p_node->marked);
+#ifdef RQ_SNAPCOLLECTOR
+      rqProvider->search_report_target_key(tid, key, p_node);
+#endif
+      values[idx[s]] = res ? p_node->val : NO_VALUE;
+      if (res) ++found;
+      return false;
+    } else if (level[s] == 0) {
+      values[idx[s]] = NO_VALUE;
+      return false;
+    } else {
+      --level[s];
+      p_curr[s] = p_pred[s]->p_next[level[s]];
+    }
+    MULTIGET_PREFETCH(p_curr[s]);
+    return true;
+  };
+  recmgr->leaveQuiescentState(tid, true);
+  multiget_run(n, start, step);
+  recmgr->enterQuiescentState(tid);
+  return found;
+}
+
 template <typename K, typename V, class RecManager>
 V skiplist<K, V, RecManager>::doInsert(const int tid, const K& key,
                                        const V& value, bool onlyIfAbsent) {
@@ -308,7 +358,7 @@ V skiplist<K, V, RecManager>::doInsert(const int tid, const K& key,
     }
 
     if (valid) {
-      p_new_node = allocateNode(tid);  // shmem_none->allocateNode(tid);
+      p_new_node = allocateNode(tid, topLevel);
 #ifdef __HANDLE_STATS
       GSTATS_APPEND(tid, node_allocated_addresses,
                     ((long long)p_new_node) % (1 << 12));
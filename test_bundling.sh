@@ -2,11 +2,12 @@
 
 # multiple values okay
 threads="1 2 24 48 72 96 120 144 168 192"
-  # SKIPLISTLOCK: benchs="luigi.skiplistlock.rq_bundle.ts.out luigi.skiplistlock.rq_bundle.rdtsc.out luigi.skiplistlock.rq_bundle.rdtscp.out"
-  # BST: benchs="luigi.bst.rq_bundle.rdtsc.out luigi.bst.rq_bundle.rdtscp.out luigi.bst.rq_bundle.ts.out"
+  # SKIPLISTLOCK: benchs="luigi.skiplistlock.rq_bundle.out"
+  # BST: benchs="luigi.bst.rq_bundle.out"
 # CITRUS:
-benchs="luigi.citrus.rq_bundle.ts.out luigi.citrus.rq_bundle.rdtsc.out luigi.citrus.rq_bundle.rdtscp.out"
-  # LAZYLIST: benchs="luigi.lazylist.rq_bundle.rdtsc.out luigi.lazylist.rq_bundle.rdtscp.out luigi.lazylist.rq_bundle.ts.out"
+benchs="luigi.citrus.rq_bundle.out"
+  # LAZYLIST: benchs="luigi.lazylist.rq_bundle.out"
+timestamps="ts rdtsc rdtscp"
 iterations="1 2 3 4 5"
 sizes="1000000"
 rqsize="100"
@@ -39,9 +40,12 @@ do
  do
   for bench in ${benchs}
   do
+   for ts in ${timestamps}
+   do
    for iter in ${iterations}
    do 
-     ${beg_loads} ${bin}/${bench} -i ${insert} -d ${delete} -rq ${range_query} -rqsize ${rqsize} -k ${size} -p -t ${duration} -nrq 0 -nwork ${thread} -bind ${bind} | grep 'total throughput' >> ${logdir}/${bench}-n${thread}.log
+     ${beg_loads} ${bin}/${bench} -ts ${ts} -i ${insert} -d ${delete} -rq ${range_query} -rqsize ${rqsize} -k ${size} -p -t ${duration} -nrq 0 -nwork ${thread} -bind ${bind} | grep 'total throughput' >> ${logdir}/${bench}-${ts}-n${thread}.log
+   done
    done
    echo "Done experimenting for $bench with $thread threads" 
   done
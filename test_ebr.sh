@@ -2,11 +2,12 @@
 
 # multiple values okay
 threads="1 2 24 48 72 96 120 144 168 192"
-  # SKIPLISTLOCK: benchs="luigi.skiplistlock.rq_rwlock.ts.out luigi.skiplistlock.rq_rwlock.rdtsc.out luigi.skiplistlock.rq_rwlock.rdtscp.out"
+  # SKIPLISTLOCK: benchs="luigi.skiplistlock.rq_rwlock.out"
   # BST:
-  benchs="luigi.bst.rq_rwlock.ts.out luigi.bst.rq_rwlock.rdtsc.out luigi.bst.rq_rwlock.rdtscp.out"
-  # CITRUS: benchs="luigi.citrus.rq_rwlock.ts.out luigi.citrus.rq_rwlock.rdtsc.out luigi.citrus.rq_rwlock.rdtscp.out"
-  # LAZYLIST: benchs="luigi.lazylist.rq_rwlock.ts.out luigi.lazylist.rq_rwlock.rdtsc.out luigi.lazylist.rq_rwlock.rdtscp.out"
+  benchs="luigi.bst.rq_rwlock.out"
+  # CITRUS: benchs="luigi.citrus.rq_rwlock.out"
+  # LAZYLIST: benchs="luigi.lazylist.rq_rwlock.out"
+timestamps="ts rdtsc rdtscp"
 iterations="1 2 3 4 5"
 sizes="1000000"
 rqsize="100"
@@ -39,9 +40,12 @@ do
  do
   for bench in ${benchs}
   do
+   for ts in ${timestamps}
+   do
    for iter in ${iterations}
    do 
-     ${beg_loads} ${bin}/${bench} -i ${insert} -d ${delete} -rq ${range_query} -rqsize ${rqsize} -k ${size} -p -t ${duration} -nrq 0 -nwork ${thread} -bind ${bind} | grep 'total throughput' >> ${logdir}/${bench}-n${thread}.log
+     ${beg_loads} ${bin}/${bench} -ts ${ts} -i ${insert} -d ${delete} -rq ${range_query} -rqsize ${rqsize} -k ${size} -p -t ${duration} -nrq 0 -nwork ${thread} -bind ${bind} | grep 'total throughput' >> ${logdir}/${bench}-${ts}-n${thread}.log
+   done
    done
    echo "Done experimenting for $bench with $thread threads" 
   done
@@ -2,11 +2,13 @@
 
 # multiple values okay
 threads="1 2 24 48 72 96 120 144 168 192"
-  # SKIPLISTLOCK: benchs="luigi.skiplistlock.rq_lockfree.ts.out luigi.skiplistlock.rq_lockfree.rdtsc.out luigi.skiplistlock.rq_lockfree.rdtscp.out"
+# the logical timestamp runs <prefix>.rq_lockfree.out, hardware timestamps run <prefix>.rq_lockfree_hw.out
+  # SKIPLISTLOCK: prefixes="luigi.skiplistlock"
   # BST:
-  benchs="luigi.bst.rq_lockfree.ts.out luigi.bst.rq_lockfree.rdtsc.out luigi.bst.rq_lockfree.rdtscp.out"
-  # CITRUS: benchs="luigi.citrus.rq_lockfree.ts.out luigi.citrus.rq_lockfree.rdtsc.out luigi.citrus.rq_lockfree.rdtscp.out"
-  # LAZYLIST: benchs="luigi.lazylist.rq_lockfree.ts.out luigi.lazylist.rq_lockfree.rdtsc.out luigi.lazylist.rq_lockfree.rdtscp.out"
+  prefixes="luigi.bst"
+  # CITRUS: prefixes="luigi.citrus"
+  # LAZYLIST: prefixes="luigi.lazylist"
+timestamps="ts rdtsc rdtscp"
 iterations="1 2 3 4 5"
 sizes="1000000"
 rqsize="100"
@@ -37,13 +39,17 @@ for size in ${sizes}
 do
  for thread in ${threads}
  do
-  for bench in ${benchs}
+  for prefix in ${prefixes}
   do
+   for ts in ${timestamps}
+   do
+   if [ "${ts}" == "ts" ]; then bench=${prefix}.rq_lockfree.out; else bench=${prefix}.rq_lockfree_hw.out; fi
    for iter in ${iterations}
    do 
-     ${beg_loads} ${bin}/${bench} -i ${insert} -d ${delete} -rq ${range_query} -rqsize ${rqsize} -k ${size} -p -t ${duration} -nrq 0 -nwork ${thread} -bind ${bind} | grep 'total throughput' >> ${logdir}/${bench}-n${thread}.log
+     ${beg_loads} ${bin}/${bench} -ts ${ts} -i ${insert} -d ${delete} -rq ${range_query} -rqsize ${rqsize} -k ${size} -p -t ${duration} -nrq 0 -nwork ${thread} -bind ${bind} | grep 'total throughput' >> ${logdir}/${bench}-${ts}-n${thread}.log
    done
-   echo "Done experimenting for $bench with $thread threads" 
+   done
+   echo "Done experimenting for $prefix with $thread threads" 
   done
  done
 done
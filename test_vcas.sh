@@ -3,11 +3,12 @@
 # multiple values okay
 threads="1 2 24 48 72 96 120 144 168 192"
 #SKIPLISTLOCK:
-benchs="luigi.skiplistlock.rq_vcas.ts.out luigi.skiplistlock.rq_vcas.rdtsc.out luigi.skiplistlock.rq_vcas.rdtscp.out"
-  # BST: benchs="luigi.bst.rq_vcas.ts.out luigi.bst.rq_vcas.rdtsc.out luigi.bst.rq_vcas.rdtscp.out"
-  # CITRUS:benchs="luigi.citrus.rq_vcas.ts.out luigi.citrus.rq_vcas.rdtsc.out luigi.citrus.rq_vcas.rdtscp.out"
-  # LAZYLIST: benchs="luigi.lazylist.rq_vcas.ts.out luigi.lazylist.rq_vcas.rdtsc.out luigi.lazylist.rq_vcas.rdtscp.out"
+benchs="luigi.skiplistlock.rq_vcas.out"
+  # BST: benchs="luigi.bst.rq_vcas.out"
+  # CITRUS:benchs="luigi.citrus.rq_vcas.out"
+  # LAZYLIST: benchs="luigi.lazylist.rq_vcas.out"
 
+timestamps="ts rdtsc rdtscp"
 iterations="1 2 3 4 5"
 sizes="1000000"
 rqsize="100"
@@ -40,9 +41,12 @@ do
  do
   for bench in ${benchs}
   do
+   for ts in ${timestamps}
+   do
    for iter in ${iterations}
    do 
-     ${beg_loads} ${bin}/${bench} -i ${insert} -d ${delete} -rq ${range_query} -rqsize ${rqsize} -k ${size} -p -t ${duration} -nrq 0 -nwork ${thread} -bind ${bind} | grep 'total throughput' >> ${logdir}/${bench}-n${thread}.log
+     ${beg_loads} ${bin}/${bench} -ts ${ts} -i ${insert} -d ${delete} -rq ${range_query} -rqsize ${rqsize} -k ${size} -p -t ${duration} -nrq 0 -nwork ${thread} -bind ${bind} | grep 'total throughput' >> ${logdir}/${bench}-${ts}-n${thread}.log
+   done
    done
    echo "Done experimenting for $bench with $thread threads" 
   done
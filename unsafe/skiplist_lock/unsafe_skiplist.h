@@ -43,9 +43,19 @@ class node_t {
                       // used with the lock-free RQProvider (which requires all
                       // fields that are modified at linearization points of
                       // operations to occupy a machine word)
+    // Must be last: a node only has room for p_next[0..topLevel].
     node_t<K, V>* volatile p_next[SKIPLIST_MAX_LEVEL];
   };
 
+  // Size of a node with p_next[0..topLevel]. About half of all nodes have
+  // topLevel 0, so this is much less than sizeof(node_t).
+  static size_t sizeOf(const int topLevel) {
+    return sizeof(node_t<K, V>) -
+           (SKIPLIST_MAX_LEVEL - 1 - topLevel) * sizeof(p_next[0]);
+  }
+  // Lets recordmgr pools recycle nodes by size class (see pool_interface.h).
+  size_t recordSize() const { return sizeOf(topLevel); }
+
   template <typename RQProvider>
   bool isMarked(const int tid, RQProvider* const prov) {
     return (prov->read_addr(tid, &marked) == 1);
@@ -71,7 +81,7 @@ class unsafe_skiplist {
   debugCounters* const counters;
 #endif
 
-  nodeptr allocateNode(const int tid);
+  nodeptr allocateNode(const int tid, const int height);
 
   void initNode(const int tid, nodeptr p_node, K key, V value, int height);
   int find_impl(const int tid, K key, nodeptr* p_preds, nodeptr* p_succs,
@@ -79,8 +79,10 @@ void unsafe_skiplist<K, V, RecordMgr>::initNode(const int tid, nodeptr p_node,
 }
 
 template <typename K, typename V, class RecordMgr>
-nodeptr unsafe_skiplist<K, V, RecordMgr>::allocateNode(const int tid) {
-  nodeptr nnode = new node_t<K, V>;
+nodeptr unsafe_skiplist<K, V, RecordMgr>::allocateNode(const int tid,
+                                                       const int height) {
+  nodeptr nnode = recmgr->template allocate<node_t<K, V>>(
+      tid, node_t<K, V>::sizeOf(height));
   if (nnode == NULL) {
     cout << "ERROR: out of memory" << endl;
     exit(-1);
@@ -140,11 +142,11 @@ unsafe_skiplist<K, V, RecManager>::unsafe_skiplist(const int numProcesses,
   const int dummyTid = 0;
   recmgr->initThread(dummyTid);
 
-  p_tail = new node_t<K, V>();
+  p_tail = allocateNode(dummyTid, SKIPLIST_MAX_LEVEL - 1);
   initNode(dummyTid, p_tail, KEY_MAX, NO_VALUE, SKIPLIST_MAX_LEVEL - 1);
   p_tail->fullyLinked = 1;
 
-  p_head = new node_t<K, V>();
+  p_head = allocateNode(dummyTid, SKIPLIST_MAX_LEVEL - 1);
   initNode(dummyTid, p_head, KEY_MIN, NO_VALUE, SKIPLIST_MAX_LEVEL - 1);
   p_head->fullyLinked = 1;
 
@@ -296,7 +298,7 @@ V unsafe_skiplist<K, V, RecManager>::doInsert(const int tid, const K& key,
     }
 
     if (valid) {
-      p_new_node = new node_t<K, V>();  // shmem_none->allocateNode(tid);
+      p_new_node = allocateNode(tid, topLevel);
 #ifdef __HANDLE_STATS
       GSTATS_APPEND(tid, node_allocated_addresses,
                     ((long long)p_new_node) % (1 << 12));
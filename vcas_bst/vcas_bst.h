@@ -18,6 +18,7 @@
 #include "random.h"
 #include "vcas_scxrecord.h"
 #include "vcas_node.h"
+#include "multiget.h"
 
 #ifndef MAX_NODES_INSERTED_OR_DELETED_ATOMICALLY
     // define BEFORE including rq_provider.h
@@ -269,6 +270,8 @@ public:
         const V insertIfAbsent(const int tid, const K& key, const V& val);
         const pair<V,bool> erase(const int tid, const K& key);
         const pair<V,bool> find(const int tid, const K& key);
+        /** looks up keys[0..n-1] with interleaved traversals (see multiget.h); values[i] is NO_VALUE if keys[i] is absent. returns the number of keys found. **/
+        int multiGet(const int tid, const K * const keys, const int n, V * const values);
         int rangeQuery(const int tid, const K& lo, const K& hi, K * const resultKeys, V * const resultValues);
         bool contains(const int tid, const K& key);
         int size(void); /** warning: size is a LINEAR time operation, and does not return consistent results with concurrency **/
@@ -285,8 +288,8 @@ public:
             return true;
         }
 
-        inline int getKeys(const int tid, Node<K,V> * node, K * const outputKeys, V * const outputValues, const long long ts) {
-            if (rqProvider->read_addr(tid, &node->left, ts) == NULL && node->key != NO_KEY) {
+        inline int getKeys(const int tid, Node<K,V> * node, K * const outputKeys, V * const outputValues, const camera_snapshot_t& snapshot) {
+            if (rqProvider->read_addr(tid, &node->left, snapshot) == NULL && node->key != NO_KEY) {
                 // leaf ==> its key is in the set.
                 outputKeys[0] = node->key;
                 outputValues[0] = node->value;
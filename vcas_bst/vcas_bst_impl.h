@@ -71,7 +71,7 @@ template<class K, class V, class Compare, class RecManager>
 int vcas_bst_ns::vcas_bst<K,V,Compare,RecManager>::rangeQuery(const int tid, const K& lo, const K& hi, K * const resultKeys, V * const resultValues) {
     block<Node<K,V> > stack (NULL);
     recmgr->leaveQuiescentState(tid, true);
-    long long ts = rqProvider->traversal_start(tid);
+    const camera_snapshot_t snapshot = rqProvider->traversal_start(tid);
     // volatile long long sum = 0;
     // for(int i = 0; i < 500000; i++)
     //     sum += i;
@@ -81,7 +81,7 @@ int vcas_bst_ns::vcas_bst<K,V,Compare,RecManager>::rangeQuery(const int tid, con
     while (!stack.isEmpty()) {
         Node<K,V> * node = stack.pop();
         assert(node);
-        Node<K,V> * left = rqProvider->read_addr(tid, &node->left, ts);
+        Node<K,V> * left = rqProvider->read_addr(tid, &node->left, snapshot);
 
         #if defined(VCAS_STATS)
             // if(nodesSeen.find(node) == nodesSeen.end())
@@ -94,7 +94,7 @@ int vcas_bst_ns::vcas_bst<K,V,Compare,RecManager>::rangeQuery(const int tid, con
         // if internal node, explore its children
         if (left != NULL) {
             if (node->key != this->NO_KEY && !cmp(hi, node->key)) {
-                Node<K,V> * right = rqProvider->read_addr(tid, &node->right, ts);
+                Node<K,V> * right = rqProvider->read_addr(tid, &node->right, snapshot);
                 assert(right);
                 stack.push(right);
             }
@@ -114,11 +114,11 @@ int vcas_bst_ns::vcas_bst<K,V,Compare,RecManager>::rangeQuery(const int tid, con
             
         // else if leaf node, check if we should add its key to the traversal
         } else {
-            rqProvider->traversal_try_add(tid, node, resultKeys, resultValues, &size, lo, hi, ts);
+            rqProvider->traversal_try_add(tid, node, resultKeys, resultValues, &size, lo, hi, snapshot);
         }
     }
 
-    rqProvider->traversal_end(tid, resultKeys, resultValues, &size, lo, hi);
+    rqProvider->traversal_end(tid, snapshot, resultKeys, resultValues, &size, lo, hi);
     recmgr->enterQuiescentState(tid);
     // sum_sizes+=size;
     return size;
@@ -162,6 +162,40 @@ const pair<V,bool> vcas_bst_ns::vcas_bst<K,V,Compare,RecManager>::find(const int
     return pair<V,bool>(NO_VALUE, false);
 }
 
+template<class K, class V, class Compare, class RecManager>
+int vcas_bst_ns::vcas_bst<K,V,Compare,RecManager>::multiGet(const int tid, const K * const keys, const int n, V * const values) {
+    int idx[MULTIGET_GROUP_SIZE];
+    Node<K,V> *l[MULTIGET_GROUP_SIZE];
+    int found = 0;
+    auto start = [&](const int s, const int i) {
+        idx[s] = i;
+        Node<K,V> *p = rqProvider->read_addr(tid, &root->left);
+        l[s] = rqProvider->read_addr(tid, &p->left); // NULL if there are no keys in data structure
+        MULTIGET_PREFETCH(l[s]);
+    };
+    auto step = [&](const int s) {
+        const K& key = keys[idx[s]];
+        Node<K,V> *curr = l[s];
+        Node<K,V> *left = (curr == NULL) ? NULL : rqProvider->read_addr(tid, &curr->left);
+        if (left == NULL) {
+            if (curr != NULL && key == curr->key) {
+                values[idx[s]] = curr->value;
+                ++found;
+            } else {
+                values[idx[s]] = NO_VALUE;
+            }
+            return false;
+        }
+        l[s] = cmp(key, curr->key) ? left : rqProvider->read_addr(tid, &curr->right);
+        MULTIGET_PREFETCH(l[s]);
+        return true;
+    };
+    recmgr->leaveQuiescentState(tid, true);
+    multiget_run(n, start, step);
+    recmgr->enterQuiescentState(tid);
+    return found;
+}
+
 //template<class K, class V, class Compare, class RecManager>
 //const V vcas_bst_ns::vcas_bst<K,V,Compare,RecManager>::insert(const int tid, const K& key, const V& val) {
 //    bool onlyIfAbsent = false;
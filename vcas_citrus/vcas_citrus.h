@@ -34,6 +34,8 @@
 #define MAX_NODES_INSERTED_OR_DELETED_ATOMICALLY 4
 #endif
 #include "rq_provider.h"
+#include "rq_aggregate.h"
+#include "multiget.h"
 using namespace std;
 
 #define LOGICAL_DELETION_USAGE false
@@ -102,8 +104,15 @@ class citrustree {
   const V insertIfAbsent(const int tid, const K& key, const V& value);
   const pair<V, bool> erase(const int tid, const K& key);
   const pair<V, bool> find(const int tid, const K& key);
+  // looks up keys[0..n-1] with interleaved traversals (see multiget.h);
+  // values[i] is NO_VALUE if keys[i] is absent. returns the number of keys
+  // found.
+  int multiGet(const int tid, const K* const keys, const int n,
+               V* const values);
   int rangeQuery(const int tid, const K& lo, const K& hi, K* const resultKeys,
                  V* const resultValues);
+  int rangeQueryAggregate(const int tid, const K& lo, const K& hi,
+                          RQAggregate<K>& aggregate);
   bool contains(const int tid, const K& key);
   int size();  // warning: this is a linear time operation, and is not
                // linearizable
@@ -119,7 +128,8 @@ class citrustree {
   inline bool isLogicallyInserted(const int tid, nodeptr node) { return true; }
 
   inline int getKeys(const int tid, node_t<K, V>* node, K* const outputKeys,
-                     V* const outputValues, long long ts) {
+                     V* const outputValues,
+                     const camera_snapshot_t& snapshot) {
     if (node->key >= NO_KEY) return 0;
     outputKeys[0] = node->key;
     outputValues[0] = node->value;
@@ -130,6 +140,12 @@ class citrustree {
     return (key != NO_KEY && lo <= key && key <= hi);
   }
 
+  // Retires the vCAS objects of a node that is being retired.
+  inline void retireVersions(const int tid, node_t<K, V>* node) {
+    rqProvider->retire_vcas(tid, node->child[0]);
+    rqProvider->retire_vcas(tid, node->child[1]);
+  }
+
   /**
    * END FUNCTIONS FOR RANGE QUERY SUPPORT
    */
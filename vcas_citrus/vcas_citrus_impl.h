@@ -50,9 +50,11 @@ nodeptr citrustree<K, V, RecManager>::newNode(const int tid, K key, V value) {
   nnode->marked = false;
 
   // Init vcas objects.
-  nnode->child[0] = new vcas_obj_t<nodeptr>(nullptr, nullptr);
+  nnode->child[0] =
+      rqProvider->template new_vcas<nodeptr>(tid, nullptr, nullptr);
   rqProvider->write_vcas(tid, nnode->child[0], (nodeptr)NULL);
-  nnode->child[1] = new vcas_obj_t<nodeptr>(nullptr, nullptr);
+  nnode->child[1] =
+      rqProvider->template new_vcas<nodeptr>(tid, nullptr, nullptr);
   rqProvider->write_vcas(tid, nnode->child[1], (nodeptr)NULL);
 
   nnode->tag[0] = 0;
@@ -148,6 +150,41 @@ const pair<V, bool> citrustree<K, V, RecManager>::find(const int tid,
   return pair<V, bool>(result, true);
 }
 
+template <typename K, typename V, class RecManager>
+int citrustree<K, V, RecManager>::multiGet(const int tid, const K* const keys,
+                                           const int n, V* const values) {
+  int idx[MULTIGET_GROUP_SIZE];
+  nodeptr curr[MULTIGET_GROUP_SIZE];
+  int found = 0;
+  auto start = [&](const int s, const int i) {
+    idx[s] = i;
+    curr[s] = rqProvider->read_vcas(tid, root->child[0]);
+    MULTIGET_PREFETCH(curr[s]);
+  };
+  auto step = [&](const int s) {
+    const K& key = keys[idx[s]];
+    if (curr[s] == NULL) {
+      values[idx[s]] = NO_VALUE;
+      return false;
+    }
+    K ckey = curr[s]->key;
+    if (ckey == key) {
+      values[idx[s]] = curr[s]->value;
+      ++found;
+      return false;
+    }
+    curr[s] = rqProvider->read_vcas(tid, curr[s]->child[ckey < key]);
+    MULTIGET_PREFETCH(curr[s]);
+    return true;
+  };
+  recordmgr->leaveQuiescentState(tid, true);
+  readLock();
+  multiget_run(n, start, step);
+  readUnlock();
+  recordmgr->enterQuiescentState(tid);
+  return found;
+}
+
 template <typename K, typename V, class RecManager>
 bool citrustree<K, V, RecManager>::contains(const int tid, const K& key) {
   return find(tid, key).second;
@@ -420,37 +457,84 @@ int citrustree<K, V, RecManager>::rangeQuery(const int tid, const K& lo,
                                              const K& hi, K* const resultKeys,
                                              V* const resultValues) {
   block<node_t<K, V> > stack(NULL);
+  // for each node on the stack, the node whose key is an exclusive lower bound
+  // on the keys of its subtree (root if there is none)
+  block<node_t<K, V> > bounds(NULL);
   recordmgr->leaveQuiescentState(tid, true);
-  long long ts = rqProvider->traversal_start(tid);
+  const camera_snapshot_t snapshot = rqProvider->traversal_start(tid);
 
   // depth first traversal (of interesting subtrees)
   int size = 0;
   stack.push(root);
+  bounds.push(root);
   while (!stack.isEmpty()) {
     nodeptr node = stack.pop();
+    nodeptr bound = bounds.pop();
 
     // what (if anything) we need to do with CITRUS' validation function?
     // answer: nothing, because searches don't need to do anything with it.
 
-    // check if we should add node's key to the traversal
-    rqProvider->traversal_try_add(tid, node, resultKeys, resultValues, &size,
-                                  lo, hi, ts);
+    // check if we should add node's key to the traversal. a two-child delete
+    // replaces the deleted node with a copy of its successor before it unlinks
+    // the successor, so a snapshot in between can reach the successor in the
+    // copy's right subtree. its key is already in the result.
+    if (bound == root || bound->key < node->key) {
+      rqProvider->traversal_try_add(tid, node, resultKeys, resultValues, &size,
+                                    lo, hi, snapshot);
+    }
 
-    // if internal node, explore its children
-    nodeptr left = rqProvider->read_vcas(tid, node->child[0]);
-    nodeptr right = rqProvider->read_vcas(tid, node->child[1]);
+    // if internal node, explore its children as of the snapshot
+    nodeptr left = rqProvider->read_vcas(tid, node->child[0], snapshot);
+    nodeptr right = rqProvider->read_vcas(tid, node->child[1], snapshot);
     if (left != NULL && lo < node->key) {
       stack.push(left);
+      bounds.push(bound);
     }
     if (right != NULL && hi > node->key) {
       stack.push(right);
+      bounds.push(node);
     }
   }
-  rqProvider->traversal_end(tid, resultKeys, resultValues, &size, lo, hi);
+  rqProvider->traversal_end(tid, snapshot, resultKeys, resultValues, &size, lo,
+                            hi);
   recordmgr->enterQuiescentState(tid);
   return size;
 }
 
+template <typename K, typename V, class RecManager>
+int citrustree<K, V, RecManager>::rangeQueryAggregate(
+    const int tid, const K& lo, const K& hi, RQAggregate<K>& aggregate) {
+  block<node_t<K, V> > stack(NULL);
+  block<node_t<K, V> > bounds(NULL);
+  const long long count_before = aggregate.count;
+  recordmgr->leaveQuiescentState(tid, true);
+  const camera_snapshot_t snapshot = rqProvider->traversal_start(tid);
+
+  // same traversal as rangeQuery
+  stack.push(root);
+  bounds.push(root);
+  while (!stack.isEmpty()) {
+    nodeptr node = stack.pop();
+    nodeptr bound = bounds.pop();
+    if (bound == root || bound->key < node->key) {
+      rqProvider->traversal_try_add(tid, node, aggregate, lo, hi, snapshot);
+    }
+    nodeptr left = rqProvider->read_vcas(tid, node->child[0], snapshot);
+    nodeptr right = rqProvider->read_vcas(tid, node->child[1], snapshot);
+    if (left != NULL && lo < node->key) {
+      stack.push(left);
+      bounds.push(bound);
+    }
+    if (right != NULL && hi > node->key) {
+      stack.push(right);
+      bounds.push(node);
+    }
+  }
+  rqProvider->traversal_end(tid, snapshot);
+  recordmgr->enterQuiescentState(tid);
+  return aggregate.count - count_before;
+}
+
 template <typename K, typename V, class RecManager>
 long long citrustree<K, V, RecManager>::debugKeySum(nodeptr root) {
   if (root == NULL) return 0;
@@ -15,6 +15,7 @@
 
 #define NVCAS_OPTIMIZATION
 #include "rq_provider.h"
+#include "rq_cursor.h"
 #include "vcas_lazylist_impl.h"
 
 namespace vcas_lazylist {
@@ -60,6 +61,9 @@ class lazylist {
   V erase(const int tid, const K &key);
   int rangeQuery(const int tid, const K &lo, const K &hi, K *const resultKeys,
                  V *const resultValues);
+  template <typename Visitor>
+  int rangeQueryVisit(const int tid, const K &lo, const K &hi,
+                      Visitor &visitor);
 
   /**
    * This function must be called once by each thread that will
@@ -105,7 +109,8 @@ class lazylist {
 
   //+ Integrate timestamp for vCAS
   inline int getKeys(const int tid, node_t<K, V> *node, K *const outputKeys,
-                     V *const outputValues, int ts) {
+                     V *const outputValues,
+                     const camera_snapshot_t &snapshot) {
     // ignore marked
     outputKeys[0] = node->key;
     outputValues[0] = node->val;
@@ -115,6 +120,12 @@ class lazylist {
   bool isInRange(const K &key, const K &lo, const K &hi) {
     return (lo <= key && key <= hi);
   }
+
+  // Retires the vCAS objects of a node that is being retired.
+  inline void retireVersions(const int tid, node_t<K, V> *node) {
+    rqProvider->retire_vcas(tid, node->marked);
+    rqProvider->retire_vcas(tid, node->next);
+  }
   inline bool isLogicallyDeleted(const int tid, node_t<K, V> *node);
 
   inline bool isLogicallyInserted(const int tid, node_t<K, V> *node) {
@@ -124,9 +124,9 @@ nodeptr lazylist<K, V, RecManager>::new_node(const int tid, const K &key,
   rqProvider->init_node(tid, nnode);
   nnode->key = key;
   nnode->val = val;
-  nnode->marked = new vcas_obj_t<long long>(0LL, nullptr);
+  nnode->marked = rqProvider->template new_vcas<long long>(tid, 0LL, nullptr);
   rqProvider->write_vcas(tid, nnode->marked, 0LL);
-  nnode->next = new vcas_obj_t<nodeptr>(nullptr, nullptr);
+  nnode->next = rqProvider->template new_vcas<nodeptr>(tid, nullptr, nullptr);
   rqProvider->write_vcas(tid, nnode->next, next);
   nnode->lock = false;
 #ifdef __HANDLE_STATS
@@ -269,6 +269,10 @@ V lazylist<K, V, RecManager>::erase(const int tid, const K &key) {
 
       rqProvider->announce_physical_deletion(tid, deletedNodes);
       rqProvider->cas_vcas(tid, &pred->next, curr, c_nxt);
+#if defined USE_RQ_DEBUGGING
+      // range queries follow next pointers, so the unlink is what they see
+      DEBUG_RECORD_UPDATE_KEY(tid, pred->next->ts, key, -1);
+#endif
       rqProvider->physical_deletion_succeeded(tid, deletedNodes);
 
       releaseLock(&(curr->lock));
@@ -287,28 +291,54 @@ int lazylist<K, V, RecManager>::rangeQuery(const int tid, const K &lo,
                                            const K &hi, K *const resultKeys,
                                            V *const resultValues) {
   recordmgr->leaveQuiescentState(tid, true);
-  int ts = rqProvider->traversal_start(tid);
+  const camera_snapshot_t snapshot = rqProvider->traversal_start(tid);
   int cnt = 0;
   nodeptr prev;
-  nodeptr curr = rqProvider->read_vcas(tid, head->next, ts);
+  nodeptr curr = rqProvider->read_vcas(tid, head->next, snapshot);
   while (curr->key < lo) {
     nodeptr tmp = curr;
-    curr = rqProvider->read_vcas(tid, curr->next, ts);
+    curr = rqProvider->read_vcas(tid, curr->next, snapshot);
     prev = tmp;
   }
   while (curr->key <= hi) {
     __builtin_prefetch(curr->next);
-    if (rqProvider->read_vcas(tid, head->marked, ts) == 0) {
+    if (rqProvider->read_vcas(tid, head->marked, snapshot) == 0) {
       rqProvider->traversal_try_add(tid, curr, resultKeys, resultValues, &cnt,
-                                    lo, hi, ts);
+                                    lo, hi, snapshot);
     }
-    curr = rqProvider->read_vcas(tid, curr->next, ts);
+    curr = rqProvider->read_vcas(tid, curr->next, snapshot);
   }
-  rqProvider->traversal_end(tid, resultKeys, resultValues, &cnt, lo, hi);
+  rqProvider->traversal_end(tid, snapshot, resultKeys, resultValues, &cnt, lo,
+                            hi);
   recordmgr->enterQuiescentState(tid);
   return cnt;
 }
 
+template <typename K, typename V, class RecManager>
+template <typename Visitor>
+int lazylist<K, V, RecManager>::rangeQueryVisit(const int tid, const K &lo,
+                                                const K &hi, Visitor &visitor) {
+  RQCursor<K, V, Visitor> cursor(visitor);
+  recordmgr->leaveQuiescentState(tid, true);
+  const camera_snapshot_t snapshot = rqProvider->traversal_start(tid);
+  nodeptr curr = rqProvider->read_vcas(tid, head->next, snapshot);
+  while (curr->key < lo) {
+    curr = rqProvider->read_vcas(tid, curr->next, snapshot);
+  }
+  while (curr->key <= hi) {
+    __builtin_prefetch(curr->next);
+    int cnt = 0;
+    rqProvider->traversal_try_add(tid, curr, cursor.keys(), cursor.values(),
+                                  &cnt, lo, hi, snapshot);
+    if (!cursor.add(cnt)) break;
+    curr = rqProvider->read_vcas(tid, curr->next, snapshot);
+  }
+  cursor.flush();
+  rqProvider->traversal_end(tid, snapshot);
+  recordmgr->enterQuiescentState(tid);
+  return cursor.visited();
+}
+
 template <typename K, typename V, class RecManager>
 long long lazylist<K, V, RecManager>::debugKeySum(nodeptr head) {
   long long result = 0;
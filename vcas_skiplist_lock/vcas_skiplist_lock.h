@@ -6,8 +6,10 @@
 #define MAX_NODES_INSERTED_OR_DELETED_ATOMICALLY 4
 #endif
 #include "rq_provider.h"
+#include "rq_cursor.h"
 #include "random.h"
 #include "plaf.h"
+#include "multiget.h"
 
 namespace vcas_skiplist_lock {
 using namespace std;
@@ -48,10 +50,20 @@ class node_t {
       // node_t<K, V>* volatile p_next[SKIPLIST_MAX_LEVEL];
       vcas_obj_t<long long>* volatile marked;
       vcas_obj_t<long long>* volatile fullyLinked;
+      // Must be last: a node only has room for p_next[0..topLevel].
       vcas_obj_t<node_t<K, V>*>* volatile p_next[SKIPLIST_MAX_LEVEL];
     };
   };
 
+  // Size of a node with p_next[0..topLevel]. About half of all nodes have
+  // topLevel 0, so this is much less than sizeof(node_t).
+  static size_t sizeOf(const int topLevel) {
+    return sizeof(node_t<K, V>) -
+           (SKIPLIST_MAX_LEVEL - 1 - topLevel) * sizeof(p_next[0]);
+  }
+  // Lets recordmgr pools recycle nodes by size class (see pool_interface.h).
+  size_t recordSize() const { return sizeOf(topLevel); }
+
   template <typename RQProvider>
   bool isMarked(const int tid, RQProvider* const prov) {
     return (prov->read_vcas(tid, &marked) == 1);
@@ -79,7 +91,7 @@ class skiplist {
   debugCounters* const counters;
 #endif
 
-  nodeptr allocateNode(const int tid);
+  nodeptr allocateNode(const int tid, const int height);
 
   void initNode(const int tid, nodeptr p_node, K key, V value, int height);
   int find_impl(const int tid, K key, nodeptr* p_preds, nodeptr* p_succs,
@@ -102,6 +114,11 @@ class skiplist {
 
   bool contains(const int tid, K key);
   const pair<V, bool> find(const int tid, const K& key);
+  // looks up keys[0..n-1] with interleaved traversals (see multiget.h);
+  // values[i] is NO_VALUE if keys[i] is absent. returns the number of keys
+  // found.
+  int multiGet(const int tid, const K* const keys, const int n,
+               V* const values);
   V insert(const int tid, const K& key, const V& value) {
     return doInsert(tid, key, value, false);
   }
@@ -111,6 +128,9 @@ class skiplist {
   V erase(const int tid, const K& key);
   int rangeQuery(const int tid, const K& lo, const K& hi, K* const resultKeys,
                  V* const resultValues);
+  template <typename Visitor>
+  int rangeQueryVisit(const int tid, const K& lo, const K& hi,
+                      Visitor& visitor);
 
   void initThread(const int tid);
   void deinitThread(const int tid);
@@ -149,7 +169,8 @@ class skiplist {
   RecManager* const debugGetRecMgr() { return recmgr; }
 
   inline int getKeys(const int tid, node_t<K, V>* node, K* const outputKeys,
-                     V* const outputValues, const int ts) {
+                     V* const outputValues,
+                     const camera_snapshot_t& snapshot) {
     outputKeys[0] = node->key;
     outputValues[0] = node->val;
     return 1;
@@ -159,6 +180,15 @@ class skiplist {
   bool isInRange(const K& key, const K& lo, const K& hi) {
     return (lo <= key && key <= hi);
   }
+
+  // Retires the vCAS objects of a node that is being retired.
+  inline void retireVersions(const int tid, node_t<K, V>* node) {
+    rqProvider->retire_vcas(tid, node->marked);
+    rqProvider->retire_vcas(tid, node->fullyLinked);
+    for (int level = 0; level <= node->topLevel; ++level) {
+      rqProvider->retire_vcas(tid, node->p_next[level]);
+    }
+  }
   inline bool isLogicallyDeleted(const int tid, node_t<K, V>* node) {
     return (rqProvider->read_vcas(tid, node->marked));
   }
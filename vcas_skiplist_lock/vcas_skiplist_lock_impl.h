@@ -82,18 +82,22 @@ void skiplist<K, V, RecordMgr>::initNode(const int tid, nodeptr p_node, K key,
   p_node->lock = 0;
 
   // Allocate initial vcas objects, but leave as TBD
-  p_node->marked = new vcas_obj_t<long long>(0, nullptr);
+  p_node->marked = rqProvider->template new_vcas<long long>(tid, 0, nullptr);
   rqProvider->write_vcas(tid, p_node->marked, 0ll);
-  p_node->fullyLinked = new vcas_obj_t<long long>(0, nullptr);
+  p_node->fullyLinked =
+      rqProvider->template new_vcas<long long>(tid, 0, nullptr);
   rqProvider->write_vcas(tid, p_node->fullyLinked, 0ll);
   for (int level = 0; level <= height; ++level) {
-    p_node->p_next[level] = new vcas_obj_t<nodeptr>(nullptr, nullptr);
+    p_node->p_next[level] =
+        rqProvider->template new_vcas<nodeptr>(tid, nullptr, nullptr);
   }
 }
 
 template <typename K, typename V, class RecordMgr>
-nodeptr skiplist<K, V, RecordMgr>::allocateNode(const int tid) {
-  nodeptr nnode = recmgr->template allocate<node_t<K, V> >(tid);
+nodeptr skiplist<K, V, RecordMgr>::allocateNode(const int tid,
+                                                const int height) {
+  nodeptr nnode = recmgr->template allocate<node_t<K, V> >(
+      tid, node_t<K, V>::sizeOf(height));
   if (nnode == NULL) {
     cout << "ERROR: out of memory" << endl;
     exit(-1);
@@ -153,10 +157,10 @@ skiplist<K, V, RecManager>::skiplist(const int numProcesses, const K _KEY_MIN,
   const int dummyTid = 0;
   recmgr->initThread(dummyTid);
 
-  p_head = allocateNode(dummyTid);
+  p_head = allocateNode(dummyTid, SKIPLIST_MAX_LEVEL - 1);
   initNode(dummyTid, p_head, KEY_MIN, NO_VALUE, SKIPLIST_MAX_LEVEL - 1);
 
-  p_tail = allocateNode(dummyTid);
+  p_tail = allocateNode(dummyTid, SKIPLIST_MAX_LEVEL - 1);
   initNode(dummyTid, p_tail, KEY_MAX, NO_VALUE, SKIPLIST_MAX_LEVEL - 1);
 
   // Initialize next pointers.
@@ -259,6 +263,54 @@ const pair<V, bool> skiplist<K, V, RecManager>::find(const int tid,
   }
 }
 
+template <typename K, typename V, class RecManager>
+int skiplist<K, V, RecManager>::multiGet(const int tid, const K* const keys,
+                                         const int n, V* const values) {
+  int idx[MULTIGET_GROUP_SIZE];
+  int level[MULTIGET_GROUP_SIZE];
+  nodeptr p_pred[MULTIGET_GROUP_SIZE];
+  nodeptr p_curr[MULTIGET_GROUP_SIZE];
+  int found = 0;
+  auto start = [&](const int s, const int i) {
+    idx[s] = i;
+    level[s] = SKIPLIST_MAX_LEVEL - 1;
+    p_pred[s] = p_head;
+    p_curr[s] = rqProvider->read_vcas(tid, p_head->p_next[level[s]]);
+    MULTIGET_PREFETCH(p_curr[s]);
+  };
+  // Same path as find_impl, but a lookup stops at the highest level where it
+  // sees its key, which is the node find() checks.
+  auto step = [&](const int s) {
+    const K& key = keys[idx[s]];
+    nodeptr p_node = p_curr[s];
+    if (key > p_node->key) {
+      p_pred[s] = p_node;
+      p_curr[s] = rqProvider->read_vcas(tid, p_node->p_next[level[s]]);
+    } else if (key == p_node->key) {
+      const bool res = rqProvider->read_vcas(tid, p_node->fullyLinked) &&
+                       !rqProvider->read_vcas(tid, p_node->marked);
+#ifdef RQ_SNAPCOLLECTOR
+      rqProvider->search_report_target_key(tid, key, p_node);
+#endif
+      values[idx[s]] = res ? p_node->val : NO_VALUE;
+      if (res) ++found;
+      return false;
+    } else if (level[s] == 0) {
+      values[idx[s]] = NO_VALUE;
+      return false;
+    } else {
+      --level[s];
+      p_curr[s] = rqProvider->read_vcas(tid, p_pred[s]->p_next[level[s]]);
+    }
+    MULTIGET_PREFETCH(p_curr[s]);
+    return true;
+  };
+  recmgr->leaveQuiescentState(tid, true);
+  multiget_run(n, start, step);
+  recmgr->enterQuiescentState(tid);
+  return found;
+}
+
 template <typename K, typename V, class RecManager>
 V skiplist<K, V, RecManager>::doInsert(const int tid, const K& key,
                                        const V& value, bool onlyIfAbsent) {
@@ -325,7 +377,7 @@ V skiplist<K, V, RecManager>::doInsert(const int tid, const K& key,
     }
 
     if (valid) {
-      p_new_node = allocateNode(tid);  // shmem_none->allocateNode(tid);
+      p_new_node = allocateNode(tid, topLevel);
 #ifdef __HANDLE_STATS
       GSTATS_APPEND(tid, node_allocated_addresses,
                     ((long long)p_new_node) % (1 << 12));
@@ -431,6 +483,10 @@ V skiplist<K, V, RecManager>::erase(const int tid, const K& key) {
         SOFTWARE_BARRIER;
         rqProvider->cas_vcas(tid, &p_victim->marked, 0ll, 1ll);
         // p_victim->marked = 1;
+#if defined USE_RQ_DEBUGGING
+        // find and range queries stop seeing the key once it is marked
+        DEBUG_RECORD_UPDATE_KEY(tid, p_victim->marked->ts, key, -1);
+#endif
 
         nodeptr insertedNodes[] = {NULL};
         nodeptr deletedNodes[] = {p_victim, NULL};
@@ -481,7 +537,7 @@ int skiplist<K, V, RecManager>::rangeQuery(const int tid, const K& lo,
                                            V* const resultValues) {
   //    cout<<"rangeQuery(lo="<<lo<<" hi="<<hi<<")"<<endl;
   recmgr->leaveQuiescentState(tid, true);
-  int ts = rqProvider->traversal_start(tid);
+  const camera_snapshot_t snapshot = rqProvider->traversal_start(tid);
   int cnt = 0;
   // use the find function to find the low key
   //    int nodesSkipped = 0;
@@ -489,23 +545,29 @@ int skiplist<K, V, RecManager>::rangeQuery(const int tid, const K& lo,
   nodeptr pred = p_head;
   nodeptr curr = NULL;
   for (int level = SKIPLIST_MAX_LEVEL - 1; level >= 0; level--) {
-    curr = rqProvider->read_vcas(tid, pred->p_next[level]);
+    curr = rqProvider->read_vcas(tid, pred->p_next[level], snapshot);
     while (curr->key < lo) {
       pred = curr;
-      curr = rqProvider->read_vcas(tid, pred->p_next[level]);
+      curr = rqProvider->read_vcas(tid, pred->p_next[level], snapshot);
       //            nodesSkipped++;
     }
   }
   // continue until we pass the high key
   while (curr->key <= hi) {
-    rqProvider->traversal_try_add(tid, curr, resultKeys, resultValues, &cnt, lo,
-                                  hi, ts);
-    curr = rqProvider->read_vcas(tid, curr->p_next[0]);
+    // as in find, a node holds its key once it is fully linked and until it
+    // is marked
+    if (rqProvider->read_vcas(tid, curr->fullyLinked, snapshot) &&
+        !rqProvider->read_vcas(tid, curr->marked, snapshot)) {
+      rqProvider->traversal_try_add(tid, curr, resultKeys, resultValues, &cnt,
+                                    lo, hi, snapshot);
+    }
+    curr = rqProvider->read_vcas(tid, curr->p_next[0], snapshot);
     //        nodesVisited++;
   }
   //    cout<<"BEFORE END: rqSize="<<cnt<<" nodesSkipped="<<nodesSkipped<<"
   //    nodesVisited="<<nodesVisited<<endl;
-  rqProvider->traversal_end(tid, resultKeys, resultValues, &cnt, lo, hi);
+  rqProvider->traversal_end(tid, snapshot, resultKeys, resultValues, &cnt, lo,
+                            hi);
 #ifdef SNAPCOLLECTOR_PRINT_RQS
   cout << "rqSize=" << cnt << endl;
 #endif
@@ -515,5 +577,39 @@ int skiplist<K, V, RecManager>::rangeQuery(const int tid, const K& lo,
   recmgr->enterQuiescentState(tid);
   return cnt;
 }
+
+template <typename K, typename V, class RecManager>
+template <typename Visitor>
+int skiplist<K, V, RecManager>::rangeQueryVisit(const int tid, const K& lo,
+                                                const K& hi, Visitor& visitor) {
+  RQCursor<K, V, Visitor> cursor(visitor);
+  recmgr->leaveQuiescentState(tid, true);
+  const camera_snapshot_t snapshot = rqProvider->traversal_start(tid);
+  // use the find function to find the low key
+  nodeptr pred = p_head;
+  nodeptr curr = NULL;
+  for (int level = SKIPLIST_MAX_LEVEL - 1; level >= 0; level--) {
+    curr = rqProvider->read_vcas(tid, pred->p_next[level], snapshot);
+    while (curr->key < lo) {
+      pred = curr;
+      curr = rqProvider->read_vcas(tid, pred->p_next[level], snapshot);
+    }
+  }
+  // continue until we pass the high key or the visitor stops us
+  while (curr->key <= hi) {
+    int cnt = 0;
+    if (rqProvider->read_vcas(tid, curr->fullyLinked, snapshot) &&
+        !rqProvider->read_vcas(tid, curr->marked, snapshot)) {
+      rqProvider->traversal_try_add(tid, curr, cursor.keys(), cursor.values(),
+                                    &cnt, lo, hi, snapshot);
+    }
+    if (!cursor.add(cnt)) break;
+    curr = rqProvider->read_vcas(tid, curr->p_next[0], snapshot);
+  }
+  cursor.flush();
+  rqProvider->traversal_end(tid, snapshot);
+  recmgr->enterQuiescentState(tid);
+  return cursor.visited();
+}
 }  // namespace vcas_skiplist_lock
 #endif /* SKIPLIST_LOCK_IMPL_H */